@@ -0,0 +1,289 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <regex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+const double  DEFAULT_MIN_TIME = 0.5;     // seconds a reported run has to last
+const int64_t MAX_ITERATIONS = 1000000000;
+
+struct BenchmarkResult
+{
+    std::string name;
+    int64_t     iterations;
+    double      real_ns;        // per iteration
+    double      cpu_ns;
+    double      items_per_second;
+    double      bytes_per_second;
+    std::string label;
+    std::string error;
+};
+
+static std::vector<Benchmark*>& get_registry()
+{
+    // Built on first use, since registration happens during static initialisation
+    static std::vector<Benchmark*> registry;
+    return registry;
+}
+
+static std::vector<std::pair<std::string, std::string>>& get_context()
+{
+    static std::vector<std::pair<std::string, std::string>> context;
+    return context;
+}
+
+static double cpu_seconds()
+{
+    return (double) std::clock() / CLOCKS_PER_SEC;
+}
+
+// ————— STATE ————— //
+
+void BenchmarkState::start_timer()
+{
+    m_real_start = Clock::now();
+    m_cpu_start = cpu_seconds();
+}
+
+void BenchmarkState::stop_timer()
+{
+    m_real_elapsed += Clock::now() - m_real_start;
+    m_cpu_elapsed += cpu_seconds() - m_cpu_start;
+}
+
+bool BenchmarkState::keep_running()
+{
+    if (!m_started)
+    {
+        m_started = true;
+        start_timer();
+    }
+    if (m_remaining-- > 0) return true;
+
+    if (!m_paused) stop_timer();
+    m_paused = true;
+    return false;
+}
+
+void BenchmarkState::pause_timing()
+{
+    if (m_paused) return;
+    stop_timer();
+    m_paused = true;
+}
+
+void BenchmarkState::resume_timing()
+{
+    if (!m_paused) return;
+    m_paused = false;
+    start_timer();
+}
+
+void BenchmarkState::skip_with_error(const std::string& message)
+{
+    m_error = message;
+    m_remaining = 0;
+    m_paused = true;
+}
+
+// ————— REGISTRY ————— //
+
+Benchmark* register_benchmark(const char* name, BenchmarkFunction function)
+{
+    Benchmark* benchmark = new Benchmark(name, function);
+    get_registry().push_back(benchmark);
+    return benchmark;
+}
+
+void add_benchmark_context(const char* key, const std::string& value)
+{
+    get_context().push_back(std::make_pair(std::string(key), value));
+}
+
+// ————— RUNNING ————— //
+
+static BenchmarkResult run_one(const std::string& name, BenchmarkFunction function, int64_t arg, double min_time)
+{
+    BenchmarkResult result;
+    result.name = name;
+
+    int64_t iterations = 1;
+    while (true)
+    {
+        BenchmarkState state(iterations, arg);
+        function(state);
+
+        double seconds = state.get_real_seconds();
+        if (!state.get_error().empty() || seconds >= min_time || iterations >= MAX_ITERATIONS)
+        {
+            result.iterations = iterations;
+            result.real_ns = seconds * 1e9 / iterations;
+            result.cpu_ns = state.get_cpu_seconds() * 1e9 / iterations;
+            result.items_per_second = seconds > 0.0 ? state.get_items() / seconds : 0.0;
+            result.bytes_per_second = seconds > 0.0 ? state.get_bytes() / seconds : 0.0;
+            result.label = state.get_label();
+            result.error = state.get_error();
+            return result;
+        }
+
+        // Aim a little past the minimum, but never grow more than tenfold off a run
+        // too short to go by
+        double multiplier = seconds / min_time > 0.1 ? min_time * 1.4 / seconds : 10.0;
+        iterations = std::min(MAX_ITERATIONS, std::max(iterations + 1, (int64_t) (iterations * multiplier)));
+    }
+}
+
+static void print_result(const BenchmarkResult& result)
+{
+    char line[256];
+    if (!result.error.empty())
+    {
+        snprintf(line, sizeof(line), "%-40s ERROR: %s", result.name.c_str(), result.error.c_str());
+        std::cout << line << std::endl;
+        return;
+    }
+
+    snprintf(line, sizeof(line), "%-40s %14.0f ns %14.0f ns %12lld", result.name.c_str(), result.real_ns, result.cpu_ns, (long long) result.iterations);
+    std::cout << line;
+    if (result.items_per_second > 0.0)
+    {
+        snprintf(line, sizeof(line), "  %.4g items/s", result.items_per_second);
+        std::cout << line;
+    }
+    if (result.bytes_per_second > 0.0)
+    {
+        snprintf(line, sizeof(line), "  %.4g MiB/s", result.bytes_per_second / (1024.0 * 1024.0));
+        std::cout << line;
+    }
+    if (!result.label.empty()) std::cout << "  " << result.label;
+    std::cout << std::endl;
+}
+
+static void write_json_string(FILE* file, const std::string& text)
+{
+    fputc('"', file);
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\') fputc('\\', file);
+        if ((unsigned char) c >= ' ') fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+static bool write_json(const char* path, const char* executable, const std::vector<BenchmarkResult>& results)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        std::cout << "Unable to write benchmark results to " << path << std::endl;
+        return false;
+    }
+
+    char date[64];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    fprintf(file, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"executable\": ", date);
+    write_json_string(file, executable);
+    fprintf(file, ",\n    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    fprintf(file, "    \"library_build_type\": \"release\"");
+#else
+    fprintf(file, "    \"library_build_type\": \"debug\"");
+#endif
+    for (const auto& entry : get_context())
+    {
+        fprintf(file, ",\n    ");
+        write_json_string(file, entry.first);
+        fprintf(file, ": ");
+        write_json_string(file, entry.second);
+    }
+    fprintf(file, "\n  },\n  \"benchmarks\": [");
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& result = results[i];
+        fprintf(file, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        write_json_string(file, result.name);
+        fprintf(file, ", \"run_name\": ");
+        write_json_string(file, result.name);
+        fprintf(file, ", \"run_type\": \"iteration\"");
+
+        if (!result.error.empty())
+        {
+            fprintf(file, ", \"error_occurred\": true, \"error_message\": ");
+            write_json_string(file, result.error);
+            fprintf(file, "}");
+            continue;
+        }
+
+        fprintf(file, ", \"iterations\": %lld, \"real_time\": %.3f, \"cpu_time\": %.3f, \"time_unit\": \"ns\"",
+            (long long) result.iterations, result.real_ns, result.cpu_ns);
+        if (result.items_per_second > 0.0) fprintf(file, ", \"items_per_second\": %.6g", result.items_per_second);
+        if (result.bytes_per_second > 0.0) fprintf(file, ", \"bytes_per_second\": %.6g", result.bytes_per_second);
+        if (!result.label.empty())
+        {
+            fprintf(file, ", \"label\": ");
+            write_json_string(file, result.label);
+        }
+        fprintf(file, "}");
+    }
+
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+int run_benchmarks(int argc, char* argv[])
+{
+    const char* filter = ".";
+    const char* json_path = NULL;
+    double min_time = DEFAULT_MIN_TIME;
+
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0) filter = argv[i + 1];
+        if (strcmp(argv[i], "--min-time") == 0) min_time = atof(argv[i + 1]);
+        if (strcmp(argv[i], "--json") == 0) json_path = argv[i + 1];
+    }
+
+    std::regex pattern;
+    try
+    {
+        pattern = std::regex(filter);
+    }
+    catch (const std::regex_error&)
+    {
+        std::cout << "Invalid --filter " << filter << std::endl;
+        return 1;
+    }
+
+    char header[256];
+    snprintf(header, sizeof(header), "%-40s %17s %17s %12s", "Benchmark", "Time", "CPU", "Iterations");
+    std::cout << header << '\n' << std::string(strlen(header), '-') << std::endl;
+
+    std::vector<BenchmarkResult> results;
+    for (Benchmark* benchmark : get_registry())
+    {
+        std::vector<int64_t> args = benchmark->get_args();
+        bool has_args = !args.empty();
+        if (!has_args) args.push_back(0);
+
+        for (int64_t arg : args)
+        {
+            std::string name = benchmark->get_name();
+            if (has_args) name += "/" + std::to_string(arg);
+            if (!std::regex_search(name, pattern)) continue;
+
+            results.push_back(run_one(name, benchmark->get_function(), arg, min_time));
+            print_result(results.back());
+        }
+    }
+
+    if (json_path != NULL && !write_json(json_path, argv[0], results)) return 1;
+    return 0;
+}
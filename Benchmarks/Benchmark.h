@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// A small stand-in for Google Benchmark, so the suite builds with nothing but
+// the game's own dependencies. Everything before the first keep_running()
+// call is setup and isn't timed:
+//
+//     static void map_build(BenchmarkState& state)
+//     {
+//         std::vector<unsigned int> level = ...;
+//         while (state.keep_running()) Map map(...);
+//         state.set_items_processed(state.get_iterations() * tiles);
+//     }
+//     BENCHMARK(map_build)->arg(64)->arg(4096);
+//
+// The runner repeats each benchmark with more iterations until a run lasts
+// --min-time seconds, then reports that run. --json FILE writes the results
+// in Google Benchmark's JSON layout, so its compare.py can diff two builds.
+
+class BenchmarkState
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    int64_t m_iterations;
+    int64_t m_remaining;
+    int64_t m_arg;
+    bool    m_started = false;
+    bool    m_paused = false;
+
+    Clock::time_point m_real_start;
+    Clock::duration   m_real_elapsed = Clock::duration::zero();
+    double m_cpu_start = 0.0;
+    double m_cpu_elapsed = 0.0;
+
+    int64_t m_items = 0;
+    int64_t m_bytes = 0;
+    std::string m_label;
+    std::string m_error;
+
+    void start_timer();
+    void stop_timer();
+
+public:
+    BenchmarkState(int64_t iterations, int64_t arg) : m_iterations(iterations), m_remaining(iterations), m_arg(arg) {};
+
+    // True for each of the run's iterations; the timer runs from the first
+    // call to the last
+    bool keep_running();
+    // Around per-iteration work that shouldn't count, like waiting for the GPU
+    void pause_timing();
+    void resume_timing();
+
+    // Totals for the whole run, not per iteration
+    void set_items_processed(int64_t items) { m_items = items; };
+    void set_bytes_processed(int64_t bytes) { m_bytes = bytes; };
+    void set_label(const std::string& label) { m_label = label; };
+    // Ends the benchmark with nothing timed; return straight after calling it
+    void skip_with_error(const std::string& message);
+
+    int64_t const get_arg()        const { return m_arg; };
+    int64_t const get_iterations() const { return m_iterations; };
+    double  const get_real_seconds() const { return std::chrono::duration<double>(m_real_elapsed).count(); };
+    double  const get_cpu_seconds()  const { return m_cpu_elapsed; };
+    int64_t const get_items() const { return m_items; };
+    int64_t const get_bytes() const { return m_bytes; };
+    const std::string& get_label() const { return m_label; };
+    const std::string& get_error() const { return m_error; };
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState& state);
+
+class Benchmark
+{
+private:
+    std::string          m_name;
+    BenchmarkFunction    m_function;
+    std::vector<int64_t> m_args;
+
+public:
+    Benchmark(const char* name, BenchmarkFunction function) : m_name(name), m_function(function) {};
+
+    // Runs the benchmark once more with get_arg() returning `value`
+    Benchmark* arg(int64_t value) { m_args.push_back(value); return this; };
+
+    const std::string& get_name() const { return m_name; };
+    BenchmarkFunction const get_function() const { return m_function; };
+    const std::vector<int64_t>& get_args() const { return m_args; };
+};
+
+Benchmark* register_benchmark(const char* name, BenchmarkFunction function);
+// Extra lines for the "context" block of the JSON, like the GL renderer
+void add_benchmark_context(const char* key, const std::string& value);
+// Parses --filter REGEX, --min-time SECONDS and --json FILE, then runs every
+// registered benchmark whose name matches. Benchmarks that skip with an
+// error are reported as such but don't fail the run.
+int run_benchmarks(int argc, char* argv[]);
+
+#define BENCHMARK_CONCAT_INNER(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_INNER(a, b)
+#define BENCHMARK(function) static Benchmark* BENCHMARK_CONCAT(benchmark_, __LINE__) = register_benchmark(#function, function)
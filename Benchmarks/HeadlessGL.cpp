@@ -0,0 +1,51 @@
+#include "HeadlessGL.h"
+#include "Benchmark.h"
+#include <iostream>
+
+static SDL_Window*   g_window = NULL;
+static SDL_GLContext g_context = NULL;
+
+bool headless_gl_start(int major, int minor, bool core)
+{
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+    {
+        std::cout << "No headless video driver: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, major);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, minor);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, core ? SDL_GL_CONTEXT_PROFILE_CORE : SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
+
+    g_window = SDL_CreateWindow("Benchmarks", 0, 0, HEADLESS_GL_WIDTH, HEADLESS_GL_HEIGHT, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (g_window != NULL) g_context = SDL_GL_CreateContext(g_window);
+    if (g_context == NULL)
+    {
+        std::cout << "No headless GL " << major << "." << minor << " context: " << SDL_GetError() << std::endl;
+        headless_gl_stop();
+        return false;
+    }
+
+    SDL_GL_MakeCurrent(g_window, g_context);
+    SDL_GL_SetSwapInterval(0);
+    glViewport(0, 0, HEADLESS_GL_WIDTH, HEADLESS_GL_HEIGHT);
+
+    add_benchmark_context("gl_version", (const char*) glGetString(GL_VERSION));
+    add_benchmark_context("gl_renderer", (const char*) glGetString(GL_RENDERER));
+    return true;
+}
+
+void headless_gl_stop()
+{
+    if (g_context != NULL) SDL_GL_DeleteContext(g_context);
+    if (g_window != NULL) SDL_DestroyWindow(g_window);
+    g_context = NULL;
+    g_window = NULL;
+    SDL_Quit();
+}
+
+bool headless_gl_is_running()
+{
+    return g_context != NULL;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+const int HEADLESS_GL_WIDTH = 1280;
+const int HEADLESS_GL_HEIGHT = 960;
+
+// A GL context with nothing on screen, for benchmarks that go through the
+// render path. SDL's offscreen video driver creates it through EGL, so it
+// also works on a machine with no display or GPU, where Mesa's llvmpipe does
+// the drawing. Set SDL_VIDEODRIVER to use another driver.
+bool headless_gl_start(int major, int minor, bool core);
+void headless_gl_stop();
+bool headless_gl_is_running();
@@ -0,0 +1,230 @@
+// Pong: the ball pool's simulation step, the rollback simulation, and the two
+// ways a field of balls goes to the GPU (streamed batches and instancing).
+
+#include "Benchmark.h"
+#include "HeadlessGL.h"
+#include "BallPool.h"
+#include "CommandList.h"
+#include "InstancedRenderer.h"
+#include "PongState.h"
+#include "RenderBackend.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <math.h>
+
+// The game's arena, see Pong_Clone/main.cpp
+const float BALL_SIZE = 100.0f / 200.0f;
+const float STEP = 1.0f / 120.0f;
+const size_t STREAM_BUFFER_BYTES = 1 << 20;
+const int BALL_TEXTURE_SIZE = 64;
+
+const char V_SHADER_PATH[] = "../Pong_Clone/shaders/vertex_textured.glsl",
+F_SHADER_PATH[] = "../Pong_Clone/shaders/fragment_textured.glsl";
+const char V_INSTANCED_SHADER_PATH[] = "../Pong_Clone/shaders/vertex_instanced.glsl",
+F_INSTANCED_SHADER_PATH[] = "../Pong_Clone/shaders/fragment_instanced.glsl";
+
+static unsigned int next_random(unsigned int& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static float random_unit(unsigned int& state)
+{
+    return (next_random(state) & 0xFFFFFF) / (float) 0xFFFFFF;
+}
+
+// ————— SCENES ————— //
+
+// Stress mode's field: balls anywhere between the paddles, heading every way,
+// and put back in the middle when they leave so the count holds
+static void spawn_ball_field(BallPool& pool, int count)
+{
+    unsigned int random = 0x1B873593u;
+    pool.clear();
+    pool.set_respawn_exited(true);
+    for (int i = 0; i < count; i++)
+    {
+        float x = (random_unit(random) * 2.0f - 1.0f) * (PONG_EXIT_X - 1.0f);
+        float y = (random_unit(random) * 2.0f - 1.0f) * PONG_WALL_Y;
+        float angle = random_unit(random) * 6.2831853f;
+        pool.spawn(glm::vec3(x, y, 0.0f), glm::vec3(cos(angle), sin(angle), 0.0f) * 0.7f);
+    }
+}
+
+static BallPool make_pool()
+{
+    return BallPool(PONG_COLLISION_X, PONG_COLLISION_Y, PONG_WALL_Y, PONG_EXIT_X, BALL_SIZE);
+}
+
+// One flat texture standing in for the atlas page
+static AtlasRegion make_ball_region()
+{
+    AtlasRegion region;
+    std::vector<unsigned char> pixels(BALL_TEXTURE_SIZE * BALL_TEXTURE_SIZE * 4, 255);
+    glGenTextures(1, &region.texture_id);
+    g_gl_state.bind_texture(region.texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, BALL_TEXTURE_SIZE, BALL_TEXTURE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    region.pixel_width = region.pixel_height = BALL_TEXTURE_SIZE;
+    return region;
+}
+
+static glm::mat4 make_projection()
+{
+    return glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
+}
+
+// ————— SIMULATION ————— //
+
+static void ballpool_update(BenchmarkState& state)
+{
+    BallPool pool = make_pool();
+    spawn_ball_field(pool, (int) state.get_arg());
+    glm::vec3 paddle(-PONG_PADDLE_X, 0.0f, 0.0f), paddle2(PONG_PADDLE_X, 0.0f, 0.0f);
+
+    while (state.keep_running())
+    {
+        pool.save_previous();
+        pool.update(STEP, PONG_BALL_SPEED, paddle, paddle2);
+    }
+    state.set_items_processed(state.get_iterations() * state.get_arg());
+    state.set_label(std::to_string(pool.get_swept_count()) + " swept last step");
+}
+BENCHMARK(ballpool_update)->arg(1000)->arg(100000);
+
+// The fixed-size state rollback re-simulates, so this bounds how many frames a
+// rollback can afford
+static void pong_simulate_tick(BenchmarkState& state)
+{
+    PongState pong;
+    pong_reset(pong, (int) state.get_arg());
+    unsigned int random = 0x85EBCA6Bu;
+
+    while (state.keep_running())
+    {
+        PongInput input = (PongInput) (next_random(random) & 3);
+        pong_simulate(pong, input, input ^ 3, STEP);
+        if (pong.result != pongPlaying) pong_reset(pong, (int) state.get_arg());
+    }
+    state.set_items_processed(state.get_iterations());
+}
+BENCHMARK(pong_simulate_tick)->arg(1)->arg(MAX_PONG_BALLS);
+
+// ————— RENDER ————— //
+
+// The field as main.cpp draws it: recorded as one sprite command, then
+// executed by the GL backend
+static void record_balls(CommandList& list, const BallPool& pool, const AtlasRegion& region, const glm::mat4& projection)
+{
+    list.reset();
+    list.set_camera(glm::mat4(1.0f), projection);
+    pool.write_sprites(list.draw_sprites(region.texture_id, pool.get_count()), region, 45.0f, 1.0f);
+}
+
+// The batched path: every ball written to the stream buffer and drawn in one
+// call. The GPU is drained outside the timed part, so a real GPU's drawing
+// isn't counted; under llvmpipe the drawing shares the CPU and shows up anyway.
+static void ballpool_render_stream(BenchmarkState& state)
+{
+    if (!headless_gl_is_running())
+    {
+        state.skip_with_error("no GL context");
+        return;
+    }
+
+    BallPool pool = make_pool();
+    spawn_ball_field(pool, (int) state.get_arg());
+    pool.save_previous();
+
+    ShaderProgram program;
+    program.load(V_SHADER_PATH, F_SHADER_PATH);
+
+    StreamBuffer stream;
+    stream.create(STREAM_BUFFER_BYTES);
+    AtlasRegion region = make_ball_region();
+    glm::mat4 projection = make_projection();
+
+    // No instanced renderer, so the backend expands the sprites itself
+    GLRenderBackend backend(&program, NULL, &stream);
+    CommandList list;
+
+    while (state.keep_running())
+    {
+        record_balls(list, pool, region, projection);
+        backend.execute(list);
+        stream.end_frame();
+        state.pause_timing();
+        glFinish();
+        state.resume_timing();
+    }
+
+    state.set_items_processed(state.get_iterations() * state.get_arg());
+    state.set_bytes_processed(stream.get_bytes_streamed());
+    state.set_label(stream.is_persistent() ? "persistent" : "orphaned");
+    glDeleteTextures(1, &region.texture_id);
+    g_gl_state.forget();
+}
+BENCHMARK(ballpool_render_stream)->arg(1000)->arg(100000);
+
+static void ballpool_render_instanced(BenchmarkState& state)
+{
+    if (!headless_gl_is_running())
+    {
+        state.skip_with_error("no GL context");
+        return;
+    }
+
+    InstancedRenderer renderer;
+    renderer.load(V_INSTANCED_SHADER_PATH, F_INSTANCED_SHADER_PATH);
+    if (!renderer.is_supported())
+    {
+        state.skip_with_error("no GL 3.3 instancing");
+        return;
+    }
+
+    BallPool pool = make_pool();
+    spawn_ball_field(pool, (int) state.get_arg());
+    pool.save_previous();
+
+    ShaderProgram program;
+    program.load(V_SHADER_PATH, F_SHADER_PATH);
+
+    StreamBuffer stream;
+    stream.create(STREAM_BUFFER_BYTES);
+    AtlasRegion region = make_ball_region();
+    glm::mat4 projection = make_projection();
+
+    GLRenderBackend backend(&program, &renderer, &stream);
+    CommandList list;
+
+    while (state.keep_running())
+    {
+        record_balls(list, pool, region, projection);
+        backend.execute(list);
+        stream.end_frame();
+        state.pause_timing();
+        glFinish();
+        state.resume_timing();
+    }
+
+    state.set_items_processed(state.get_iterations() * state.get_arg());
+    state.set_bytes_processed(stream.get_bytes_streamed());
+    glDeleteTextures(1, &region.texture_id);
+    g_gl_state.forget();
+}
+BENCHMARK(ballpool_render_instanced)->arg(1000)->arg(100000);
+
+int main(int argc, char* argv[])
+{
+    // The game takes whatever context the platform hands out; asking for 2.1
+    // compatibility does the same and still gets 3.3+ where the driver has it
+    headless_gl_start(2, 1, false);
+    int result = run_benchmarks(argc, argv);
+    headless_gl_stop();
+    return result;
+}
@@ -0,0 +1,218 @@
+// Rise of the AI: tile map building, tile lookups, entity updates and
+// collision checks, and submitting a whole map through Map::render.
+
+#include "Benchmark.h"
+#include "HeadlessGL.h"
+#include "Map.h"
+#include "Entity.h"
+#include "ShaderProgram.h"
+#include "GLState.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+const float TILE_SIZE = 1.0f;
+const int   TILESET_COLUMNS = 4;
+const int   TILESET_ROWS = 1;
+const int   ENTITY_BOXES = 16;
+
+const char V_SHADER_PATH[] = "../Rise_of_the_AI/shaders/vertex_textured.glsl",
+F_SHADER_PATH[] = "../Rise_of_the_AI/shaders/fragment_textured.glsl";
+
+// xorshift32, so every run builds the same scenes
+static unsigned int next_random(unsigned int& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// ————— SCENES ————— //
+
+// A level the way the game lays them out: solid ground along the bottom and
+// floating platforms of 3 to 12 tiles every few rows, about an eighth of the
+// map solid in all
+static std::vector<unsigned int> generate_level(int width, int height)
+{
+    std::vector<unsigned int> level((size_t) width * height, 0);
+    unsigned int random = 0x9E3779B9u;
+
+    for (int y = height - 2; y < height; y++)
+    {
+        for (int x = 0; x < width; x++) level[(size_t) y * width + x] = 1;
+    }
+
+    for (int y = 2; y < height - 3; y += 4)
+    {
+        for (int x = 0; x < width;)
+        {
+            int gap = 2 + next_random(random) % 10;
+            int length = 3 + next_random(random) % 10;
+            unsigned int tile = 1 + next_random(random) % (TILESET_COLUMNS * TILESET_ROWS - 1);
+            for (int i = x + gap; i < x + gap + length && i < width; i++) level[(size_t) y * width + i] = tile;
+            x += gap + length;
+        }
+    }
+    return level;
+}
+
+// Points spread over the whole map, so lookups miss the cache the way a
+// scene full of entities would
+static std::vector<glm::vec3> generate_probes(int width, int height, int count)
+{
+    std::vector<glm::vec3> probes(count);
+    unsigned int random = 0x2545F491u;
+    for (glm::vec3& probe : probes)
+    {
+        float x = (next_random(random) % (width * 16)) / 16.0f;
+        float y = -((next_random(random) % (height * 16)) / 16.0f);
+        probe = glm::vec3(x, y, 0.0f);
+    }
+    return probes;
+}
+
+static std::vector<std::unique_ptr<Entity>> generate_entities(int count)
+{
+    std::vector<std::unique_ptr<Entity>> entities;
+    entities.reserve(count);
+    unsigned int random = 0x68E31DA4u;
+    for (int i = 0; i < count; i++)
+    {
+        Entity* entity = new Entity();
+        entity->set_position(glm::vec3((next_random(random) % 2000) / 100.0f - 10.0f, (next_random(random) % 1500) / 100.0f - 7.5f, 0.0f));
+        entity->set_acceleration(i % 2 == 0);
+        entities.emplace_back(entity);
+    }
+    return entities;
+}
+
+// ————— MAP ————— //
+
+static void map_build(BenchmarkState& state)
+{
+    int size = (int) state.get_arg();
+    std::vector<unsigned int> level = generate_level(size, size);
+
+    while (state.keep_running())
+    {
+        Map map(size, size, level.data(), 0, TILE_SIZE, TILESET_COLUMNS, TILESET_ROWS);
+    }
+    state.set_items_processed(state.get_iterations() * size * size);
+
+    // get_vertices() copies the whole array, so it stays out of the timed loop
+    Map map(size, size, level.data(), 0, TILE_SIZE, TILESET_COLUMNS, TILESET_ROWS);
+    state.set_label(std::to_string(map.get_vertices().size() / 12) + " solid tiles");
+}
+BENCHMARK(map_build)->arg(64)->arg(512)->arg(4096);
+
+static void map_is_solid(BenchmarkState& state)
+{
+    const int probe_count = 4096;
+    int size = (int) state.get_arg();
+    std::vector<unsigned int> level = generate_level(size, size);
+    Map map(size, size, level.data(), 0, TILE_SIZE, TILESET_COLUMNS, TILESET_ROWS);
+    std::vector<glm::vec3> probes = generate_probes(size, size, probe_count);
+
+    int64_t solid = 0;
+    while (state.keep_running())
+    {
+        for (const glm::vec3& probe : probes)
+        {
+            float penetration_x, penetration_y;
+            solid += map.is_solid(probe, &penetration_x, &penetration_y);
+        }
+    }
+    state.set_items_processed(state.get_iterations() * probe_count);
+    state.set_label(std::to_string(solid * 100 / std::max<int64_t>(1, state.get_iterations() * probe_count)) + "% solid");
+}
+BENCHMARK(map_is_solid)->arg(64)->arg(512)->arg(4096);
+
+// ————— ENTITIES ————— //
+
+static void entity_update(BenchmarkState& state)
+{
+    std::vector<std::unique_ptr<Entity>> entities = generate_entities((int) state.get_arg());
+
+    while (state.keep_running())
+    {
+        for (auto& entity : entities) entity->update(1.0f / 60.0f);
+    }
+    state.set_items_processed(state.get_iterations() * state.get_arg());
+}
+BENCHMARK(entity_update)->arg(1000)->arg(100000);
+
+static void entity_check_collision(BenchmarkState& state)
+{
+    std::vector<std::unique_ptr<Entity>> entities = generate_entities((int) state.get_arg());
+    glm::vec3 boxes[ENTITY_BOXES];
+    for (int i = 0; i < ENTITY_BOXES; i++) boxes[i] = glm::vec3(i - ENTITY_BOXES / 2.0f, -3.5f, 0.0f);
+
+    int64_t hits = 0;
+    while (state.keep_running())
+    {
+        for (auto& entity : entities)
+        {
+            for (const glm::vec3& box : boxes) hits += entity->check_collision(box);
+        }
+    }
+    state.set_items_processed(state.get_iterations() * state.get_arg() * ENTITY_BOXES);
+    state.set_label(std::to_string(hits / std::max<int64_t>(1, state.get_iterations())) + " hits");
+}
+BENCHMARK(entity_check_collision)->arg(1000)->arg(100000);
+
+// ————— RENDER ————— //
+
+// Every solid tile goes out in one client-array draw. The GPU is drained
+// outside the timed part, so this is the cost of submitting, not of drawing.
+static void map_render(BenchmarkState& state)
+{
+    if (!headless_gl_is_running())
+    {
+        state.skip_with_error("no GL context");
+        return;
+    }
+
+    int size = (int) state.get_arg();
+    std::vector<unsigned int> level = generate_level(size, size);
+
+    GLuint texture_id;
+    unsigned char pixels[TILESET_COLUMNS * 4] = {};
+    glGenTextures(1, &texture_id);
+    g_gl_state.bind_texture(texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TILESET_COLUMNS, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    ShaderProgram program;
+    program.load(V_SHADER_PATH, F_SHADER_PATH);
+    program.set_projection_matrix(glm::ortho(0.0f, (float) size, -(float) size, 0.0f, -1.0f, 1.0f));
+    program.set_view_matrix(glm::mat4(1.0f));
+    g_gl_state.use_program(program.get_program_id());
+
+    Map map(size, size, level.data(), texture_id, TILE_SIZE, TILESET_COLUMNS, TILESET_ROWS);
+    size_t tiles = map.get_vertices().size() / 12;
+
+    while (state.keep_running())
+    {
+        map.render(&program);
+        state.pause_timing();
+        glFinish();
+        state.resume_timing();
+    }
+
+    state.set_items_processed(state.get_iterations() * tiles);
+    state.set_bytes_processed(state.get_iterations() * tiles * 6 * 4 * sizeof(float));
+    glDeleteTextures(1, &texture_id);
+    g_gl_state.forget();
+}
+BENCHMARK(map_render)->arg(64)->arg(512);
+
+int main(int argc, char* argv[])
+{
+    headless_gl_start(2, 1, false);
+    int result = run_benchmarks(argc, argv);
+    headless_gl_stop();
+    return result;
+}
@@ -0,0 +1,195 @@
+// Lunar Lander's software rasterizer against GL on the same recorded frame: a
+// whole tile map laid out the way Rise of the AI's Map builds it, sent as one
+// tiles command.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "Benchmark.h"
+#include "HeadlessGL.h"
+#include "CommandList.h"
+#include "GLState.h"
+#include "ParticleSystem.h"
+#include "RenderBackend.h"
+#include "SoftwareRenderer.h"
+#include "SpriteSheet.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <thread>
+#include <vector>
+
+const float TILE_SIZE = 1.0f;
+const int   TILESET_COLUMNS = 4;
+const int   TILESET_ROWS = 1;
+const char  TILESET_FILEPATH[] = "../Rise_of_the_AI/assets/tileset.png";
+
+const char V_SHADER_PATH[] = "../Lunar_Lander/shaders/vertex_textured.glsl",
+F_SHADER_PATH[] = "../Lunar_Lander/shaders/fragment_textured.glsl";
+
+// xorshift32, so every run builds the same scenes
+static unsigned int next_random(unsigned int& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// ————— SCENE ————— //
+
+// The level generator from bench_rise: solid ground along the bottom and
+// floating platforms every few rows, about an eighth of the map solid
+static std::vector<unsigned int> generate_level(int width, int height)
+{
+    std::vector<unsigned int> level((size_t) width * height, 0);
+    unsigned int random = 0x9E3779B9u;
+
+    for (int y = height - 2; y < height; y++)
+    {
+        for (int x = 0; x < width; x++) level[(size_t) y * width + x] = 1;
+    }
+
+    for (int y = 2; y < height - 3; y += 4)
+    {
+        for (int x = 0; x < width;)
+        {
+            int gap = 2 + next_random(random) % 10;
+            int length = 3 + next_random(random) % 10;
+            unsigned int tile = 1 + next_random(random) % (TILESET_COLUMNS * TILESET_ROWS - 1);
+            for (int i = x + gap; i < x + gap + length && i < width; i++) level[(size_t) y * width + i] = tile;
+            x += gap + length;
+        }
+    }
+    return level;
+}
+
+// What Map::build makes of a level: six vertices per solid tile, in the
+// tileset's quad order
+struct TileArrays
+{
+    std::vector<float> vertices;
+    std::vector<float> tex_coords;
+};
+
+static TileArrays build_tiles(const std::vector<unsigned int>& level, int width, int height)
+{
+    RuntimeSpriteSheet tileset(TILESET_COLUMNS, TILESET_ROWS);
+    TileArrays tiles;
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int tile = level[(size_t) y * width + x];
+            if (tile == 0) continue;
+
+            float left = -(TILE_SIZE / 2) + TILE_SIZE * x;
+            float right = left + TILE_SIZE;
+            float top = (TILE_SIZE / 2) - TILE_SIZE * y;
+            float bottom = top - TILE_SIZE;
+            tiles.vertices.insert(tiles.vertices.end(), { left, bottom, right, bottom, right, top, left, bottom, right, top, left, top });
+
+            const float* tex_coords = tileset.tex_coords(tile);
+            tiles.tex_coords.insert(tiles.tex_coords.end(), tex_coords, tex_coords + SPRITE_QUAD_FLOATS);
+        }
+    }
+    return tiles;
+}
+
+// The whole map in view, as one frame of the game would record it
+static void record_map(CommandList& list, const TileArrays& tiles, GLuint texture_id, int size)
+{
+    float half = TILE_SIZE / 2;
+    list.reset();
+    list.clear();
+    list.set_camera(glm::mat4(1.0f), glm::ortho(-half, size * TILE_SIZE - half, -(size * TILE_SIZE - half), half, -1.0f, 1.0f));
+    list.draw_tiles(glm::mat4(1.0f), texture_id, tiles.vertices.data(), tiles.tex_coords.data(), (int) tiles.vertices.size() / 2);
+}
+
+// ————— RENDER ————— //
+
+// Binning and rasterizing one frame of tiles into a framebuffer the size of
+// the GL one. The argument is the map's width and height in tiles; the
+// smaller map has big tiles that cover many pixels, the bigger one many
+// tiles of a few pixels each.
+static void software_render_tiles(BenchmarkState& state)
+{
+    int size = (int) state.get_arg();
+    std::vector<unsigned int> level = generate_level(size, size);
+    TileArrays tiles = build_tiles(level, size, size);
+
+    ParticleSystem particles(0);
+    SoftwareRenderBackend backend(&particles);
+    backend.start(HEADLESS_GL_WIDTH, HEADLESS_GL_HEIGHT);
+    GLuint texture_id = backend.load_texture(TILESET_FILEPATH);
+    if (texture_id == 0)
+    {
+        state.skip_with_error(std::string("unable to read ") + TILESET_FILEPATH);
+        return;
+    }
+
+    CommandList list;
+    record_map(list, tiles, texture_id, size);
+
+    while (state.keep_running()) backend.execute(list);
+
+    state.set_items_processed(state.get_iterations() * (tiles.vertices.size() / SPRITE_QUAD_FLOATS));
+    state.set_label(std::string(backend.is_using_avx2() ? "avx2" : "scalar") + ", "
+        + std::to_string(std::thread::hardware_concurrency()) + " threads");
+}
+BENCHMARK(software_render_tiles)->arg(64)->arg(512);
+
+// The same list through the GL backend's client-array path. The GPU is
+// drained inside the timed part, so both sides include the drawing.
+static void gl_render_tiles(BenchmarkState& state)
+{
+    if (!headless_gl_is_running())
+    {
+        state.skip_with_error("no GL context");
+        return;
+    }
+
+    int size = (int) state.get_arg();
+    std::vector<unsigned int> level = generate_level(size, size);
+    TileArrays tiles = build_tiles(level, size, size);
+
+    int width, height, number_of_components;
+    unsigned char* image = stbi_load(TILESET_FILEPATH, &width, &height, &number_of_components, STBI_rgb_alpha);
+    if (image == NULL)
+    {
+        state.skip_with_error(std::string("unable to read ") + TILESET_FILEPATH);
+        return;
+    }
+
+    GLuint texture_id;
+    glGenTextures(1, &texture_id);
+    g_gl_state.bind_texture(texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    stbi_image_free(image);
+
+    ShaderProgram program;
+    program.load(V_SHADER_PATH, F_SHADER_PATH);
+    GLRenderBackend backend(&program, NULL, NULL, NULL);
+
+    CommandList list;
+    record_map(list, tiles, texture_id, size);
+
+    while (state.keep_running())
+    {
+        backend.execute(list);
+        glFinish();
+    }
+
+    state.set_items_processed(state.get_iterations() * (tiles.vertices.size() / SPRITE_QUAD_FLOATS));
+    glDeleteTextures(1, &texture_id);
+    g_gl_state.forget();
+}
+BENCHMARK(gl_render_tiles)->arg(64)->arg(512);
+
+int main(int argc, char* argv[])
+{
+    headless_gl_start(2, 1, false);
+    int result = run_benchmarks(argc, argv);
+    headless_gl_stop();
+    return result;
+}
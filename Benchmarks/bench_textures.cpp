@@ -0,0 +1,131 @@
+// Texture loading in Lunar Lander: PNG decoding on its own, the whole
+// TextureLoader round trip, and the raw glTexImage2D upload by size.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "Benchmark.h"
+#include "HeadlessGL.h"
+#include "GLState.h"
+#include "TextureLoader.h"
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// From a 3 KB flat sprite sheet up to the 400 KB photo on the lose screen
+const char* const SPRITE_FILEPATHS[] = {
+    "../Lunar_Lander/sprites/ship_sprite_sheet.png",
+    "../Lunar_Lander/sprites/ship_idle.png",
+    "../Lunar_Lander/sprites/win.png",
+    "../Lunar_Lander/sprites/lose.png"
+};
+
+static bool read_file(const char* filepath, std::vector<unsigned char>& contents)
+{
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file) return false;
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static std::string file_name(const char* filepath)
+{
+    std::string path(filepath);
+    return path.substr(path.rfind('/') + 1);
+}
+
+// ————— DECODE ————— //
+
+// stb_image alone, from memory, so the disk isn't part of it
+static void texture_decode(BenchmarkState& state)
+{
+    const char* filepath = SPRITE_FILEPATHS[state.get_arg()];
+    std::vector<unsigned char> contents;
+    if (!read_file(filepath, contents))
+    {
+        state.skip_with_error(std::string("unable to read ") + filepath);
+        return;
+    }
+
+    int width = 0, height = 0;
+    while (state.keep_running())
+    {
+        int channels;
+        unsigned char* pixels = stbi_load_from_memory(contents.data(), (int) contents.size(), &width, &height, &channels, STBI_rgb_alpha);
+        stbi_image_free(pixels);
+    }
+    state.set_bytes_processed(state.get_iterations() * contents.size());
+    state.set_items_processed(state.get_iterations() * width * height);
+    state.set_label(file_name(filepath) + " " + std::to_string(width) + "x" + std::to_string(height));
+}
+BENCHMARK(texture_decode)->arg(0)->arg(1)->arg(2)->arg(3);
+
+// ————— LOAD ————— //
+
+// load() then finish(): a worker decodes, the pixel buffer upload follows,
+// which is how long a texture takes to show up after the game asks for it
+static void texture_loader_round_trip(BenchmarkState& state)
+{
+    if (!headless_gl_is_running())
+    {
+        state.skip_with_error("no GL context");
+        return;
+    }
+
+    const char* filepath = SPRITE_FILEPATHS[state.get_arg()];
+    TextureLoader loader;
+    loader.start();
+
+    while (state.keep_running())
+    {
+        GLuint texture_id = loader.load(filepath);
+        loader.finish();
+        state.pause_timing();
+        // GL hands the name straight back out, so the cache must not think it's still bound
+        glDeleteTextures(1, &texture_id);
+        g_gl_state.forget();
+        state.resume_timing();
+    }
+    state.set_items_processed(state.get_iterations());
+    state.set_label(file_name(filepath));
+}
+BENCHMARK(texture_loader_round_trip)->arg(0)->arg(1)->arg(2)->arg(3);
+
+// ————— UPLOAD ————— //
+
+// A square RGBA image into a fresh texture. glFinish is timed too: drivers may
+// only copy the pixels once the upload is actually needed.
+static void texture_upload(BenchmarkState& state)
+{
+    if (!headless_gl_is_running())
+    {
+        state.skip_with_error("no GL context");
+        return;
+    }
+
+    int size = (int) state.get_arg();
+    std::vector<unsigned char> pixels((size_t) size * size * 4);
+    for (size_t i = 0; i < pixels.size(); i++) pixels[i] = (unsigned char) (i * 2654435761u >> 24);
+
+    GLuint texture_id;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    while (state.keep_running())
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glFinish();
+    }
+    state.set_bytes_processed(state.get_iterations() * pixels.size());
+    glDeleteTextures(1, &texture_id);
+}
+BENCHMARK(texture_upload)->arg(256)->arg(1024)->arg(4096);
+
+int main(int argc, char* argv[])
+{
+    headless_gl_start(2, 1, false);
+    int result = run_benchmarks(argc, argv);
+    headless_gl_stop();
+    return result;
+}
@@ -0,0 +1,88 @@
+#include "AnimationSystem.h"
+#include <math.h>
+
+AnimationSystem g_animation_system;
+
+int AnimationSystem::create(const AnimationClip& clip, AnimationLoop loop, float speed)
+{
+    Animator animator = { clip, 0.0f, speed > 0.0f ? speed : 0.0f, loop, true, true };
+
+    if (!m_free.empty())
+    {
+        int handle = m_free.back();
+        m_free.pop_back();
+        m_animators[handle] = animator;
+        m_frames[handle] = clip.first_frame;
+        return handle;
+    }
+
+    m_animators.push_back(animator);
+    m_frames.push_back(clip.first_frame);
+    return (int) m_animators.size() - 1;
+}
+
+void AnimationSystem::destroy(int handle)
+{
+    m_animators[handle].active = false;
+    m_animators[handle].playing = false;
+    m_free.push_back(handle);
+}
+
+void AnimationSystem::play(int handle, const AnimationClip& clip)
+{
+    m_animators[handle].clip = clip;
+    restart(handle);
+}
+
+void AnimationSystem::restart(int handle)
+{
+    m_animators[handle].time = 0.0f;
+    m_animators[handle].playing = true;
+    m_frames[handle] = m_animators[handle].clip.first_frame;
+}
+
+bool const AnimationSystem::is_finished(int handle) const
+{
+    const Animator& animator = m_animators[handle];
+    return animator.loop == ANIMATION_ONCE && animator.time * animator.clip.frames_per_second >= animator.clip.frame_count;
+}
+
+void AnimationSystem::update(float delta_time)
+{
+    int count = (int) m_animators.size();
+    Animator* animator = m_animators.data();
+    int* frame = m_frames.data();
+
+    for (int i = 0; i < count; i++, animator++, frame++)
+    {
+        if (!animator->playing) continue;
+
+        const AnimationClip& clip = animator->clip;
+        animator->time += delta_time * animator->speed;
+
+        // Looping clips keep their time inside one cycle so it never loses precision
+        int cycle = animator->loop == ANIMATION_PING_PONG ? 2 * clip.frame_count - 2 : clip.frame_count;
+        if (cycle < 1) cycle = 1;
+        float cycle_seconds = cycle / clip.frames_per_second;
+        if (animator->loop != ANIMATION_ONCE && animator->time >= cycle_seconds)
+        {
+            animator->time = fmodf(animator->time, cycle_seconds);
+        }
+
+        int step = (int) (animator->time * clip.frames_per_second);
+        switch (animator->loop)
+        {
+            case ANIMATION_LOOP:
+                step = step % clip.frame_count;
+                break;
+            case ANIMATION_ONCE:
+                if (step >= clip.frame_count) step = clip.frame_count - 1;
+                break;
+            case ANIMATION_PING_PONG:
+                step = step % cycle;
+                if (step >= clip.frame_count) step = cycle - step;
+                break;
+        }
+        *frame = clip.first_frame + step;
+    }
+}
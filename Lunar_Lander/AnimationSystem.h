@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include "SpriteSheet.h"
+
+enum AnimationLoop { ANIMATION_LOOP, ANIMATION_ONCE, ANIMATION_PING_PONG };
+
+struct Animator
+{
+    AnimationClip clip;
+    float         time;       // seconds into the clip, already scaled by speed
+    float         speed;      // never negative; time only runs forward
+    AnimationLoop loop;
+    bool          playing;
+    bool          active;     // false while the slot is on the free list
+};
+
+// Every sprite animation in the game, in one contiguous pool. update() moves
+// them all forward by the frame's delta time in a single pass and writes the
+// sheet frame each one is showing, which is all the renderer reads. Because
+// frames come from elapsed time, animations run at the same speed at any
+// frame rate. Handles are indices into the pool and stay valid until
+// destroy().
+class AnimationSystem
+{
+private:
+    std::vector<Animator> m_animators;
+    std::vector<int>      m_frames;       // sheet frame per animator, for the renderer
+    std::vector<int>      m_free;
+
+public:
+    int  create(const AnimationClip& clip, AnimationLoop loop = ANIMATION_LOOP, float speed = 1.0f);
+    void destroy(int handle);
+    void update(float delta_time);
+
+    // Switches clip and starts it from its first frame
+    void play(int handle, const AnimationClip& clip);
+    void restart(int handle);
+
+    // ————— GETTERS ————— //
+    int  const get_frame(int handle)    const { return m_frames[handle]; };
+    bool const is_playing(int handle)   const { return m_animators[handle].playing; };
+    bool const is_finished(int handle)  const;
+    int  const get_active_count()       const { return (int) (m_animators.size() - m_free.size()); };
+
+    // ————— SETTERS ————— //
+    void const set_playing(int handle, bool playing) { m_animators[handle].playing = playing; };
+    void const set_speed(int handle, float speed)    { m_animators[handle].speed = speed > 0.0f ? speed : 0.0f; };
+    void const set_loop(int handle, AnimationLoop loop) { m_animators[handle].loop = loop; };
+};
+
+extern AnimationSystem g_animation_system;
@@ -0,0 +1,75 @@
+#include "CommandList.h"
+#include <string.h>
+
+const int MATRIX_FLOATS = 16;
+const int QUAD_FLOATS = 12;        // 6 vertices x 2
+
+RenderCommand& CommandList::push(RenderCommandType type, int floats)
+{
+    RenderCommand command;
+    command.type = type;
+    command.texture_id = 0;
+    command.data_offset = (int) m_data.size();
+    command.count = 0;
+
+    m_data.resize(m_data.size() + floats);
+    m_commands.push_back(command);
+    return m_commands.back();
+}
+
+void CommandList::clear()
+{
+    push(RENDER_CLEAR, 0);
+}
+
+void CommandList::set_camera(const glm::mat4& view_matrix, const glm::mat4& projection_matrix)
+{
+    RenderCommand& command = push(RENDER_CAMERA, MATRIX_FLOATS * 2);
+    memcpy(&m_data[command.data_offset], &view_matrix[0][0], sizeof(glm::mat4));
+    memcpy(&m_data[command.data_offset + MATRIX_FLOATS], &projection_matrix[0][0], sizeof(glm::mat4));
+}
+
+void CommandList::draw_quad(const glm::mat4& model_matrix, GLuint texture_id)
+{
+    RenderCommand& command = push(RENDER_QUAD, MATRIX_FLOATS);
+    command.texture_id = texture_id;
+    memcpy(&m_data[command.data_offset], &model_matrix[0][0], sizeof(glm::mat4));
+}
+
+void CommandList::draw_quad(const glm::mat4& model_matrix, GLuint texture_id, const float* vertices, const float* tex_coords)
+{
+    RenderCommand& command = push(RENDER_QUAD, MATRIX_FLOATS + QUAD_FLOATS * 2);
+    command.texture_id = texture_id;
+    command.count = 6;
+
+    float* data = &m_data[command.data_offset];
+    memcpy(data, &model_matrix[0][0], sizeof(glm::mat4));
+    memcpy(data + MATRIX_FLOATS, vertices, QUAD_FLOATS * sizeof(float));
+    memcpy(data + MATRIX_FLOATS + QUAD_FLOATS, tex_coords, QUAD_FLOATS * sizeof(float));
+}
+
+float* CommandList::draw_particles(int count)
+{
+    RenderCommand& command = push(RENDER_PARTICLES, count * 3);
+    command.count = count;
+    return m_data.data() + command.data_offset;
+}
+
+void CommandList::draw_tiles(const glm::mat4& model_matrix, GLuint texture_id, const float* vertices, const float* tex_coords, int vertex_count)
+{
+    RenderCommand& command = push(RENDER_TILES, MATRIX_FLOATS + vertex_count * 4);
+    command.texture_id = texture_id;
+    command.count = vertex_count;
+
+    float* data = &m_data[command.data_offset];
+    memcpy(data, &model_matrix[0][0], sizeof(glm::mat4));
+    memcpy(data + MATRIX_FLOATS, vertices, vertex_count * 2 * sizeof(float));
+    memcpy(data + MATRIX_FLOATS + vertex_count * 2, tex_coords, vertex_count * 2 * sizeof(float));
+}
+
+glm::mat4 CommandList::get_matrix(int offset) const
+{
+    glm::mat4 matrix;
+    memcpy(&matrix[0][0], m_data.data() + offset, sizeof(glm::mat4));
+    return matrix;
+}
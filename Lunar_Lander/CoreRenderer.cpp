@@ -0,0 +1,105 @@
+#include "CoreRenderer.h"
+#include "RenderStats.h"
+#include <stddef.h>
+
+const int QUAD_VERTEX_COUNT = 6;
+const int QUAD_FLOATS = QUAD_VERTEX_COUNT * 4;   // x, y, u, v per vertex
+
+const float UNIT_QUAD[QUAD_FLOATS] = {
+    -0.5f, -0.5f,  0.0f, 1.0f,
+     0.5f, -0.5f,  1.0f, 1.0f,
+     0.5f,  0.5f,  1.0f, 0.0f,
+    -0.5f, -0.5f,  0.0f, 1.0f,
+     0.5f,  0.5f,  1.0f, 0.0f,
+    -0.5f,  0.5f,  0.0f, 0.0f
+};
+
+void CoreRenderer::start_load(const char* vertex_shader_file, const char* fragment_shader_file)
+{
+    m_program.start_load(vertex_shader_file, fragment_shader_file);
+}
+
+void CoreRenderer::finish_load()
+{
+    m_program.finish_load();
+    m_program.bind_uniform_block("Camera", CAMERA_BLOCK_BINDING);
+
+    // Two std140 mat4s back to back; bound once, rewritten when the camera moves
+    glGenBuffers(1, &m_camera_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_camera_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, m_camera_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glGenBuffers(1, &m_quad_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(UNIT_QUAD), UNIT_QUAD, GL_STATIC_DRAW);
+    m_quad_vertex_array = create_vertex_array(m_quad_buffer);
+
+    glGenBuffers(1, &m_dynamic_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_dynamic_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(UNIT_QUAD), NULL, GL_STREAM_DRAW);
+    m_dynamic_vertex_array = create_vertex_array(m_dynamic_buffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GLuint CoreRenderer::create_vertex_array(GLuint buffer)
+{
+    GLuint vertex_array;
+    glGenVertexArrays(1, &vertex_array);
+    g_gl_state.bind_vertex_array(vertex_array);
+
+    // The VAO remembers the buffer, layout and enables, so none of this is repeated per draw
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(m_program.get_position_attribute(), 2, GL_FLOAT, false, 4 * sizeof(float), (const void*) 0);
+    glEnableVertexAttribArray(m_program.get_position_attribute());
+    glVertexAttribPointer(m_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 4 * sizeof(float), (const void*) (2 * sizeof(float)));
+    glEnableVertexAttribArray(m_program.get_tex_coordinate_attribute());
+
+    g_gl_state.bind_vertex_array(0);
+    return vertex_array;
+}
+
+void CoreRenderer::set_camera(const glm::mat4& view_matrix, const glm::mat4& projection_matrix)
+{
+    glm::mat4 camera[] = { view_matrix, projection_matrix };
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_camera_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(camera), camera);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    g_render_stats.count_uniform_upload();
+}
+
+void CoreRenderer::draw_quad(const glm::mat4& model_matrix, GLuint texture_id)
+{
+    m_program.set_model_matrix(model_matrix);
+    g_gl_state.bind_texture(texture_id);
+    g_gl_state.bind_vertex_array(m_quad_vertex_array);
+
+    glDrawArrays(GL_TRIANGLES, 0, QUAD_VERTEX_COUNT);
+    g_render_stats.count_draw(GL_TRIANGLES, QUAD_VERTEX_COUNT);
+}
+
+void CoreRenderer::draw_quad(const glm::mat4& model_matrix, GLuint texture_id, const float* vertices, const float* tex_coords)
+{
+    float interleaved[QUAD_FLOATS];
+    for (int i = 0; i < QUAD_VERTEX_COUNT; i++)
+    {
+        interleaved[i * 4]     = vertices[i * 2];
+        interleaved[i * 4 + 1] = vertices[i * 2 + 1];
+        interleaved[i * 4 + 2] = tex_coords[i * 2];
+        interleaved[i * 4 + 3] = tex_coords[i * 2 + 1];
+    }
+
+    m_program.set_model_matrix(model_matrix);
+    g_gl_state.bind_texture(texture_id);
+    g_gl_state.bind_vertex_array(m_dynamic_vertex_array);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_dynamic_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(interleaved), interleaved);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glDrawArrays(GL_TRIANGLES, 0, QUAD_VERTEX_COUNT);
+    g_render_stats.count_draw(GL_TRIANGLES, QUAD_VERTEX_COUNT);
+}
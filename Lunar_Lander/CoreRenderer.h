@@ -0,0 +1,46 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+
+const GLuint CAMERA_BLOCK_BINDING = 0;   // every core program reads the camera from here
+
+// Sprite drawing for a GL 3.3 core profile context. All geometry lives in
+// buffers owned by VAOs, so a draw is a VAO bind, a model matrix and a texture.
+// View and projection sit in one std140 uniform block that every core program
+// shares; changing the camera is a single buffer write.
+class CoreRenderer
+{
+private:
+    ShaderProgram m_program;
+
+    GLuint m_camera_buffer = 0;
+
+    // Unit quad with the usual flipped-v texture coordinates; never changes
+    GLuint m_quad_vertex_array = 0;
+    GLuint m_quad_buffer = 0;
+
+    // Six vertices rewritten per draw, for atlas frames and odd-sized quads
+    GLuint m_dynamic_vertex_array = 0;
+    GLuint m_dynamic_buffer = 0;
+
+    GLuint create_vertex_array(GLuint buffer);
+
+public:
+    // Split like ShaderProgram's load, so the program can compile alongside others
+    void start_load(const char* vertex_shader_file, const char* fragment_shader_file);
+    void finish_load();
+
+    void set_camera(const glm::mat4& view_matrix, const glm::mat4& projection_matrix);
+
+    void draw_quad(const glm::mat4& model_matrix, GLuint texture_id);
+    // vertices and tex_coords hold 6 vertices of 2 floats each
+    void draw_quad(const glm::mat4& model_matrix, GLuint texture_id, const float* vertices, const float* tex_coords);
+
+    ShaderProgram* get_program() { return &m_program; };
+};
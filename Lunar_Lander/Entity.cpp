@@ -11,68 +11,52 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "CommandList.h"
+#include "AnimationSystem.h"
 #include "Entity.h"
 #include <iostream>
 
+const float SPRITE_VERTICES[] =
+{
+    -0.5, -0.5, 0.5, -0.5,  0.5, 0.5,
+    -0.5, -0.5, 0.5,  0.5, -0.5, 0.5
+};
+
+typedef SpriteSheet<1, 1> IdleSheet;     // ship_idle.png
+typedef SpriteSheet<6, 1> MovingSheet;   // ship_move.png, six frames of thrust
+
+const float THRUST_FRAMES_PER_SECOND = 12.0f;
+const AnimationClip THRUST_CLIP = MovingSheet::clip<0, MovingSheet::FRAME_COUNT>(THRUST_FRAMES_PER_SECOND);
+
 Entity::Entity()
 {
     m_position     = glm::vec3(0);
     m_model_matrix = glm::mat4(1.0f);
+    m_animator     = g_animation_system.create(THRUST_CLIP);
 }
 
 Entity::~Entity()
 {
-    ;
-}
-
-void Entity::draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index)
-{
-    // Step 1: Calculate the UV location of the indexed frame
-    float u_coord = (float) (index % 6) / (float) 6;
-    float v_coord = (float) (index / 6) / (float) 1;
-    
-    // Step 2: Calculate its UV size
-    float width = 1.0f / (float) 6;
-    float height = 1.0f / (float) 1;
-    
-    // Step 3: Just as we have done before, match the texture coordinates to the vertices
-    float tex_coords[] =
-    {
-        u_coord, v_coord + height, u_coord + width, v_coord + height, u_coord + width, v_coord,
-        u_coord, v_coord + height, u_coord + width, v_coord, u_coord, v_coord
-    };
-    
-    float vertices[] =
-    {
-        -0.5, -0.5, 0.5, -0.5,  0.5, 0.5,
-        -0.5, -0.5, 0.5,  0.5, -0.5, 0.5
-    };
-    
-    // Step 4: And render
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    
-    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->get_position_attribute());
-    
-    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
-    
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    glDisableVertexAttribArray(program->get_position_attribute());
-    glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
+    g_animation_system.destroy(m_animator);
 }
 
 void Entity::update(float delta_time)
 {
+    m_previous_position = m_position;
+    m_previous_ship_angle = m_ship_angle;
+
+    m_ship_angle += m_turning * ROT_SPEED * delta_time;
+
     if (m_accelerating && fuel > 0) {
-        m_velocity += glm::vec3(-SHIP_ACCELERATION * sin(glm::radians(m_ship_angle)), SHIP_ACCELERATION * cos(glm::radians(m_ship_angle)), 0.0f);
-        fuel = fuel - 1;
+        m_velocity += glm::vec3(-SHIP_ACCELERATION * sin(glm::radians(m_ship_angle)), SHIP_ACCELERATION * cos(glm::radians(m_ship_angle)), 0.0f) * delta_time;
+        fuel = fuel - FUEL_PER_SECOND * delta_time;
     }
     else {
         m_accelerating = false;
     }
-    m_velocity += GRAVITY_ACCELERATION;
+    // The flame only plays while thrusting; g_animation_system moves it on
+    g_animation_system.set_playing(m_animator, m_accelerating);
+    m_velocity += GRAVITY_ACCELERATION * delta_time;
     if (m_velocity.y < MAX_GRAVITY_VELOCITY) {
         m_velocity.y = MAX_GRAVITY_VELOCITY;
     }
@@ -88,39 +72,28 @@ void Entity::update(float delta_time)
     m_position += m_velocity * SHIP_SPEED * delta_time;
 
     //std::cout << m_velocity.y << std::endl;
+}
+
+void Entity::interpolate(float alpha)
+{
+    glm::vec3 position = glm::mix(m_previous_position, m_position, alpha);
+    float ship_angle = m_previous_ship_angle + (m_ship_angle - m_previous_ship_angle) * alpha;
 
     m_model_matrix = glm::mat4(1.0f);
-    m_model_matrix = glm::translate(m_model_matrix, m_position);
+    m_model_matrix = glm::translate(m_model_matrix, position);
     m_model_matrix = glm::rotate(m_model_matrix, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    m_model_matrix = glm::rotate(m_model_matrix, glm::radians(m_ship_angle), glm::vec3(0.0f, 0.0f, 1.0f));
+    m_model_matrix = glm::rotate(m_model_matrix, glm::radians(ship_angle), glm::vec3(0.0f, 0.0f, 1.0f));
 }
 
-void Entity::render(ShaderProgram *program)
+void Entity::render(CommandList *list)
 {
-    program->set_model_matrix(m_model_matrix);
-    
     if (m_accelerating)
     {
-        draw_sprite_from_texture_atlas(program, m_moving_texture_id, m_animation_index);
-        m_animation_index += 1;
+        list->draw_quad(m_model_matrix, m_moving_texture_id, SPRITE_VERTICES, MovingSheet::tex_coords(g_animation_system.get_frame(m_animator)));
         return;
     }
 
-    
-    float vertices[]   = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-    float tex_coords[] = {  0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
-    
-    glBindTexture(GL_TEXTURE_2D, m_idle_texture_id);
-    
-    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->get_position_attribute());
-    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
-    
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    glDisableVertexAttribArray(program->get_position_attribute());
-    glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
+    list->draw_quad(m_model_matrix, m_idle_texture_id);
 }
 
 bool const Entity::check_collision(const glm::vec3& boxPosition) const {
@@ -7,48 +7,57 @@ private:
     glm::mat4 m_model_matrix;
     bool      m_accelerating = false;
     float     m_ship_angle = 0.0f;
-    int       fuel = 300;
+    float     m_turning = 0.0f;     // 1 = left, -1 = right
+    float     fuel = 300.0f;
+
+    // Where the ship was before the last step; drawing blends towards the current one
+    glm::vec3 m_previous_position = glm::vec3(0.0f, 0.0f, 0.0f);
+    float     m_previous_ship_angle = 0.0f;
 
     // ————— STATIC VARIABLES ————— //
-    const glm::vec3 GRAVITY_ACCELERATION = glm::vec3(0.0f, -0.02f, 0.0f);
-    const float SHIP_ACCELERATION = 0.05f;
+    const glm::vec3 GRAVITY_ACCELERATION = glm::vec3(0.0f, -1.2f, 0.0f);   // per second
+    const float SHIP_ACCELERATION = 3.0f;
     const float MAX_GRAVITY_VELOCITY = -1.5f;
     const float MAX_HORIZONTAL_VELOCITY = 1.0f;
-    static const int SECONDS_PER_FRAME = 4;
     const float SHIP_SPEED = 2.0f;
-    const float ROT_SPEED = 1.0f;
+    const float ROT_SPEED = 60.0f;          // degrees per second
+    const float FUEL_PER_SECOND = 60.0f;
     const float COLLISION_DIST = 0.5f;
     
     // ————— TEXTURES ————— //
     GLuint    m_idle_texture_id;
     GLuint    m_moving_texture_id;
+
+    // ————— ANIMATION ————— //
+    int       m_animator;       // handle in g_animation_system, plays while thrusting
     
 public:
-    // ————— ANIMATION ————— //   
-    float m_animation_time    = 0.0f;
-    int m_animation_index = 0;
 
     // ————— METHODS ————— //
     Entity();
     ~Entity();
 
-    void draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index);
+    // One fixed simulation step
     void update(float delta_time);
-    void render(ShaderProgram *program);
+    // Builds the model matrix part way between the last two steps (0 = previous, 1 = latest)
+    void interpolate(float alpha);
+    void render(CommandList *list);
     
-    void rotate_left() { m_ship_angle += 1.0f; };
-    void rotate_right() { m_ship_angle += -1.0f; };
+    void set_turning(float direction) { m_turning = direction; };
     bool const check_collision(const glm::vec3& boxPosition) const;
     
     // ————— GETTERS ————— //
     glm::vec3 const get_position()   const { return m_position;   };
     glm::vec3 const get_velocity()   const { return m_velocity;   };
+    float     const get_ship_angle() const { return m_ship_angle; };
+    float     const get_fuel()       const { return fuel;         };
+    bool      const get_accelerating() const { return m_accelerating; };
     GLuint    const get_idle_texture_id() const { return m_idle_texture_id; };
     GLuint    const get_moving_texture_id() const { return m_moving_texture_id; };
 
     
     // ————— SETTERS ————— //
-    void const set_position(glm::vec3 new_position)  { m_position   = new_position;     };
+    void const set_position(glm::vec3 new_position)  { m_position   = new_position; m_previous_position = new_position; };
     void const set_velocity(glm::vec3 new_velocity)  { m_velocity   = new_velocity;     };
     void const set_idle_texture_id(GLuint new_texture_id) { m_idle_texture_id = new_texture_id;   };
     void const set_moving_texture_id(GLuint new_texture_id) { m_moving_texture_id = new_texture_id; };
@@ -0,0 +1,37 @@
+#include "FixedTimestep.h"
+
+void FixedTimestep::start(float step, int max_steps)
+{
+    m_frequency = SDL_GetPerformanceFrequency();
+    m_previous_counter = SDL_GetPerformanceCounter();
+    m_accumulator = 0.0;
+    m_step = step;
+    m_max_steps = max_steps;
+}
+
+int FixedTimestep::advance()
+{
+    Uint64 counter = SDL_GetPerformanceCounter();
+    double seconds = (double) (counter - m_previous_counter) / m_frequency;
+    m_previous_counter = counter;
+    return advance(seconds);
+}
+
+int FixedTimestep::advance(double seconds)
+{
+    m_frame_seconds = seconds;
+    m_accumulator += seconds;
+
+    int steps = (int) (m_accumulator / m_step);
+    if (steps > m_max_steps)
+    {
+        m_dropped_seconds += (steps - m_max_steps) * (double) m_step;
+        m_accumulator -= (steps - m_max_steps) * (double) m_step;
+        steps = m_max_steps;
+    }
+
+    m_accumulator -= steps * (double) m_step;
+    if (m_accumulator < 0.0) m_accumulator = 0.0;   // rounding
+    m_total_steps += steps;
+    return steps;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "Profiler.h"
+
+// Frame times are kept in microseconds: exactly below 128, then in buckets of
+// 64 per power of two, so any value is known to within 1/64 (about 1.6%)
+const int   FRAME_HISTOGRAM_SUB_BUCKETS = 128;
+const int   FRAME_HISTOGRAM_MAX_SHIFT = 26;             // tops out past two hours
+const int   FRAME_HISTOGRAM_BUCKETS = FRAME_HISTOGRAM_SUB_BUCKETS + FRAME_HISTOGRAM_MAX_SHIFT * FRAME_HISTOGRAM_SUB_BUCKETS / 2;
+
+const float FRAME_HITCH_BUDGET_MS = 1000.0f / 30.0f;    // two frames at 60 Hz
+const int   FRAME_HITCH_TOP_SCOPES = 5;
+const float FRAME_HITCH_MARK_SECONDS = 1.0f;            // marks this far back are kept with a hitch
+const int   FRAME_MAX_HITCHES = 256;                    // later hitches are counted but not described
+
+// Log-bucketed counts of frame times, the way HdrHistogram keeps them: a
+// fixed array, constant time to record, and percentiles to within the
+// bucket resolution however long the run
+class FrameTimeHistogram
+{
+private:
+    Uint64 m_counts[FRAME_HISTOGRAM_BUCKETS] = {};
+    Uint64 m_total = 0;
+    Uint64 m_sum_us = 0;
+    Uint64 m_max_us = 0;
+
+    static int bucket_index(Uint64 us);
+
+public:
+    // Largest value that lands in the bucket
+    static Uint64 bucket_upper(int index);
+
+    void record(Uint64 us);
+    // The smallest time `percentile` percent of frames are at or under
+    Uint64 value_at_percentile(double percentile) const;
+
+    Uint64 const get_count(int index) const { return m_counts[index]; };
+    Uint64 const get_total()  const { return m_total; };
+    Uint64 const get_max_us() const { return m_max_us; };
+    double const get_mean_us() const { return m_total > 0 ? (double) m_sum_us / m_total : 0.0; };
+};
+
+// A frame that went over budget and what was going on around it
+struct FrameHitch
+{
+    int    frame;
+    double time_seconds;        // since start()
+    double ms;
+    Uint64 end_counts;
+    std::vector<ScopeTotal>  scopes;    // the frame's longest scopes
+    std::vector<ProfileMark> marks;     // loads, compiles and rebuilds just before it
+};
+
+// Times every frame of the main loop into a histogram and keeps a snapshot
+// of each frame over the hitch budget: the profiler's longest scopes for that
+// frame and whatever marks were made in the second before it. The report is
+// written once, at shutdown, so recording costs next to nothing.
+class FrameTimeRecorder
+{
+private:
+    Uint64 m_frequency = 1;
+    Uint64 m_start_counts = 0;
+    Uint64 m_last_counts = 0;
+    float  m_budget_ms = FRAME_HITCH_BUDGET_MS;
+
+    FrameTimeHistogram m_histogram;
+    int    m_frames = 0;
+    int    m_hitch_count = 0;
+    std::vector<FrameHitch> m_hitches;
+
+public:
+    void start(float budget_ms = FRAME_HITCH_BUDGET_MS);
+    // Once per frame on the main thread, after g_profiler.end_frame(). Frames
+    // the pacer stretched on purpose (a hidden window) are left out.
+    void end_frame(bool throttled = false);
+
+    bool write_report(const char* path) const;
+    void print_summary() const;
+
+    const FrameTimeHistogram& get_histogram() const { return m_histogram; };
+    int   const get_frames()      const { return m_frames; };
+    int   const get_hitch_count() const { return m_hitch_count; };
+    float const get_budget_ms()   const { return m_budget_ms; };
+};
+
+// Reads --frame-report FILE and --hitch-ms N from the command line
+void parse_frame_report_arguments(int argc, char* argv[], const char** report_path, float* budget_ms);
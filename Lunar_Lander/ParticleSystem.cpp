@@ -0,0 +1,218 @@
+#include "ParticleSystem.h"
+#include "RenderStats.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLES_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+const float TWO_PI = 6.2831853f;
+
+ParticleSystem::ParticleSystem(int capacity)
+{
+    // Round up to a multiple of 4 so the SIMD loop never has to deal with a tail
+    m_capacity = (capacity + 3) & ~3;
+
+    // This is the only allocation the system ever makes
+    m_position_x.resize(m_capacity, 0.0f);
+    m_position_y.resize(m_capacity, 0.0f);
+    m_velocity_x.resize(m_capacity, 0.0f);
+    m_velocity_y.resize(m_capacity, 0.0f);
+    m_life.resize(m_capacity, 0.0f);
+    m_inverse_lifetime.resize(m_capacity, 0.0f);
+    m_alpha.resize(m_capacity, 0.0f);
+}
+
+void ParticleSystem::start_load(const char* vertex_shader_file, const char* fragment_shader_file)
+{
+    m_program.start_load(vertex_shader_file, fragment_shader_file);
+}
+
+void ParticleSystem::finish_load(bool core_profile)
+{
+    m_program.finish_load();
+
+    m_position_x_attribute = glGetAttribLocation(m_program.get_program_id(), "positionX");
+    m_position_y_attribute = glGetAttribLocation(m_program.get_program_id(), "positionY");
+    m_alpha_attribute      = glGetAttribLocation(m_program.get_program_id(), "alpha");
+    m_point_size_uniform   = glGetUniformLocation(m_program.get_program_id(), "pointSize");
+
+    // Only the particles draw points, so these can stay on for good. Core
+    // profile always rasterises points as sprites and has no switch for it.
+    glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+    if (!core_profile)
+    {
+        glEnable(GL_POINT_SPRITE);
+        return;
+    }
+
+    m_program.bind_uniform_block("Camera", CAMERA_BLOCK_BINDING);
+
+    glGenVertexArrays(1, &m_vertex_array);
+    g_gl_state.bind_vertex_array(m_vertex_array);
+    glEnableVertexAttribArray(m_position_x_attribute);
+    glEnableVertexAttribArray(m_position_y_attribute);
+    glEnableVertexAttribArray(m_alpha_attribute);
+    g_gl_state.bind_vertex_array(0);
+}
+
+float ParticleSystem::random_unit()
+{
+    // xorshift32; rand() is both slower and not guaranteed to be thread-safe
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return (m_seed >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleSystem::emit(glm::vec3 position, glm::vec3 direction, float spread, float speed, float lifetime, int count)
+{
+    float base_angle = atan2f(direction.y, direction.x);
+
+    for (int i = 0; i < count; i++)
+    {
+        // A full pool simply drops new particles instead of growing
+        if (m_live_count == m_capacity) return;
+
+        float angle = base_angle + (random_unit() * 2.0f - 1.0f) * spread;
+        float particle_speed = speed * (0.5f + 0.5f * random_unit());
+        float particle_lifetime = lifetime * (0.5f + 0.5f * random_unit());
+
+        int index = m_live_count++;
+        m_position_x[index] = position.x;
+        m_position_y[index] = position.y;
+        m_velocity_x[index] = cosf(angle) * particle_speed;
+        m_velocity_y[index] = sinf(angle) * particle_speed;
+        m_life[index] = particle_lifetime;
+        m_inverse_lifetime[index] = 1.0f / particle_lifetime;
+        m_alpha[index] = 1.0f;
+    }
+}
+
+void ParticleSystem::burst(glm::vec3 position, float speed, float lifetime, int count)
+{
+    emit(position, glm::vec3(1.0f, 0.0f, 0.0f), TWO_PI / 2.0f, speed, lifetime, count);
+}
+
+void ParticleSystem::update(float delta_time)
+{
+    // Lanes past m_live_count hold stale data, but they are inside the pool and
+    // get overwritten by the next emit, so there is no harm in integrating them
+    int padded_count = (m_live_count + 3) & ~3;
+
+    float* position_x = m_position_x.data();
+    float* position_y = m_position_y.data();
+    float* velocity_x = m_velocity_x.data();
+    float* velocity_y = m_velocity_y.data();
+    float* life = m_life.data();
+    float* inverse_lifetime = m_inverse_lifetime.data();
+    float* alpha = m_alpha.data();
+
+#ifdef PARTICLES_USE_SSE
+    const __m128 dt = _mm_set1_ps(delta_time);
+    const __m128 gravity_x = _mm_set1_ps(m_gravity.x * delta_time);
+    const __m128 gravity_y = _mm_set1_ps(m_gravity.y * delta_time);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (int i = 0; i < padded_count; i += 4)
+    {
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(velocity_x + i), gravity_x);
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(velocity_y + i), gravity_y);
+        __m128 px = _mm_add_ps(_mm_loadu_ps(position_x + i), _mm_mul_ps(vx, dt));
+        __m128 py = _mm_add_ps(_mm_loadu_ps(position_y + i), _mm_mul_ps(vy, dt));
+        __m128 remaining = _mm_sub_ps(_mm_loadu_ps(life + i), dt);
+        __m128 fade = _mm_max_ps(_mm_mul_ps(remaining, _mm_loadu_ps(inverse_lifetime + i)), zero);
+
+        _mm_storeu_ps(velocity_x + i, vx);
+        _mm_storeu_ps(velocity_y + i, vy);
+        _mm_storeu_ps(position_x + i, px);
+        _mm_storeu_ps(position_y + i, py);
+        _mm_storeu_ps(life + i, remaining);
+        _mm_storeu_ps(alpha + i, fade);
+    }
+#else
+    float gravity_x = m_gravity.x * delta_time;
+    float gravity_y = m_gravity.y * delta_time;
+
+    for (int i = 0; i < padded_count; i++)
+    {
+        velocity_x[i] += gravity_x;
+        velocity_y[i] += gravity_y;
+        position_x[i] += velocity_x[i] * delta_time;
+        position_y[i] += velocity_y[i] * delta_time;
+        life[i] -= delta_time;
+        alpha[i] = life[i] > 0.0f ? life[i] * inverse_lifetime[i] : 0.0f;
+    }
+#endif
+
+    // Swap-remove the dead ones. Walking backwards means the particle we pull in
+    // from the end has already been checked, so one pass is enough.
+    for (int i = m_live_count - 1; i >= 0; i--)
+    {
+        if (life[i] > 0.0f) continue;
+
+        int last = --m_live_count;
+        position_x[i] = position_x[last];
+        position_y[i] = position_y[last];
+        velocity_x[i] = velocity_x[last];
+        velocity_y[i] = velocity_y[last];
+        life[i] = life[last];
+        inverse_lifetime[i] = inverse_lifetime[last];
+        alpha[i] = alpha[last];
+    }
+}
+
+void ParticleSystem::record(CommandList* list) const
+{
+    if (m_live_count == 0) return;
+
+    size_t block = m_live_count * sizeof(float);
+    float* write = list->draw_particles(m_live_count);
+    memcpy(write, m_position_x.data(), block);
+    memcpy(write + m_live_count, m_position_y.data(), block);
+    memcpy(write + m_live_count * 2, m_alpha.data(), block);
+}
+
+void ParticleSystem::draw(const float* position_x, const float* position_y, const float* alpha, int count,
+                          const glm::mat4& view_matrix, const glm::mat4& projection_matrix, StreamBuffer* stream)
+{
+    if (count == 0) return;
+    if (m_position_x_attribute < 0 || m_position_y_attribute < 0 || m_alpha_attribute < 0) return;
+
+    if (m_vertex_array == 0)
+    {
+        m_program.set_view_matrix(view_matrix);
+        m_program.set_projection_matrix(projection_matrix);
+    }
+    m_program.set_colour(m_colour.r, m_colour.g, m_colour.b, m_colour.a);
+    if (g_gl_state.uniform_changed(&m_point_size_value, m_point_size_valid, &m_point_size, sizeof(float)))
+    {
+        glUniform1f(m_point_size_uniform, m_point_size);
+    }
+
+    // The pool arrays go into the stream buffer back to back, one block per
+    // attribute, so every live particle still goes out in one draw
+    size_t block = count * sizeof(float);
+    size_t offset;
+    char* write = (char*) stream->reserve(block * 3, offset);
+    memcpy(write, position_x, block);
+    memcpy(write + block, position_y, block);
+    memcpy(write + block * 2, alpha, block);
+    stream->commit();
+
+    // The stream offset moves every frame, so even the VAO needs its pointers
+    // set again; the enables stay recorded in it
+    if (m_vertex_array != 0) g_gl_state.bind_vertex_array(m_vertex_array);
+
+    glBindBuffer(GL_ARRAY_BUFFER, stream->get_buffer());
+    glVertexAttribPointer(m_position_x_attribute, 1, GL_FLOAT, false, 0, (const void*) offset);
+    glVertexAttribPointer(m_position_y_attribute, 1, GL_FLOAT, false, 0, (const void*) (offset + block));
+    glVertexAttribPointer(m_alpha_attribute, 1, GL_FLOAT, false, 0, (const void*) (offset + block * 2));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (m_vertex_array == 0) g_gl_state.set_attributes(attribute_bit(m_position_x_attribute) | attribute_bit(m_position_y_attribute) | attribute_bit(m_alpha_attribute));
+
+    glDrawArrays(GL_POINTS, 0, count);
+    g_render_stats.count_draw(GL_POINTS, count);
+}
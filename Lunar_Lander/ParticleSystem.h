@@ -0,0 +1,82 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include "CoreRenderer.h"
+#include "CommandList.h"
+
+class ParticleSystem
+{
+private:
+    // ————— POOL ————— //
+    // Every attribute lives in its own array (SoA) so that the update can chew
+    // through four particles at a time, and so that the arrays can be copied
+    // into the stream buffer as they are without interleaving them first.
+    int m_capacity;
+    int m_live_count = 0;
+
+    std::vector<float> m_position_x;
+    std::vector<float> m_position_y;
+    std::vector<float> m_velocity_x;
+    std::vector<float> m_velocity_y;
+    std::vector<float> m_life;
+    std::vector<float> m_inverse_lifetime;
+    std::vector<float> m_alpha;
+
+    // ————— SETTINGS ————— //
+    glm::vec3 m_gravity     = glm::vec3(0.0f, -0.5f, 0.0f);
+    glm::vec4 m_colour      = glm::vec4(1.0f, 0.55f, 0.1f, 1.0f);
+    float     m_point_size  = 4.0f;
+
+    // ————— RENDERING ————— //
+    ShaderProgram m_program;
+    GLint m_position_x_attribute;
+    GLint m_position_y_attribute;
+    GLint m_alpha_attribute;
+    GLint m_point_size_uniform;
+    float m_point_size_value;           // last value uploaded
+    GLuint m_vertex_array = 0;          // only on a core-profile context
+    bool  m_point_size_valid = false;
+
+    unsigned int m_seed = 0x9E3779B9u;
+
+    float random_unit();
+
+public:
+    // ————— METHODS ————— //
+    ParticleSystem(int capacity);
+
+    // Loading is split like ShaderProgram's, so the program can compile
+    // alongside others. A core-profile load reads the camera from the shared
+    // uniform block and draws through its own VAO.
+    void start_load(const char* vertex_shader_file, const char* fragment_shader_file);
+    void finish_load(bool core_profile = false);
+    void emit(glm::vec3 position, glm::vec3 direction, float spread, float speed, float lifetime, int count);
+    void burst(glm::vec3 position, float speed, float lifetime, int count);
+    void update(float delta_time);
+    // Copies the live particles into the list, to be drawn later with draw()
+    void record(CommandList* list) const;
+    // Draws `count` particles from separate x, y and alpha arrays; the matrices
+    // are ignored on a core-profile load
+    void draw(const float* position_x, const float* position_y, const float* alpha, int count,
+              const glm::mat4& view_matrix, const glm::mat4& projection_matrix, StreamBuffer* stream);
+    void clear() { m_live_count = 0; };
+
+    // ————— GETTERS ————— //
+    int const get_capacity()   const { return m_capacity;   };
+    int const get_live_count() const { return m_live_count; };
+    glm::vec4 const get_colour()     const { return m_colour;     };
+    float     const get_point_size() const { return m_point_size; };
+
+    // ————— SETTERS ————— //
+    void const set_gravity(glm::vec3 new_gravity)  { m_gravity    = new_gravity; };
+    void const set_colour(glm::vec4 new_colour)    { m_colour     = new_colour;  };
+    void const set_point_size(float new_size)      { m_point_size = new_size;    };
+};
@@ -0,0 +1,277 @@
+#include "RenderBackend.h"
+#include "GLState.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include <iostream>
+#include <string.h>
+
+const int MATRIX_FLOATS = 16;
+const int QUAD_FLOATS = 12;        // 6 vertices x 2
+
+// ————— GL ————— //
+
+void GLRenderBackend::execute(const CommandList& list)
+{
+    PROFILE_SCOPE("GLRenderBackend::execute");
+    const float quad_vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
+    const float quad_tex_coords[] = { 0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
+    glm::mat4 view, projection;
+
+    for (const RenderCommand& command : list.get_commands())
+    {
+        const float* data = list.get_data(command.data_offset);
+
+        switch (command.type)
+        {
+        case RENDER_CLEAR:
+            glClear(GL_COLOR_BUFFER_BIT);
+            break;
+        case RENDER_CAMERA:
+            view = list.get_matrix(command.data_offset);
+            projection = list.get_matrix(command.data_offset + MATRIX_FLOATS);
+            if (m_core_renderer != NULL)
+            {
+                m_core_renderer->set_camera(view, projection);
+            }
+            else
+            {
+                m_program->set_view_matrix(view);
+                m_program->set_projection_matrix(projection);
+            }
+            break;
+        case RENDER_QUAD:
+            if (m_core_renderer != NULL)
+            {
+                if (command.count == 0) m_core_renderer->draw_quad(list.get_matrix(command.data_offset), command.texture_id);
+                else m_core_renderer->draw_quad(list.get_matrix(command.data_offset), command.texture_id, data + MATRIX_FLOATS, data + MATRIX_FLOATS + QUAD_FLOATS);
+            }
+            else
+            {
+                g_gl_state.use_program(m_program->get_program_id());
+                m_program->set_model_matrix(list.get_matrix(command.data_offset));
+                g_gl_state.bind_texture(command.texture_id);
+
+                glVertexAttribPointer(m_program->get_position_attribute(), 2, GL_FLOAT, false, 0, command.count == 0 ? quad_vertices : data + MATRIX_FLOATS);
+                glVertexAttribPointer(m_program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, command.count == 0 ? quad_tex_coords : data + MATRIX_FLOATS + QUAD_FLOATS);
+                g_gl_state.set_attributes(m_program->get_attribute_mask());
+
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+                g_render_stats.count_client_draw(GL_TRIANGLES, 6, 4 * sizeof(float));
+            }
+            break;
+        case RENDER_PARTICLES:
+        {
+            Uint64 particle_start = SDL_GetPerformanceCounter();
+            m_particles->draw(data, data + command.count, data + command.count * 2, command.count, view, projection, m_stream);
+            m_particle_counts += SDL_GetPerformanceCounter() - particle_start;
+            break;
+        }
+        case RENDER_TILES:
+            if (m_core_renderer != NULL)
+            {
+                // Its dynamic buffer holds one quad, so the tiles go one at a time
+                glm::mat4 model = list.get_matrix(command.data_offset);
+                for (int vertex = 0; vertex + 6 <= command.count; vertex += 6)
+                {
+                    m_core_renderer->draw_quad(model, command.texture_id, data + MATRIX_FLOATS + vertex * 2, data + MATRIX_FLOATS + command.count * 2 + vertex * 2);
+                }
+            }
+            else
+            {
+                g_gl_state.use_program(m_program->get_program_id());
+                m_program->set_model_matrix(list.get_matrix(command.data_offset));
+                g_gl_state.bind_texture(command.texture_id);
+
+                glVertexAttribPointer(m_program->get_position_attribute(), 2, GL_FLOAT, false, 0, data + MATRIX_FLOATS);
+                glVertexAttribPointer(m_program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, data + MATRIX_FLOATS + command.count * 2);
+                g_gl_state.set_attributes(m_program->get_attribute_mask());
+
+                glDrawArrays(GL_TRIANGLES, 0, command.count);
+                g_render_stats.count_client_draw(GL_TRIANGLES, command.count, 4 * sizeof(float));
+            }
+            break;
+        }
+    }
+}
+
+// ————— COUNTS ————— //
+
+void CommandStreamCounts::add(const CommandList& list)
+{
+    frames++;
+    commands += (int) list.get_commands().size();
+    for (const RenderCommand& command : list.get_commands())
+    {
+        if (command.type == RENDER_QUAD) quads++;
+        if (command.type == RENDER_PARTICLES) particles += command.count;
+        if (command.type == RENDER_TILES) tiles += command.count / 6;
+    }
+    bytes += list.get_commands().size() * sizeof(RenderCommand) + list.get_data_size() * sizeof(float);
+}
+
+void CommandStreamCounts::print(const char* what) const
+{
+    if (frames == 0) return;
+    std::cout << what << ": " << frames << " frames | per frame " << (float) commands / frames << " commands, "
+        << (float) quads / frames << " quads, " << (float) tiles / frames << " tiles, " << (float) particles / frames << " particles, "
+        << bytes / frames / 1024.0f << " KiB" << std::endl;
+}
+
+// ————— RECORDING ————— //
+
+bool RecordingRenderBackend::start(const char* path)
+{
+    stop();
+    m_file = fopen(path, "wb");
+    if (m_file == NULL)
+    {
+        std::cout << "Unable to write command stream " << path << std::endl;
+        return false;
+    }
+
+    // The frame count is patched in once the stream is finished
+    CommandStreamHeader header = { COMMAND_STREAM_MAGIC, COMMAND_STREAM_VERSION, 0 };
+    fwrite(&header, sizeof(header), 1, m_file);
+    m_path = path;
+    m_counts = CommandStreamCounts();
+    return true;
+}
+
+void RecordingRenderBackend::stop()
+{
+    if (m_file == NULL) return;
+
+    CommandStreamHeader header = { COMMAND_STREAM_MAGIC, COMMAND_STREAM_VERSION, (unsigned int) m_counts.frames };
+    fseek(m_file, 0, SEEK_SET);
+    bool written = fwrite(&header, sizeof(header), 1, m_file) == 1;
+    written = fclose(m_file) == 0 && written;
+    m_file = NULL;
+
+    if (!written) std::cout << "Unable to write command stream " << m_path << std::endl;
+    else std::cout << "Recorded " << m_counts.frames << " frames of render commands to " << m_path << std::endl;
+}
+
+void RecordingRenderBackend::execute(const CommandList& list)
+{
+    if (m_file != NULL)
+    {
+        PROFILE_SCOPE("RecordingRenderBackend::execute");
+        const std::vector<RenderCommand>& commands = list.get_commands();
+        CommandStreamFrame frame = { (unsigned int) commands.size(), (unsigned int) list.get_data_size() };
+
+        bool written = fwrite(&frame, sizeof(frame), 1, m_file) == 1;
+        if (written && frame.command_count > 0) written = fwrite(commands.data(), sizeof(RenderCommand), frame.command_count, m_file) == frame.command_count;
+        if (written && frame.data_count > 0) written = fwrite(list.get_data(0), sizeof(float), frame.data_count, m_file) == frame.data_count;
+
+        if (written)
+        {
+            m_counts.add(list);
+        }
+        else
+        {
+            // Out of disk most likely; what's there so far is still readable
+            std::cout << "Unable to write command stream " << m_path << ", recording stopped" << std::endl;
+            stop();
+        }
+    }
+
+    if (m_next != NULL) m_next->execute(list);
+}
+
+void RecordingRenderBackend::print_summary() const
+{
+    m_counts.print("Command stream");
+    if (m_next != NULL) m_next->print_summary();
+}
+
+// ————— PLAYBACK ————— //
+
+// How many floats a command reads from the list's data
+static long long get_command_floats(const RenderCommand& command)
+{
+    switch (command.type)
+    {
+    case RENDER_CAMERA:    return MATRIX_FLOATS * 2;
+    case RENDER_QUAD:      return command.count == 0 ? MATRIX_FLOATS : MATRIX_FLOATS + QUAD_FLOATS * 2;
+    case RENDER_PARTICLES: return command.count * 3LL;
+    case RENDER_TILES:     return MATRIX_FLOATS + command.count * 4LL;
+    default:               return 0;
+    }
+}
+
+bool CommandStreamReader::open(const char* path)
+{
+    close();
+    m_file = fopen(path, "rb");
+    if (m_file == NULL)
+    {
+        std::cout << "Unable to open command stream " << path << std::endl;
+        return false;
+    }
+
+    if (fread(&m_header, sizeof(m_header), 1, m_file) != 1
+        || m_header.magic != COMMAND_STREAM_MAGIC || m_header.version != COMMAND_STREAM_VERSION)
+    {
+        std::cout << path << " isn't a command stream this build can read" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void CommandStreamReader::close()
+{
+    if (m_file != NULL) fclose(m_file);
+    m_file = NULL;
+    m_header = CommandStreamHeader();
+    m_frame = 0;
+}
+
+bool CommandStreamReader::next(CommandList* list)
+{
+    // Read to the end rather than to frame_count, so a stream from a run that
+    // never got to stop() still plays
+    if (m_file == NULL) return false;
+
+    CommandStreamFrame frame;
+    if (fread(&frame, sizeof(frame), 1, m_file) != 1) return false;
+    m_commands.resize(frame.command_count);
+    m_data.resize(frame.data_count);
+
+    bool valid = (frame.command_count == 0 || fread(m_commands.data(), sizeof(RenderCommand), frame.command_count, m_file) == frame.command_count)
+        && (frame.data_count == 0 || fread(m_data.data(), sizeof(float), frame.data_count, m_file) == frame.data_count);
+
+    // A command reaching past its frame's data would read out of bounds later
+    for (const RenderCommand& command : m_commands)
+    {
+        if (command.type < RENDER_CLEAR || command.type > RENDER_TILES || command.count < 0 || command.data_offset < 0
+            || command.data_offset + get_command_floats(command) > frame.data_count) valid = false;
+    }
+    if (!valid)
+    {
+        std::cout << "Command stream is damaged or cut short at frame " << m_frame << std::endl;
+        close();
+        return false;
+    }
+
+    list->assign(m_commands, m_data);
+    m_frame++;
+    return true;
+}
+
+void parse_render_backend_arguments(int argc, char* argv[], RendererType* renderer, const char** record_path, const char** replay_path,
+                                    const char** dump_path)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--renderer") == 0)
+        {
+            if (strcmp(argv[i + 1], "null") == 0) *renderer = RENDERER_NULL;
+            else if (strcmp(argv[i + 1], "software") == 0) *renderer = RENDERER_SOFTWARE;
+            else *renderer = RENDERER_GL;
+        }
+        if (strcmp(argv[i], "--record-commands") == 0) *record_path = argv[i + 1];
+        if (strcmp(argv[i], "--replay-commands") == 0) *replay_path = argv[i + 1];
+        if (strcmp(argv[i], "--dump-frame") == 0) *dump_path = argv[i + 1];
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <stdio.h>
+#include "CommandList.h"
+#include "CoreRenderer.h"
+#include "ParticleSystem.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+
+const unsigned int COMMAND_STREAM_MAGIC = 0x444D4352;     // "RCMD"
+const unsigned int COMMAND_STREAM_VERSION = 1;
+
+enum RendererType { RENDERER_GL, RENDERER_NULL, RENDERER_SOFTWARE };
+
+// What a recorded frame is executed on. The game records each frame into a
+// CommandList once; the backend decides what happens to it. GL draws it, the
+// null backend only counts it, so the CPU side of a frame can be measured
+// without a GPU, and the recording backend writes it to a file.
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() {};
+
+    // Called once a frame, on whichever thread owns the backend
+    virtual void execute(const CommandList& list) = 0;
+    virtual void print_summary() const {};
+};
+
+// Draws through the 2.1 sprite program, or CoreRenderer when there is one.
+// Needs the context current on the calling thread.
+class GLRenderBackend : public RenderBackend
+{
+private:
+    ShaderProgram*  m_program;
+    CoreRenderer*   m_core_renderer;    // NULL without --core
+    ParticleSystem* m_particles;
+    StreamBuffer*   m_stream;
+    Uint64 m_particle_counts = 0;       // time spent submitting particles, for the particle benchmark
+
+public:
+    GLRenderBackend(ShaderProgram* program, CoreRenderer* core_renderer, ParticleSystem* particles, StreamBuffer* stream)
+        : m_program(program), m_core_renderer(core_renderer), m_particles(particles), m_stream(stream) {};
+
+    void execute(const CommandList& list) override;
+
+    // Returns the particle submission time since the last call
+    Uint64 take_particle_counts() { Uint64 counts = m_particle_counts; m_particle_counts = 0; return counts; };
+};
+
+// What the null and recording backends saw, summed over every frame
+struct CommandStreamCounts
+{
+    int    frames = 0;
+    int    commands = 0;
+    int    quads = 0;
+    int    particles = 0;
+    int    tiles = 0;
+    size_t bytes = 0;           // the lists' command and float data
+
+    void add(const CommandList& list);
+    void print(const char* what) const;
+};
+
+// Drops every frame but keeps the counts
+class NullRenderBackend : public RenderBackend
+{
+private:
+    CommandStreamCounts m_counts;
+
+public:
+    void execute(const CommandList& list) override { m_counts.add(list); };
+    void print_summary() const override { m_counts.print("Null renderer"); };
+
+    const CommandStreamCounts& get_counts() const { return m_counts; };
+};
+
+// A command stream file is a header followed by one block per frame: the
+// command and float counts, then the RenderCommands and the floats as the
+// list held them. Texture names are written as they were, so a playback
+// has to load the same textures in the same order first.
+struct CommandStreamHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int frame_count;   // filled in by stop(); 0 if the run never got there
+};
+
+struct CommandStreamFrame
+{
+    unsigned int command_count;
+    unsigned int data_count;
+};
+
+// Writes every frame to a file, then hands it on to `next` (if any), so the
+// game can keep drawing while it records
+class RecordingRenderBackend : public RenderBackend
+{
+private:
+    RenderBackend* m_next;
+    FILE*          m_file = NULL;
+    const char*    m_path = NULL;
+    CommandStreamCounts m_counts;
+
+public:
+    RecordingRenderBackend(RenderBackend* next = NULL) : m_next(next) {};
+    ~RecordingRenderBackend() { stop(); };
+
+    bool start(const char* path);
+    // Finishes the header and closes the file
+    void stop();
+
+    void execute(const CommandList& list) override;
+    void print_summary() const override;
+
+    bool const is_recording() const { return m_file != NULL; };
+};
+
+// Reads a command stream back a frame at a time
+class CommandStreamReader
+{
+private:
+    FILE* m_file = NULL;
+    CommandStreamHeader m_header = {};
+    unsigned int m_frame = 0;
+    std::vector<RenderCommand> m_commands;
+    std::vector<float> m_data;
+
+public:
+    ~CommandStreamReader() { close(); };
+
+    bool open(const char* path);
+    void close();
+    // Fills `list` with the next frame; false at the end of the stream
+    bool next(CommandList* list);
+
+    unsigned int const get_frame_count() const { return m_header.frame_count; };
+    unsigned int const get_frame()       const { return m_frame; };
+};
+
+// Reads --renderer gl|null|software, --record-commands FILE, --replay-commands FILE
+// and --dump-frame FILE from the command line
+void parse_render_backend_arguments(int argc, char* argv[], RendererType* renderer, const char** record_path, const char** replay_path,
+                                    const char** dump_path);
@@ -0,0 +1,81 @@
+#include "RenderThread.h"
+#include "Profiler.h"
+
+void RenderThread::start(SDL_Window* window, SDL_GLContext context, ExecuteFunction execute)
+{
+    m_window = window;
+    m_context = context;
+    m_execute = execute;
+    m_running = true;
+    m_thread = std::thread([this]() { run(); });
+}
+
+void RenderThread::stop()
+{
+    if (!m_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+void RenderThread::run()
+{
+    SDL_GL_MakeCurrent(m_window, m_context);
+    g_profiler.set_thread_name("Render");
+
+    while (true)
+    {
+        int rendering;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_submitted || !m_running; });
+            if (!m_submitted) break;
+            rendering = 1 - m_recording;
+        }
+
+        // The simulation only touches the other list until this one is marked done
+        Uint64 start = SDL_GetPerformanceCounter();
+        m_execute(m_lists[rendering]);
+        {
+            PROFILE_SCOPE("swap");
+            SDL_GL_SwapWindow(m_window);
+        }
+        g_profiler.end_gpu_frame();
+        m_render_counts += SDL_GetPerformanceCounter() - start;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_submitted = false;
+        }
+        m_condition.notify_all();
+    }
+
+    SDL_GL_MakeCurrent(m_window, NULL);
+}
+
+void RenderThread::wait_idle()
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this]() { return !m_submitted; });
+    m_wait_counts += SDL_GetPerformanceCounter() - start;
+}
+
+void RenderThread::submit()
+{
+    wait_idle();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_recording = 1 - m_recording;
+        m_submitted = true;
+        m_frames++;
+    }
+    m_condition.notify_all();
+
+    m_lists[m_recording].reset();
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "CommandList.h"
+
+// Runs GL submission and the buffer swap on a thread of its own. The thread
+// owns the context; the simulation records frame N+1 into one command list
+// while frame N's list is executed and swapped, so a frame costs about
+// max(simulation, rendering) rather than their sum.
+//
+// Per frame on the simulation thread: record into get_command_list(), then
+// submit(). submit() only blocks when the previous frame hasn't been swapped
+// yet. Between wait_idle() and the next submit() the render thread is
+// guaranteed idle, which is when render-side state (stats) may be read.
+class RenderThread
+{
+public:
+    typedef void (*ExecuteFunction)(const CommandList& list);
+
+private:
+    SDL_Window*   m_window = NULL;
+    SDL_GLContext m_context = NULL;
+    ExecuteFunction m_execute = NULL;
+
+    CommandList m_lists[2];
+    int  m_recording = 0;           // list the simulation fills; the other belongs to the render thread
+
+    std::thread m_thread;
+    std::mutex  m_mutex;
+    std::condition_variable m_condition;
+    bool m_submitted = false;       // render thread has a list it hasn't finished swapping
+    bool m_running = false;
+
+    // ————— STATS ————— //
+    std::atomic<Uint64> m_render_counts{0};
+    Uint64 m_wait_counts = 0;       // simulation time spent waiting for the render thread
+    int    m_frames = 0;
+
+    void run();
+
+public:
+    ~RenderThread() { stop(); };
+
+    // The context must not be current on the calling thread any more
+    void start(SDL_Window* window, SDL_GLContext context, ExecuteFunction execute);
+    void stop();
+
+    CommandList* get_command_list() { return &m_lists[m_recording]; };
+    void wait_idle();
+    void submit();
+
+    bool   const is_running()       const { return m_running; };
+    int    const get_frames()       const { return m_frames; };
+    double const get_render_ms()    const { return m_render_counts * 1000.0 / SDL_GetPerformanceFrequency(); };
+    double const get_wait_ms()      const { return m_wait_counts * 1000.0 / SDL_GetPerformanceFrequency(); };
+
+    void reset_stats() { m_render_counts = 0; m_wait_counts = 0; m_frames = 0; };
+};
@@ -1,26 +1,84 @@
 #define GL_SILENCE_DEPRECATION
 
 #include "ShaderProgram.h"
+#include "Profiler.h"
+
+typedef void (APIENTRY *MaxShaderCompilerThreadsFunction)(GLuint count);
+
+// Lets the driver compile on its own threads; afterwards status queries only
+// block when they are made before the work is done
+static void enable_parallel_compile()
+{
+    static bool checked = false;
+    if (checked) return;
+    checked = true;
+
+    const char* extension = SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile") ? "glMaxShaderCompilerThreadsKHR"
+        : SDL_GL_ExtensionSupported("GL_ARB_parallel_shader_compile") ? "glMaxShaderCompilerThreadsARB" : NULL;
+    if (extension == NULL) return;
+
+    MaxShaderCompilerThreadsFunction max_threads = (MaxShaderCompilerThreadsFunction) SDL_GL_GetProcAddress(extension);
+    if (max_threads == NULL) return;
+
+    max_threads(0xFFFFFFFF);   // as many as the driver likes
+}
 
 void ShaderProgram::load(const char* vertex_shader_file, const char* fragment_shader_file) {
+    PROFILE_SCOPE("ShaderProgram::load");
+    start_load(vertex_shader_file, fragment_shader_file);
+    finish_load();
+}
+
+void ShaderProgram::start_load(const char* vertex_shader_file, const char* fragment_shader_file)
+{
+    PROFILE_SCOPE("ShaderProgram::start_load");
+    std::string vertex_source = read_shader_file(vertex_shader_file);
+    std::string fragment_source = read_shader_file(fragment_shader_file);
+
+    m_vertex_shader = 0;
+    m_fragment_shader = 0;
+
+    // A cached binary skips compiling and linking entirely
+    m_cache_key = program_cache_key(vertex_source, fragment_source);
+    m_program_id = program_cache_load(m_cache_key);
+    m_from_cache = m_program_id != 0;
+    PROFILE_MARK(m_from_cache ? "shader from cache" : "shader compile", vertex_shader_file);
+    if (m_from_cache) return;
+
+    enable_parallel_compile();
 
     // create the vertex shader
-    m_vertex_shader = load_shader_from_file(vertex_shader_file, GL_VERTEX_SHADER);
+    m_vertex_shader = load_shader_from_string(vertex_source, GL_VERTEX_SHADER);
     // create the fragment shader
-    m_fragment_shader = load_shader_from_file(fragment_shader_file, GL_FRAGMENT_SHADER);
+    m_fragment_shader = load_shader_from_string(fragment_source, GL_FRAGMENT_SHADER);
 
     // Create the final shader program from our vertex and fragment shaders
     m_program_id = glCreateProgram();
     glAttachShader(m_program_id, m_vertex_shader);
     glAttachShader(m_program_id, m_fragment_shader);
+    if (program_cache_supported()) glProgramParameteri(m_program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(m_program_id);
+}
 
-    GLint link_success;
-    glGetProgramiv(m_program_id, GL_LINK_STATUS, &link_success);
-
-    if (link_success == GL_FALSE)
+void ShaderProgram::finish_load()
+{
+    PROFILE_SCOPE("ShaderProgram::finish_load");
+    if (!m_from_cache)
     {
-        printf("Error linking shader program!\n");
+        GLint link_success;
+        glGetProgramiv(m_program_id, GL_LINK_STATUS, &link_success);
+
+        if (link_success == GL_FALSE)
+        {
+            // Compile errors are only looked at now, so the compiles never stall one another
+            print_shader_log(m_vertex_shader);
+            print_shader_log(m_fragment_shader);
+            printf("Error linking shader program!\n");
+        }
+        else
+        {
+            program_cache_save(m_cache_key, m_program_id);
+        }
     }
 
     m_model_matrix_uniform = glGetUniformLocation(m_program_id, "modelMatrix");
@@ -42,7 +100,7 @@ void ShaderProgram::cleanup()
     glDeleteShader(m_fragment_shader);
 }
 
-GLuint ShaderProgram::load_shader_from_file(const std::string& shaderFile, GLenum type)
+std::string ShaderProgram::read_shader_file(const std::string& shaderFile)
 {
     //Open a file stream with the file name
     std::ifstream infile(shaderFile);
@@ -55,8 +113,7 @@ GLuint ShaderProgram::load_shader_from_file(const std::string& shaderFile, GLenu
     std::stringstream buffer;
     buffer << infile.rdbuf();
 
-    // Load the shader from the contents of the file
-    return load_shader_from_string(buffer.str(), type);
+    return buffer.str();
 }
 
 GLuint ShaderProgram::load_shader_from_string(const std::string& shaderContents, GLenum type)
@@ -68,46 +125,61 @@ GLuint ShaderProgram::load_shader_from_string(const std::string& shaderContents,
     const char* shader_string = shaderContents.c_str();
     GLint shader_string_length = (GLint)shaderContents.size();
 
-    // Set the shader source to the string and compile shader
+    // Set the shader source to the string and compile shader. The status is
+    // checked in finish_load, once the link has had to wait for it anyway.
     glShaderSource(shaderID, 1, &shader_string, &shader_string_length);
     glCompileShader(shaderID);
 
+    // return the shader id
+    return shaderID;
+}
+
+void ShaderProgram::print_shader_log(GLuint shader)
+{
     // Check if the shader compiled properly
     GLint compile_success;
-    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &compile_success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_success);
 
     // If the shader did not compile, print the error to stdout
     if (compile_success == GL_FALSE)
     {
         GLchar messages[512];
-        glGetShaderInfoLog(shaderID, sizeof(messages), 0, &messages[0]);
+        glGetShaderInfoLog(shader, sizeof(messages), 0, &messages[0]);
         std::cout << messages << std::endl;
     }
-
-    // return the shader id
-    return shaderID;
 }
 
 void ShaderProgram::set_colour(float red, float green, float blue, float alpha)
 {
-    glUseProgram(m_program_id);
+    g_gl_state.use_program(m_program_id);
+    float colour[] = { red, green, blue, alpha };
+    if (!g_gl_state.uniform_changed(m_colour_value, m_colour_valid, colour, sizeof(colour))) return;
     glUniform4f(m_colour_uniform, red, green, blue, alpha);
 }
 
 void ShaderProgram::set_view_matrix(const glm::mat4& matrix)
 {
-    glUseProgram(m_program_id);
+    g_gl_state.use_program(m_program_id);
+    if (!g_gl_state.uniform_changed(&m_view_matrix_value, m_view_matrix_valid, &matrix, sizeof(glm::mat4))) return;
     glUniformMatrix4fv(m_view_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
 }
 
 void ShaderProgram::set_model_matrix(const glm::mat4& matrix)
 {
-    glUseProgram(m_program_id);
+    g_gl_state.use_program(m_program_id);
+    if (!g_gl_state.uniform_changed(&m_model_matrix_value, m_model_matrix_valid, &matrix, sizeof(glm::mat4))) return;
     glUniformMatrix4fv(m_model_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
 }
 
 void ShaderProgram::set_projection_matrix(const glm::mat4& matrix)
 {
-    glUseProgram(m_program_id);
+    g_gl_state.use_program(m_program_id);
+    if (!g_gl_state.uniform_changed(&m_projection_matrix_value, m_projection_matrix_valid, &matrix, sizeof(glm::mat4))) return;
     glUniformMatrix4fv(m_projection_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+}
+
+void ShaderProgram::bind_uniform_block(const char* block_name, GLuint binding)
+{
+    GLuint block_index = glGetUniformBlockIndex(m_program_id, block_name);
+    if (block_index != GL_INVALID_INDEX) glUniformBlockBinding(m_program_id, block_index, binding);
 }
\ No newline at end of file
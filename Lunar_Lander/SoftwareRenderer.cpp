@@ -0,0 +1,593 @@
+#include "SoftwareRenderer.h"
+#include "Profiler.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// SOFTWARE_RASTER_NO_AVX2 builds the scalar path alone, for checking the two
+// against each other
+#if !defined(SOFTWARE_RASTER_NO_AVX2) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define SOFTWARE_RASTER_AVX2 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+const int MATRIX_FLOATS = 16;
+const int QUAD_FLOATS = 12;        // 6 vertices x 2
+
+// ————— SPANS ————— //
+
+// A quad's run of pixels on one row. Everything is linear along the row, so
+// pixel k of the span has s = s + s_dx * k, and the same for t, u and v.
+struct QuadSpan
+{
+    float s, t, u, v;
+    float s_dx, t_dx, u_dx, v_dx;
+    const unsigned int* texels;
+    int texture_width;
+    int texture_height;
+};
+
+static inline unsigned int blend_pixel(unsigned int source, unsigned int destination)
+{
+    // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA on every channel, alpha included
+    float alpha = (source >> 24) * (1.0f / 255.0f);
+    float inverse = 1.0f - alpha;
+    unsigned int result = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        float blended = ((source >> shift) & 0xFF) * alpha + ((destination >> shift) & 0xFF) * inverse;
+        result |= (unsigned int) lrintf(blended) << shift;
+    }
+    return result;
+}
+
+static void fill_quad_span_scalar(unsigned int* pixels, int count, const QuadSpan& span)
+{
+    float max_u = (float) (span.texture_width - 1), max_v = (float) (span.texture_height - 1);
+
+    for (int k = 0; k < count; k++)
+    {
+        float s = span.s + span.s_dx * (float) k;
+        float t = span.t + span.t_dx * (float) k;
+        if (!(s >= 0.0f && s < 1.0f && t >= 0.0f && t < 1.0f)) continue;
+
+        // Nearest sampling; the clamp only matters for the last texel's edge
+        float u = fminf(fmaxf(span.u + span.u_dx * (float) k, 0.0f), max_u);
+        float v = fminf(fmaxf(span.v + span.v_dx * (float) k, 0.0f), max_v);
+        unsigned int texel = span.texels[(int) floorf(v) * span.texture_width + (int) floorf(u)];
+        if ((texel >> 24) == 0) continue;
+
+        pixels[k] = blend_pixel(texel, pixels[k]);
+    }
+}
+
+#ifdef SOFTWARE_RASTER_AVX2
+
+static bool cpu_has_avx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    // The OS has to save the YMM registers too, or the first AVX instruction faults
+    bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// Splits 8 RGBA pixels into one float vector per channel
+AVX2_TARGET static inline __m256 get_channel(__m256i pixels, int shift)
+{
+    return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixels, shift), _mm256_set1_epi32(0xFF)));
+}
+
+// The scalar loop 8 pixels at a time, with the same arithmetic in the same
+// order, so both give the same image. Loads and stores are masked to the
+// covered pixels: the span may run past the quad and the tile, and pixels
+// outside either belong to another primitive or another thread.
+AVX2_TARGET static void fill_quad_span_avx2(unsigned int* pixels, int count, const QuadSpan& span)
+{
+    const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    const __m256 max_u = _mm256_set1_ps((float) (span.texture_width - 1)), max_v = _mm256_set1_ps((float) (span.texture_height - 1));
+    const __m256i texture_width = _mm256_set1_epi32(span.texture_width);
+    const __m256 to_unit = _mm256_set1_ps(1.0f / 255.0f);
+
+    for (int k = 0; k < count; k += 8)
+    {
+        __m256 index = _mm256_add_ps(_mm256_set1_ps((float) k), lane);
+        __m256 s = _mm256_add_ps(_mm256_set1_ps(span.s), _mm256_mul_ps(_mm256_set1_ps(span.s_dx), index));
+        __m256 t = _mm256_add_ps(_mm256_set1_ps(span.t), _mm256_mul_ps(_mm256_set1_ps(span.t_dx), index));
+
+        __m256 covered = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(s, zero, _CMP_GE_OQ), _mm256_cmp_ps(s, one, _CMP_LT_OQ)),
+                                       _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, one, _CMP_LT_OQ)));
+        covered = _mm256_and_ps(covered, _mm256_cmp_ps(index, _mm256_set1_ps((float) count), _CMP_LT_OQ));
+        __m256i mask = _mm256_castps_si256(covered);
+        if (_mm256_testz_si256(mask, mask)) continue;
+
+        __m256 u = _mm256_add_ps(_mm256_set1_ps(span.u), _mm256_mul_ps(_mm256_set1_ps(span.u_dx), index));
+        __m256 v = _mm256_add_ps(_mm256_set1_ps(span.v), _mm256_mul_ps(_mm256_set1_ps(span.v_dx), index));
+        u = _mm256_min_ps(_mm256_max_ps(u, zero), max_u);
+        v = _mm256_min_ps(_mm256_max_ps(v, zero), max_v);
+        __m256i texel_index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(v)), texture_width),
+                                               _mm256_cvttps_epi32(_mm256_floor_ps(u)));
+        __m256i texels = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*) span.texels, texel_index, mask, 4);
+
+        // Fully transparent texels leave the pixel as it was
+        __m256i source_alpha = _mm256_srli_epi32(texels, 24);
+        mask = _mm256_andnot_si256(_mm256_cmpeq_epi32(source_alpha, _mm256_setzero_si256()), mask);
+        if (_mm256_testz_si256(mask, mask)) continue;
+
+        __m256i destination = _mm256_maskload_epi32((const int*) pixels + k, mask);
+        __m256 alpha = _mm256_mul_ps(_mm256_cvtepi32_ps(source_alpha), to_unit);
+        __m256 inverse = _mm256_sub_ps(one, alpha);
+
+        __m256i result = _mm256_setzero_si256();
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            __m256 blended = _mm256_add_ps(_mm256_mul_ps(get_channel(texels, shift), alpha), _mm256_mul_ps(get_channel(destination, shift), inverse));
+            result = _mm256_or_si256(result, _mm256_slli_epi32(_mm256_cvtps_epi32(blended), shift));
+        }
+        _mm256_maskstore_epi32((int*) pixels + k, mask, result);
+    }
+}
+
+#endif
+
+// Narrows [begin, end) to the pixels where value(k) = start + step * k is in
+// [0, 1), with a pixel to spare either side; the exact test is per pixel
+static void narrow_span(float start, float step, int* begin, int* end)
+{
+    if (fabsf(step) < 1e-12f)
+    {
+        if (!(start >= 0.0f && start < 1.0f)) *end = *begin;
+        return;
+    }
+
+    float first = (0.0f - start) / step, last = (1.0f - start) / step;
+    if (first > last) std::swap(first, last);
+    // Clamped before the casts, for quads far off the row
+    first = std::min(std::max(first, (float) *begin - 2.0f), (float) *end + 2.0f);
+    last = std::min(std::max(last, (float) *begin - 2.0f), (float) *end + 2.0f);
+
+    *begin = std::max(*begin, (int) floorf(first) - 1);
+    *end = std::min(*end, (int) ceilf(last) + 1);
+}
+
+// ————— SETUP ————— //
+
+void SoftwareRenderBackend::start(int width, int height, int threads)
+{
+    stop();
+    m_width = width;
+    m_height = height;
+    m_tiles_x = (width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    m_tiles_y = (height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    m_framebuffer.assign((size_t) width * height, m_clear_colour);
+    m_bins.assign(m_tiles_x * m_tiles_y, std::vector<int>());
+
+#ifdef SOFTWARE_RASTER_AVX2
+    m_use_avx2 = cpu_has_avx2();
+#endif
+
+    // The calling thread takes tiles too, so it counts as one
+    if (threads <= 0) threads = (int) std::thread::hardware_concurrency();
+    m_running = true;
+    for (int i = 1; i < threads; i++) m_workers.push_back(std::thread(&SoftwareRenderBackend::run_worker, this));
+}
+
+void SoftwareRenderBackend::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_running = false;
+    }
+    m_start_condition.notify_all();
+    for (std::thread& worker : m_workers) worker.join();
+    m_workers.clear();
+}
+
+GLuint SoftwareRenderBackend::load_texture(const char* filepath)
+{
+    int width, height, number_of_components;
+    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
+    if (image == NULL)
+    {
+        std::cout << "Unable to load image. Make sure the path is correct." << '\n' << filepath << std::endl;
+        return 0;
+    }
+
+    Texture texture;
+    texture.width = width;
+    texture.height = height;
+    texture.pixels.resize((size_t) width * height);
+    memcpy(texture.pixels.data(), image, texture.pixels.size() * 4);
+    stbi_image_free(image);
+
+    m_textures.push_back(std::move(texture));
+    return (GLuint) m_textures.size();
+}
+
+void SoftwareRenderBackend::set_clear_colour(const glm::vec4& colour)
+{
+    // Clamped the way glClearColor clamps
+    m_clear_colour = 0;
+    for (int channel = 0; channel < 4; channel++)
+    {
+        float value = std::min(std::max(colour[channel], 0.0f), 1.0f);
+        m_clear_colour |= (unsigned int) lrintf(value * 255.0f) << (channel * 8);
+    }
+}
+
+void SoftwareRenderBackend::add_quad(const glm::mat4& matrix, const float* vertices, const float* tex_coords, const Texture* texture)
+{
+    // Corners 0, 1 and 5 are the quad's origin and the ends of its two edges;
+    // the other three repeat them or complete the parallelogram
+    glm::vec2 corners[3], uvs[3];
+    const int corner_vertex[3] = { 0, 1, 5 };
+    for (int i = 0; i < 3; i++)
+    {
+        int vertex = corner_vertex[i];
+        glm::vec4 clip = matrix * glm::vec4(vertices[vertex * 2], vertices[vertex * 2 + 1], 0.0f, 1.0f);
+        corners[i] = glm::vec2((clip.x / clip.w + 1.0f) * 0.5f * m_width, (1.0f - clip.y / clip.w) * 0.5f * m_height);
+        uvs[i] = glm::vec2(tex_coords[vertex * 2] * texture->width, tex_coords[vertex * 2 + 1] * texture->height);
+    }
+
+    glm::vec2 edge_s = corners[1] - corners[0], edge_t = corners[2] - corners[0];
+    float determinant = edge_s.x * edge_t.y - edge_s.y * edge_t.x;
+    // Edge on or collapsed: GL draws nothing either
+    if (fabsf(determinant) < 1e-6f) return;
+
+    glm::vec2 far_corner = corners[1] + edge_t;
+    float min_x = std::min(std::min(corners[0].x, corners[1].x), std::min(corners[2].x, far_corner.x));
+    float max_x = std::max(std::max(corners[0].x, corners[1].x), std::max(corners[2].x, far_corner.x));
+    float min_y = std::min(std::min(corners[0].y, corners[1].y), std::min(corners[2].y, far_corner.y));
+    float max_y = std::max(std::max(corners[0].y, corners[1].y), std::max(corners[2].y, far_corner.y));
+    if (max_x <= 0.0f || max_y <= 0.0f || min_x >= m_width || min_y >= m_height) return;
+
+    Primitive quad;
+    quad.type = PRIMITIVE_QUAD;
+    quad.min_x = std::max((int) floorf(min_x), 0);
+    quad.min_y = std::max((int) floorf(min_y), 0);
+    quad.max_x = std::min((int) ceilf(max_x), m_width);
+    quad.max_y = std::min((int) ceilf(max_y), m_height);
+    quad.texture = texture;
+    quad.origin_x = corners[0].x;
+    quad.origin_y = corners[0].y;
+
+    // (s, t) is where a point sits along the two edges: the inverse of the
+    // 2x2 matrix with the edges as its columns
+    quad.s_dx = edge_t.y / determinant;
+    quad.s_dy = -edge_t.x / determinant;
+    quad.t_dx = -edge_s.y / determinant;
+    quad.t_dy = edge_s.x / determinant;
+
+    glm::vec2 uv_s = uvs[1] - uvs[0], uv_t = uvs[2] - uvs[0];
+    quad.u_origin = uvs[0].x;
+    quad.u_dx = uv_s.x * quad.s_dx + uv_t.x * quad.t_dx;
+    quad.u_dy = uv_s.x * quad.s_dy + uv_t.x * quad.t_dy;
+    quad.v_origin = uvs[0].y;
+    quad.v_dx = uv_s.y * quad.s_dx + uv_t.y * quad.t_dx;
+    quad.v_dy = uv_s.y * quad.s_dy + uv_t.y * quad.t_dy;
+    quad.alpha = 1.0f;
+
+    m_primitives.push_back(quad);
+    bin((int) m_primitives.size() - 1);
+}
+
+void SoftwareRenderBackend::add_point(const glm::mat4& matrix, float x, float y, float alpha)
+{
+    // GL drops a point whose centre is off screen, however big it is
+    glm::vec4 clip = matrix * glm::vec4(x, y, 0.0f, 1.0f);
+    float ndc_x = clip.x / clip.w, ndc_y = clip.y / clip.w;
+    if (!(ndc_x >= -1.0f && ndc_x <= 1.0f && ndc_y >= -1.0f && ndc_y <= 1.0f)) return;
+
+    Primitive point;
+    point.type = PRIMITIVE_POINT;
+    point.origin_x = (ndc_x + 1.0f) * 0.5f * m_width;
+    point.origin_y = (1.0f - ndc_y) * 0.5f * m_height;
+    float half = m_point_size * 0.5f;
+    point.min_x = std::max((int) floorf(point.origin_x - half), 0);
+    point.min_y = std::max((int) floorf(point.origin_y - half), 0);
+    point.max_x = std::min((int) ceilf(point.origin_x + half) + 1, m_width);
+    point.max_y = std::min((int) ceilf(point.origin_y + half) + 1, m_height);
+    point.texture = NULL;
+    point.alpha = alpha;
+    if (point.min_x >= point.max_x || point.min_y >= point.max_y) return;
+
+    m_primitives.push_back(point);
+    bin((int) m_primitives.size() - 1);
+}
+
+void SoftwareRenderBackend::bin(int index)
+{
+    const Primitive& primitive = m_primitives[index];
+    int first_x = primitive.min_x / SOFTWARE_TILE_SIZE, last_x = (primitive.max_x - 1) / SOFTWARE_TILE_SIZE;
+    int first_y = primitive.min_y / SOFTWARE_TILE_SIZE, last_y = (primitive.max_y - 1) / SOFTWARE_TILE_SIZE;
+
+    for (int tile_y = first_y; tile_y <= last_y; tile_y++)
+    {
+        for (int tile_x = first_x; tile_x <= last_x; tile_x++) m_bins[tile_y * m_tiles_x + tile_x].push_back(index);
+    }
+}
+
+void SoftwareRenderBackend::execute(const CommandList& list)
+{
+    PROFILE_SCOPE("SoftwareRenderBackend::execute");
+    if (m_width == 0) return;
+    Uint64 start_counts = SDL_GetPerformanceCounter();
+
+    const float quad_vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
+    const float quad_tex_coords[] = { 0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
+    glm::mat4 camera(1.0f);
+
+    m_primitives.clear();
+    for (std::vector<int>& tile : m_bins) tile.clear();
+    m_point_colour = m_particles->get_colour();
+    m_point_size = m_particles->get_point_size();
+
+    {
+        PROFILE_SCOPE("SoftwareRenderBackend::bin");
+        for (const RenderCommand& command : list.get_commands())
+        {
+            const float* data = list.get_data(command.data_offset);
+
+            switch (command.type)
+            {
+            case RENDER_CLEAR:
+            {
+                // Every tile starts over at this point in its list
+                Primitive clear;
+                clear.type = PRIMITIVE_CLEAR;
+                clear.min_x = clear.min_y = 0;
+                clear.max_x = m_width;
+                clear.max_y = m_height;
+                m_primitives.push_back(clear);
+                bin((int) m_primitives.size() - 1);
+                break;
+            }
+            case RENDER_CAMERA:
+                camera = list.get_matrix(command.data_offset + MATRIX_FLOATS) * list.get_matrix(command.data_offset);
+                break;
+            case RENDER_QUAD:
+                // A texture that never loaded is left out, as GL's empty placeholder would be
+                if (command.texture_id == 0 || command.texture_id > m_textures.size()) break;
+                if (command.count == 0) add_quad(camera * list.get_matrix(command.data_offset), quad_vertices, quad_tex_coords, &m_textures[command.texture_id - 1]);
+                else add_quad(camera * list.get_matrix(command.data_offset), data + MATRIX_FLOATS, data + MATRIX_FLOATS + QUAD_FLOATS, &m_textures[command.texture_id - 1]);
+                break;
+            case RENDER_PARTICLES:
+                for (int i = 0; i < command.count; i++) add_point(camera, data[i], data[command.count + i], data[command.count * 2 + i]);
+                break;
+            case RENDER_TILES:
+            {
+                // Each tile is its own six-vertex quad, so it bins like any other
+                if (command.texture_id == 0 || command.texture_id > m_textures.size()) break;
+                glm::mat4 matrix = camera * list.get_matrix(command.data_offset);
+                const float* tex_coords = data + MATRIX_FLOATS + command.count * 2;
+                for (int vertex = 0; vertex + 6 <= command.count; vertex += 6)
+                {
+                    add_quad(matrix, data + MATRIX_FLOATS + vertex * 2, tex_coords + vertex * 2, &m_textures[command.texture_id - 1]);
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    {
+        PROFILE_SCOPE("SoftwareRenderBackend::rasterize");
+        m_next_tile = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busy = (int) m_workers.size();
+            m_generation++;
+        }
+        m_start_condition.notify_all();
+
+        rasterize_tiles();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_condition.wait(lock, [this]() { return m_busy == 0; });
+    }
+
+    m_frames++;
+    m_counts += SDL_GetPerformanceCounter() - start_counts;
+}
+
+// ————— RASTERIZE ————— //
+
+void SoftwareRenderBackend::run_worker()
+{
+    g_profiler.set_thread_name("Software rasterizer");
+    int generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start_condition.wait(lock, [this, generation]() { return m_generation != generation || !m_running; });
+            if (!m_running) return;
+            generation = m_generation;
+        }
+
+        rasterize_tiles();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy == 0) m_done_condition.notify_one();
+    }
+}
+
+void SoftwareRenderBackend::rasterize_tiles()
+{
+    int tile_count = m_tiles_x * m_tiles_y;
+    for (int tile = m_next_tile++; tile < tile_count; tile = m_next_tile++) rasterize_tile(tile);
+}
+
+void SoftwareRenderBackend::rasterize_tile(int tile)
+{
+    int x0 = (tile % m_tiles_x) * SOFTWARE_TILE_SIZE, y0 = (tile / m_tiles_x) * SOFTWARE_TILE_SIZE;
+    int x1 = std::min(x0 + SOFTWARE_TILE_SIZE, m_width), y1 = std::min(y0 + SOFTWARE_TILE_SIZE, m_height);
+
+    for (int index : m_bins[tile])
+    {
+        const Primitive& primitive = m_primitives[index];
+        // Clipped to the tile, so nothing here writes another thread's pixels
+        int min_x = std::max(primitive.min_x, x0), max_x = std::min(primitive.max_x, x1);
+        int min_y = std::max(primitive.min_y, y0), max_y = std::min(primitive.max_y, y1);
+
+        switch (primitive.type)
+        {
+        case PRIMITIVE_CLEAR:
+            for (int y = min_y; y < max_y; y++) std::fill(&m_framebuffer[(size_t) y * m_width + min_x], &m_framebuffer[(size_t) y * m_width + max_x], m_clear_colour);
+            break;
+        case PRIMITIVE_QUAD:
+            fill_quad(primitive, min_x, min_y, max_x, max_y);
+            break;
+        case PRIMITIVE_POINT:
+            fill_point(primitive, min_x, min_y, max_x, max_y);
+            break;
+        }
+    }
+}
+
+void SoftwareRenderBackend::fill_quad(const Primitive& quad, int x0, int y0, int x1, int y1)
+{
+    QuadSpan span;
+    span.s_dx = quad.s_dx;
+    span.t_dx = quad.t_dx;
+    span.u_dx = quad.u_dx;
+    span.v_dx = quad.v_dx;
+    span.texels = quad.texture->pixels.data();
+    span.texture_width = quad.texture->width;
+    span.texture_height = quad.texture->height;
+
+    for (int y = y0; y < y1; y++)
+    {
+        // Everything at the first pixel centre of the row, then the span is
+        // cut down to where the quad can be
+        float dx = (float) x0 + 0.5f - quad.origin_x, dy = (float) y + 0.5f - quad.origin_y;
+        float row_s = quad.s_dx * dx + quad.s_dy * dy;
+        float row_t = quad.t_dx * dx + quad.t_dy * dy;
+
+        int begin = 0, end = x1 - x0;
+        narrow_span(row_s, quad.s_dx, &begin, &end);
+        narrow_span(row_t, quad.t_dx, &begin, &end);
+        if (begin >= end) continue;
+
+        dx += (float) begin;
+        span.s = quad.s_dx * dx + quad.s_dy * dy;
+        span.t = quad.t_dx * dx + quad.t_dy * dy;
+        span.u = quad.u_origin + quad.u_dx * dx + quad.u_dy * dy;
+        span.v = quad.v_origin + quad.v_dx * dx + quad.v_dy * dy;
+
+        unsigned int* pixels = &m_framebuffer[(size_t) y * m_width + x0 + begin];
+#ifdef SOFTWARE_RASTER_AVX2
+        if (m_use_avx2)
+        {
+            fill_quad_span_avx2(pixels, end - begin, span);
+            continue;
+        }
+#endif
+        fill_quad_span_scalar(pixels, end - begin, span);
+    }
+}
+
+void SoftwareRenderBackend::fill_point(const Primitive& point, int x0, int y0, int x1, int y1)
+{
+    // The particle shader: a flat colour faded towards the edge of the point
+    // (see fragment_particle.glsl), over the pixels whose centres it covers
+    float half = m_point_size * 0.5f, inverse_size = 1.0f / m_point_size;
+    unsigned int colour = 0;
+    for (int channel = 0; channel < 3; channel++) colour |= (unsigned int) lrintf(std::min(std::max(m_point_colour[channel], 0.0f), 1.0f) * 255.0f) << (channel * 8);
+
+    for (int y = y0; y < y1; y++)
+    {
+        float centre_y = (float) y + 0.5f;
+        if (!(centre_y > point.origin_y - half && centre_y <= point.origin_y + half)) continue;
+        float offset_y = (centre_y - point.origin_y) * inverse_size;
+
+        for (int x = x0; x < x1; x++)
+        {
+            float centre_x = (float) x + 0.5f;
+            if (!(centre_x >= point.origin_x - half && centre_x < point.origin_x + half)) continue;
+            float offset_x = (centre_x - point.origin_x) * inverse_size;
+
+            float falloff = 1.0f - std::min(std::max((offset_x * offset_x + offset_y * offset_y) * 4.0f, 0.0f), 1.0f);
+            float alpha = std::min(std::max(m_point_colour.a * point.alpha * falloff, 0.0f), 1.0f);
+            unsigned int source_alpha = (unsigned int) lrintf(alpha * 255.0f);
+            if (source_alpha == 0) continue;
+
+            unsigned int& pixel = m_framebuffer[(size_t) y * m_width + x];
+            pixel = blend_pixel(colour | (source_alpha << 24), pixel);
+        }
+    }
+}
+
+void SoftwareRenderBackend::print_summary() const
+{
+    if (m_frames == 0) return;
+    std::cout << "Software renderer: " << m_frames << " frames | " << m_counts * 1000.0 / SDL_GetPerformanceFrequency() / m_frames
+        << " ms per frame | " << (m_use_avx2 ? "AVX2" : "scalar") << " spans, " << m_workers.size() + 1 << " threads" << std::endl;
+}
+
+// ————— IMAGES ————— //
+
+bool SoftwareRenderBackend::write_tga(const char* path) const
+{
+    return ::write_tga(path, m_width, m_height, m_framebuffer.data(), false);
+}
+
+bool write_tga(const char* path, int width, int height, const unsigned int* pixels, bool bottom_up)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        std::cout << "Unable to write image " << path << std::endl;
+        return false;
+    }
+
+    // Uncompressed true colour, 32 bits with 8 of alpha; bit 5 of the last
+    // byte says the rows start at the top
+    unsigned char header[18] = {};
+    header[2] = 2;
+    header[12] = (unsigned char) (width & 0xFF);
+    header[13] = (unsigned char) (width >> 8);
+    header[14] = (unsigned char) (height & 0xFF);
+    header[15] = (unsigned char) (height >> 8);
+    header[16] = 32;
+    header[17] = bottom_up ? 8 : 8 | 0x20;
+    bool written = fwrite(header, sizeof(header), 1, file) == 1;
+
+    // TGA stores BGRA
+    std::vector<unsigned char> row((size_t) width * 4);
+    for (int y = 0; y < height && written; y++)
+    {
+        const unsigned char* source = (const unsigned char*) (pixels + (size_t) y * width);
+        for (int x = 0; x < width; x++)
+        {
+            row[x * 4 + 0] = source[x * 4 + 2];
+            row[x * 4 + 1] = source[x * 4 + 1];
+            row[x * 4 + 2] = source[x * 4 + 0];
+            row[x * 4 + 3] = source[x * 4 + 3];
+        }
+        written = fwrite(row.data(), row.size(), 1, file) == 1;
+    }
+
+    written = fclose(file) == 0 && written;
+    if (!written) std::cout << "Unable to write image " << path << std::endl;
+    return written;
+}
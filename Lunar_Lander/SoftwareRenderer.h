@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "RenderBackend.h"
+
+const int SOFTWARE_TILE_SIZE = 64;     // pixels per side; a tile belongs to one thread at a time
+
+// Draws recorded frames on the CPU into an RGBA framebuffer, for machines
+// with no GPU. It does what the GL path does closely enough for golden-image
+// checks: nearest texture sampling, source-alpha blending, coverage tested at
+// pixel centres, and particles as soft round points of the same size.
+//
+// Every quad the game draws, map tiles included, is a rectangle under an
+// affine transform, so it is filled as a parallelogram: each pixel centre
+// maps back to (s, t) on the quad and is covered when both are in [0, 1).
+// The frame is set up and binned into tiles on the calling thread; worker
+// threads then take whole tiles, so no two threads touch the same pixel and
+// every tile sees its primitives in submission order. Spans go 8 pixels at a
+// time with AVX2 where the CPU has it, picked at run time, and one pixel at a
+// time otherwise.
+class SoftwareRenderBackend : public RenderBackend
+{
+private:
+    struct Texture
+    {
+        int width;
+        int height;
+        std::vector<unsigned int> pixels;   // RGBA bytes, top row first as stb_image loads it
+    };
+
+    enum PrimitiveType { PRIMITIVE_CLEAR, PRIMITIVE_QUAD, PRIMITIVE_POINT };
+
+    // One draw in screen space. For a quad, s, t, u and v are linear in the
+    // pixel position: value = at_origin + dx * (x - origin_x) + dy * (y - origin_y).
+    // u and v are in texels.
+    struct Primitive
+    {
+        PrimitiveType type;
+        int min_x, min_y, max_x, max_y;     // pixel bounds, max exclusive
+        const Texture* texture;
+        float origin_x, origin_y;           // quad: first corner; point: centre
+        float s_dx, s_dy, t_dx, t_dy;
+        float u_origin, u_dx, u_dy;
+        float v_origin, v_dx, v_dy;
+        float alpha;                        // point only
+    };
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_tiles_x = 0;
+    int m_tiles_y = 0;
+    std::vector<unsigned int> m_framebuffer;    // top row first
+    std::vector<Texture> m_textures;            // texture name n is m_textures[n - 1]
+    unsigned int m_clear_colour = 0xFF000000;
+
+    ParticleSystem* m_particles;
+    glm::vec4 m_point_colour;
+    float     m_point_size = 1.0f;
+    bool m_use_avx2 = false;
+
+    std::vector<Primitive> m_primitives;
+    std::vector<std::vector<int>> m_bins;       // primitive indices per tile, in submission order
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start_condition;
+    std::condition_variable m_done_condition;
+    bool m_running = false;
+    int  m_generation = 0;                      // bumped once per frame to wake the workers
+    int  m_busy = 0;                            // workers still on this frame
+    std::atomic<int> m_next_tile{0};
+
+    // ————— STATS ————— //
+    int    m_frames = 0;
+    Uint64 m_counts = 0;
+
+    void add_quad(const glm::mat4& matrix, const float* vertices, const float* tex_coords, const Texture* texture);
+    void add_point(const glm::mat4& matrix, float x, float y, float alpha);
+    void bin(int index);
+
+    void run_worker();
+    void rasterize_tiles();
+    void rasterize_tile(int tile);
+    void fill_quad(const Primitive& quad, int x0, int y0, int x1, int y1);
+    void fill_point(const Primitive& point, int x0, int y0, int x1, int y1);
+
+public:
+    SoftwareRenderBackend(ParticleSystem* particles) : m_particles(particles) {};
+    ~SoftwareRenderBackend() { stop(); };
+
+    // 0 threads uses every core; the calling thread counts as one of them
+    void start(int width, int height, int threads = 0);
+    void stop();
+
+    // Decodes the file for this backend alone; returns 0 if it can't be read
+    GLuint load_texture(const char* filepath);
+    void set_clear_colour(const glm::vec4& colour);
+
+    void execute(const CommandList& list) override;
+    void print_summary() const override;
+
+    // The last frame executed
+    bool write_tga(const char* path) const;
+
+    const unsigned int* get_framebuffer() const { return m_framebuffer.data(); };
+    int  const get_width()       const { return m_width;    };
+    int  const get_height()      const { return m_height;   };
+    bool const is_using_avx2()   const { return m_use_avx2; };
+};
+
+// Writes RGBA pixels as an uncompressed 32-bit TGA. `bottom_up` is for rows
+// read back from GL, which start at the bottom of the window.
+bool write_tga(const char* path, int width, int height, const unsigned int* pixels, bool bottom_up);
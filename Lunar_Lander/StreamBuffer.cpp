@@ -0,0 +1,158 @@
+#include "StreamBuffer.h"
+#include <string.h>
+
+const size_t STREAM_BUFFER_ALIGNMENT = 64;
+const GLuint64 FENCE_POLL_NANOSECONDS = 1000000;
+
+void StreamBuffer::create(size_t segment_size)
+{
+    m_persistent = SDL_GL_ExtensionSupported("GL_ARB_buffer_storage") == SDL_TRUE;
+    allocate(segment_size);
+}
+
+void StreamBuffer::allocate(size_t segment_size)
+{
+    m_segment_size = (segment_size + STREAM_BUFFER_ALIGNMENT - 1) & ~(STREAM_BUFFER_ALIGNMENT - 1);
+    m_segment = 0;
+    m_offset = 0;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+    if (m_persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, m_segment_size * STREAM_BUFFER_SEGMENTS, NULL, flags);
+        m_mapped = (char*) glMapBufferRange(GL_ARRAY_BUFFER, 0, m_segment_size * STREAM_BUFFER_SEGMENTS, flags);
+        if (m_mapped == NULL)
+        {
+            // Extension advertised but the mapping failed; drop to the orphaning path
+            glDeleteBuffers(1, &m_buffer);
+            glGenBuffers(1, &m_buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+            m_persistent = false;
+        }
+    }
+    if (!m_persistent)
+    {
+        glBufferData(GL_ARRAY_BUFFER, m_segment_size, NULL, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::release()
+{
+    for (int i = 0; i < STREAM_BUFFER_SEGMENTS; i++)
+    {
+        if (m_fences[i] != NULL) glDeleteSync(m_fences[i]);
+        m_fences[i] = NULL;
+    }
+
+    if (m_mapped != NULL)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_mapped = NULL;
+    }
+    // GL keeps the storage alive until draws already issued from it are done
+    glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+}
+
+void StreamBuffer::wait_for_segment(int segment)
+{
+    GLsync fence = m_fences[segment];
+    if (fence == NULL) return;
+
+    // The common case is that the GPU finished this segment long ago
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+    {
+        m_fence_waits++;
+        Uint64 start = SDL_GetPerformanceCounter();
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_POLL_NANOSECONDS);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        m_fence_wait_counts += SDL_GetPerformanceCounter() - start;
+    }
+
+    glDeleteSync(fence);
+    m_fences[segment] = NULL;
+}
+
+void StreamBuffer::start_frame()
+{
+    m_frame_started = true;
+    m_offset = 0;
+
+    if (m_persistent)
+    {
+        wait_for_segment(m_segment);
+    }
+    else
+    {
+        // Orphan: the driver hands back fresh storage and keeps the old block
+        // alive for whatever is still drawing from it
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        glBufferData(GL_ARRAY_BUFFER, m_segment_size, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void* StreamBuffer::reserve(size_t bytes, size_t& offset)
+{
+    if (!m_frame_started) start_frame();
+
+    size_t aligned = (bytes + STREAM_BUFFER_ALIGNMENT - 1) & ~(STREAM_BUFFER_ALIGNMENT - 1);
+    if (m_offset + aligned > m_segment_size)
+    {
+        // Too small for this frame: start over with room for everything so far
+        size_t needed = m_offset + aligned;
+        release();
+        allocate(needed * 2);
+        m_grows++;
+        start_frame();
+    }
+
+    size_t segment_offset = m_offset;
+    m_offset += aligned;
+    m_bytes_streamed += bytes;
+
+    if (m_persistent)
+    {
+        offset = m_segment * m_segment_size + segment_offset;
+        return m_mapped + offset;
+    }
+
+    offset = segment_offset;
+    if (m_staging.size() < bytes) m_staging.resize(bytes);
+    m_staging_offset = segment_offset;
+    m_staging_bytes = bytes;
+    return m_staging.data();
+}
+
+void StreamBuffer::commit()
+{
+    // Coherent persistent writes are already visible to the GPU
+    if (m_persistent || m_staging_bytes == 0) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, m_staging_offset, m_staging_bytes, m_staging.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_staging_bytes = 0;
+}
+
+void StreamBuffer::end_frame()
+{
+    if (!m_frame_started) return;
+    m_frame_started = false;
+
+    if (m_persistent)
+    {
+        m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_segment = (m_segment + 1) % STREAM_BUFFER_SEGMENTS;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include <stddef.h>
+#include <vector>
+
+const int STREAM_BUFFER_SEGMENTS = 3;   // frames the GPU may still be reading from
+
+// Ring of per-frame segments in one vertex buffer for geometry that changes
+// every frame. With GL 4.4 / ARB_buffer_storage the buffer stays mapped and
+// writes land straight in it; a fence per segment keeps the CPU from writing
+// over a frame the GPU hasn't drawn yet. Older contexts orphan the buffer once
+// a frame and upload with glBufferSubData instead.
+//
+// Usage per draw: write = reserve(bytes, offset), fill it, commit(), then bind
+// get_buffer() and point attributes at `offset`. Everything one draw reads has
+// to come from a single reserve, since a reserve that doesn't fit grows the
+// buffer and leaves earlier ranges of the frame in the old one.
+class StreamBuffer
+{
+private:
+    GLuint m_buffer = 0;
+    bool   m_persistent = false;
+    char*  m_mapped = NULL;
+    size_t m_segment_size = 0;
+
+    int    m_segment = 0;
+    size_t m_offset = 0;          // next free byte inside the current segment
+    GLsync m_fences[STREAM_BUFFER_SEGMENTS] = {};
+    bool   m_frame_started = false;
+
+    // Fallback path only: the reserved range is written here and uploaded on commit
+    std::vector<char> m_staging;
+    size_t m_staging_offset = 0;
+    size_t m_staging_bytes = 0;
+
+    // ————— STATS ————— //
+    int    m_fence_waits = 0;
+    Uint64 m_fence_wait_counts = 0;
+    int    m_grows = 0;
+    size_t m_bytes_streamed = 0;
+
+    void allocate(size_t segment_size);
+    void release();
+    void start_frame();
+    void wait_for_segment(int segment);
+
+public:
+    void create(size_t segment_size);
+
+    void* reserve(size_t bytes, size_t& offset);
+    void  commit();
+    // Call once per frame after the last draw that uses the buffer
+    void  end_frame();
+
+    GLuint const get_buffer()          const { return m_buffer; };
+    bool   const is_persistent()       const { return m_persistent; };
+    size_t const get_segment_size()    const { return m_segment_size; };
+    int    const get_fence_waits()     const { return m_fence_waits; };
+    double const get_fence_wait_ms()   const { return m_fence_wait_counts * 1000.0 / SDL_GetPerformanceFrequency(); };
+    int    const get_grows()           const { return m_grows; };
+    size_t const get_bytes_streamed()  const { return m_bytes_streamed; };
+
+    void reset_stats() { m_fence_waits = 0; m_fence_wait_counts = 0; m_grows = 0; m_bytes_streamed = 0; };
+};
@@ -0,0 +1,266 @@
+#include "TextureLoader.h"
+#include "stb_image.h"
+#include "Profiler.h"
+#include "GLState.h"
+#include <iostream>
+#include <string.h>
+
+#define LOG(argument) std::cout << argument << '\n'
+
+const int MAX_LOADER_THREADS = 4;
+
+void TextureLoader::start(int threads, size_t bytes_per_frame)
+{
+    if (threads <= 0) threads = SDL_GetCPUCount() - 1;
+    if (threads < 1) threads = 1;
+    if (threads > MAX_LOADER_THREADS) threads = MAX_LOADER_THREADS;
+
+    m_bytes_per_frame = bytes_per_frame;
+    m_s3tc_supported = SDL_GL_ExtensionSupported("GL_EXT_texture_compression_s3tc") == SDL_TRUE;
+    glGenBuffers(TEXTURE_UPLOAD_BUFFERS, m_pixel_buffers);
+
+    m_running = true;
+    for (int i = 0; i < threads; i++) m_workers.push_back(std::thread([this]() { run_worker(); }));
+}
+
+void TextureLoader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_condition.notify_all();
+    for (std::thread& worker : m_workers) worker.join();
+    m_workers.clear();
+
+    for (Job* job : m_queued) delete job;
+    for (Job* job : m_decoded) release(job);
+    m_queued.clear();
+    m_decoded.clear();
+
+    if (m_pixel_buffers[0] != 0) glDeleteBuffers(TEXTURE_UPLOAD_BUFFERS, m_pixel_buffers);
+    for (int i = 0; i < TEXTURE_UPLOAD_BUFFERS; i++)
+    {
+        m_pixel_buffers[i] = 0;
+        m_pixel_buffer_sizes[i] = 0;
+    }
+}
+
+GLuint TextureLoader::load(const char* filepath, GLint filter)
+{
+    PROFILE_SCOPE("TextureLoader::load");
+    const unsigned char placeholder[] = { 0, 0, 0, 0 };
+
+    Job* job = new Job();
+    job->filepath = filepath;
+    job->filter = filter;
+
+    glGenTextures(1, &job->texture_id);
+    g_gl_state.bind_texture(job->texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+    if (m_pending == 0) m_start_counts = SDL_GetPerformanceCounter();
+    m_pending++;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued.push_back(job);
+    }
+    m_condition.notify_one();
+
+    return job->texture_id;
+}
+
+void TextureLoader::run_worker()
+{
+    g_profiler.set_thread_name("Texture loader");
+
+    while (true)
+    {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return !m_queued.empty() || !m_running; });
+            if (!m_running) return;
+            job = m_queued.front();
+            m_queued.pop_front();
+        }
+        PROFILE_SCOPE("TextureLoader::decode");
+
+        // Compressed levels are no use without S3TC; the source is decoded instead
+        if (cooked_texture_open(job->filepath, job->cooked)
+            && (job->cooked.header->format == COOKED_RGBA8 || m_s3tc_supported))
+        {
+            const CookedTextureHeader* header = job->cooked.header;
+            job->width = header->width;
+            job->height = header->height;
+            job->bytes = job->cooked.size - header->level_offset[0];
+        }
+        else
+        {
+            cooked_texture_close(job->cooked);
+
+            int number_of_components;
+            job->pixels = stbi_load(job->filepath.c_str(), &job->width, &job->height, &number_of_components, STBI_rgb_alpha);
+            job->bytes = (size_t) job->width * job->height * 4;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_decoded.push_back(job);
+        }
+        m_condition.notify_all();
+    }
+}
+
+void TextureLoader::release(Job* job)
+{
+    if (job->pixels != NULL) stbi_image_free(job->pixels);
+    cooked_texture_close(job->cooked);
+    delete job;
+}
+
+void TextureLoader::fill_pixel_buffer(const void* data, size_t bytes)
+{
+    // The buffer after the last one used was filled a couple of uploads ago,
+    // so the GPU is normally done reading it. It only ever grows, so an upload
+    // that fits doesn't respecify its storage.
+    int index = m_next_pixel_buffer;
+    m_next_pixel_buffer = (m_next_pixel_buffer + 1) % TEXTURE_UPLOAD_BUFFERS;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixel_buffers[index]);
+    if (bytes > m_pixel_buffer_sizes[index])
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+        m_pixel_buffer_sizes[index] = bytes;
+    }
+
+    // Invalidating lets the driver hand out fresh memory rather than wait on
+    // a transfer still reading the old contents
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped != NULL)
+    {
+        memcpy(mapped, data, bytes);
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE) return;
+    }
+    // The mapping failed, or its contents were lost before the unmap
+    glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, bytes, data);
+}
+
+void TextureLoader::upload_cooked(Job* job)
+{
+    const CookedTextureHeader* header = job->cooked.header;
+    const GLenum compressed_formats[] = { 0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT };
+
+    // Every level in one copy, from the mapped file into the mapped buffer
+    size_t base = header->level_offset[0];
+    fill_pixel_buffer(job->cooked.data + base, job->bytes);
+
+    g_gl_state.bind_texture(job->texture_id);
+    for (unsigned int level = 0; level < header->level_count; level++)
+    {
+        GLsizei width = header->width >> level, height = header->height >> level;
+        if (width < 1) width = 1;
+        if (height < 1) height = 1;
+        const void* offset = (const void*) (size_t) (header->level_offset[level] - base);
+
+        if (header->format == COOKED_RGBA8) glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, offset);
+        else glCompressedTexImage2D(GL_TEXTURE_2D, level, compressed_formats[header->format], width, height, 0, header->level_size[level], offset);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Sample the mips when there are any, keeping the nearest/linear choice
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header->level_count - 1);
+    if (header->level_count > 1)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, job->filter == GL_NEAREST ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR);
+    }
+
+    m_loaded++;
+}
+
+void TextureLoader::upload(Job* job)
+{
+    PROFILE_SCOPE("TextureLoader::upload");
+    PROFILE_MARK("texture load", job->filepath.c_str());
+    if (job->cooked.data != NULL)
+    {
+        upload_cooked(job);
+        return;
+    }
+
+    if (job->pixels == NULL)
+    {
+        // The placeholder stays, so a missing sprite shows up as a gap rather than a crash
+        LOG("Unable to load image. Make sure the path is correct." << '\n' << job->filepath);
+        return;
+    }
+
+    // Storage at the new size first, with no data to read
+    g_gl_state.bind_texture(job->texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, job->width, job->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    // The memcpy into the mapping is the one copy made on this thread. The
+    // texture then reads from the buffer, which the driver can do after the
+    // call returns; from client memory it would have to copy before returning.
+    fill_pixel_buffer(job->pixels, job->bytes);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, job->width, job->height, GL_RGBA, GL_UNSIGNED_BYTE, (const void*) 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    m_loaded++;
+}
+
+void TextureLoader::update()
+{
+    if (m_pending == 0) return;
+
+    size_t uploaded = 0;
+    while (true)
+    {
+        Job* job;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_decoded.empty()) break;
+
+            // One image always goes through, however big, so nothing waits forever
+            size_t bytes = m_decoded.front()->bytes;
+            if (uploaded > 0 && uploaded + bytes > m_bytes_per_frame) break;
+            uploaded += bytes;
+
+            job = m_decoded.front();
+            m_decoded.pop_front();
+        }
+
+        upload(job);
+        release(job);
+        m_pending--;
+    }
+
+    if (m_pending == 0)
+    {
+        PROFILE_MARK("textures ready", NULL);
+        if (m_report_timing)
+        {
+            LOG(m_loaded << " textures ready after "
+                << (SDL_GetPerformanceCounter() - m_start_counts) * 1000.0 / SDL_GetPerformanceFrequency() << " ms");
+        }
+        m_loaded = 0;
+    }
+}
+
+void TextureLoader::finish()
+{
+    while (m_pending > 0)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return !m_decoded.empty(); });
+        }
+
+        size_t budget = m_bytes_per_frame;
+        m_bytes_per_frame = (size_t) -1;
+        update();
+        m_bytes_per_frame = budget;
+    }
+}
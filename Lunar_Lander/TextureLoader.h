@@ -0,0 +1,86 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CookedTexture.h"
+
+const size_t TEXTURE_UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+const int TEXTURE_UPLOAD_BUFFERS = 3;   // uploads in flight before a buffer is reused
+
+// Loads textures without stalling the main thread. load() hands back a real
+// texture name straight away, holding a transparent 1x1 placeholder; worker
+// threads decode the files with stb_image, and update() uploads the finished
+// images through a ring of mapped pixel buffer objects, a per-frame byte
+// budget at a time.
+// The texture name never changes, so callers can keep it as they always have.
+//
+// A cooked .ctex next to the source (see Texture_Cooker) is used instead when
+// it's up to date: it is memory-mapped and its mip levels go up as they are.
+class TextureLoader
+{
+private:
+    struct Job
+    {
+        GLuint         texture_id;
+        std::string    filepath;
+        GLint          filter;
+        unsigned char* pixels = NULL;
+        int            width = 0;
+        int            height = 0;
+        size_t         bytes = 0;         // what the upload will cost
+        CookedTexture  cooked;            // mapped instead of `pixels` when there is one
+    };
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<Job*> m_queued;          // waiting for a worker
+    std::deque<Job*> m_decoded;         // waiting for update()
+    bool m_running = false;
+
+    GLuint m_pixel_buffers[TEXTURE_UPLOAD_BUFFERS] = {};
+    size_t m_pixel_buffer_sizes[TEXTURE_UPLOAD_BUFFERS] = {};
+    int    m_next_pixel_buffer = 0;
+    size_t m_bytes_per_frame = TEXTURE_UPLOAD_BYTES_PER_FRAME;
+    bool   m_s3tc_supported = false;
+
+    // ————— STATS ————— //
+    int    m_pending = 0;               // loaded but not uploaded yet; only touched on the GL thread
+    int    m_loaded = 0;
+    Uint64 m_start_counts = 0;
+    bool   m_report_timing = false;
+
+    void run_worker();
+    void upload(Job* job);
+    void upload_cooked(Job* job);
+    void release(Job* job);
+    // Binds the next buffer of the ring and copies `bytes` into it through a mapping
+    void fill_pixel_buffer(const void* data, size_t bytes);
+
+public:
+    ~TextureLoader() { stop(); };
+
+    // Needs a current GL context; 0 threads picks one per spare core
+    void start(int threads = 0, size_t bytes_per_frame = TEXTURE_UPLOAD_BYTES_PER_FRAME);
+    void stop();
+
+    GLuint load(const char* filepath, GLint filter = GL_NEAREST);
+    // Call once a frame on the GL thread
+    void update();
+    // Blocks until everything loaded so far is uploaded
+    void finish();
+
+    int const get_pending() const { return m_pending; };
+    // Prints how long each batch took to become ready; a profiler mark is made either way
+    void set_report_timing(bool report) { m_report_timing = report; };
+};
@@ -12,9 +12,26 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
 #include "stb_image.h"
+#include "TextureLoader.h"
+#include "CoreRenderer.h"
+#include "CommandList.h"
+#include "RenderThread.h"
+#include "RenderBackend.h"
+#include "SoftwareRenderer.h"
+#include "FramePacer.h"
+#include "FrameTimeRecorder.h"
+#include "FixedTimestep.h"
+#include "InputRecorder.h"
+#include "AnimationSystem.h"
+#include "Profiler.h"
+#include "RenderStats.h"
 #include "Entity.h"
+#include "ParticleSystem.h"
 #include <iostream>
 #include <vector>
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
 
 #define LOG(argument) std::cout << argument << '\n'
 
@@ -34,26 +51,6 @@ struct Box
         m_position = pos;
         is_black = black;
     }
-    
-    void render(ShaderProgram* program, GLuint* texture_id)
-    {
-        program->set_model_matrix(m_model_matrix);
-
-        float vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-        float tex_coords[] = { 0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
-
-        glBindTexture(GL_TEXTURE_2D, *texture_id);
-
-        glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-        glEnableVertexAttribArray(program->get_position_attribute());
-        glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, tex_coords);
-        glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
-
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        glDisableVertexAttribArray(program->get_position_attribute());
-        glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
-    }
 };
 
 std::vector<Box> g_boxes;
@@ -78,7 +75,11 @@ void initializeBoxes(std::vector<Box>& boxes) {
 GameState g_game_state;
 
 SDL_Window* g_display_window;
+SDL_GLContext g_gl_context;
 bool g_game_is_running = true; //tracks whether game is running
+FramePacer g_frame_pacer;      //caps the frame rate, slows right down while minimized
+FrameTimeRecorder g_frame_recorder;    //frame time percentiles and hitches, reported at exit
+const char* g_frame_report_path = NULL;     //--frame-report FILE; no report without it
 
 //DEFINE GLOBAL CONSTANTS
 const int WINDOW_WIDTH = 640 * 2,
@@ -92,13 +93,19 @@ VIEWPORT_HEIGHT = WINDOW_HEIGHT;
 const char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
 F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
 
+const char V_PARTICLE_SHADER_PATH[] = "shaders/vertex_particle.glsl",
+F_PARTICLE_SHADER_PATH[] = "shaders/fragment_particle.glsl";
+
+//GL 3.3 core profile versions, used with --core
+const char V_CORE_SHADER_PATH[] = "shaders/vertex_textured_core.glsl",
+F_CORE_SHADER_PATH[] = "shaders/fragment_textured_core.glsl";
+const char V_CORE_PARTICLE_SHADER_PATH[] = "shaders/vertex_particle_core.glsl",
+F_CORE_PARTICLE_SHADER_PATH[] = "shaders/fragment_particle_core.glsl";
+
 const float MILLISECONDS_IN_SECOND = 1000.0;
+const float STATS_OVERLAY_UNITS_PER_TEXEL = 2.0f * 10.0f / WINDOW_WIDTH;   //two screen pixels per texel
 const float DEGREES_PER_SECOND = 90.0f;
 
-const int NUMBER_OF_TEXTURES = 1; // to be generated, that is
-const GLint LEVEL_OF_DETAIL = 0;  // base image level; Level n is the nth mipmap reduction image
-const GLint TEXTURE_BORDER = 0;   // this value MUST be zero
-
 const char IDLE_SPRITE_FILEPATH[] = "sprites/ship_idle.png";     
 const char MOVING_SPRITE_FILEPATH[] = "sprites/ship_move.png"; 
 const char BLACK_BOX_SPRITE_FILEPATH[] = "sprites/black_box.png";
@@ -106,48 +113,84 @@ const char RED_BOX_SPRITE_FILEPATH[] = "sprites/red_box.png";
 const char WIN_SPRITE_FILEPATH[] = "sprites/win.png";
 const char LOSE_SPRITE_FILEPATH[] = "sprites/lose.png";
 
+//particle settings
+const int   MAX_PARTICLES = 1 << 20;             // enough for the benchmark scene, allocated once
+const size_t STREAM_BUFFER_BYTES = 1 << 20;       // per frame; grows if the benchmark needs more
+const float EXHAUST_PARTICLES_PER_SECOND = 600.0f;
+const float EXHAUST_SPEED = 2.0f;
+const float EXHAUST_SPREAD = 0.25f;              // radians either side of the nozzle
+const float EXHAUST_LIFETIME = 0.8f;
+const float NOZZLE_OFFSET = 0.4f;
+const int   IMPACT_PARTICLES = 400;
+const float IMPACT_SPEED = 3.0f;
+const float IMPACT_LIFETIME = 1.2f;
+
+//benchmark scene settings (toggled with B)
+const float BENCHMARK_EXHAUST_PER_SECOND = 600000.0f;
+const float BENCHMARK_LIFETIME = 2.0f;
+const float BENCHMARK_IMPACT_INTERVAL = 0.25f;
+const int   BENCHMARK_IMPACT_PARTICLES = 4000;
+
 GLuint g_black_box_texture_id;
 GLuint g_red_box_texture_id;
 GLuint g_win_texture_id;
 GLuint g_lose_texture_id;
+TextureLoader g_texture_loader; //decodes on worker threads, uploads a little each frame on the GL thread
 
 ShaderProgram g_shader_program; //shader program
 glm::mat4 view_matrix, g_projection_matrix;
 
-float g_previous_ticks = 0.0f; //used for delta time calculation
+FixedTimestep g_timestep;      //turns real time into fixed simulation steps
 
 bool g_game_end = false;
 bool g_game_win = false;
 
-
-//FUNCTION PROFESSOR WROTE IN CLASS
-GLuint load_texture(const char* filepath)
+ParticleSystem g_particles(MAX_PARTICLES);
+RenderStatsOverlay g_stats_overlay;     //F3 or --stats-overlay
+StreamBuffer g_stream_buffer;           //per-frame vertex data, triple buffered
+
+bool g_core_profile = false;            //set by --core: VAOs, in/out shaders, shared camera block
+CoreRenderer g_core_renderer;
+bool g_use_render_thread = false;       //set by --render-thread: GL runs on its own thread from recorded commands
+RenderThread g_render_thread;
+GLRenderBackend* g_gl_backend = NULL;   //draws recorded frames; NULL without a context or with another --renderer
+NullRenderBackend g_null_backend;       //--renderer null: frames are recorded and counted, never drawn
+SoftwareRenderBackend* g_software_backend = NULL;    //--renderer software: frames drawn on the CPU, replays only
+RecordingRenderBackend* g_command_recorder = NULL;   //--record-commands FILE, in front of whichever draws
+RenderBackend* g_render_backend = NULL; //where recorded frames go
+CommandList g_command_list;             //frames recorded on the main thread when the render thread is off
+float g_exhaust_accumulator = 0.0f;     //carries fractional particles over to the next frame
+
+std::atomic<bool> g_particle_benchmark{false};   //also read by the render thread
+float g_benchmark_impact_timer = 0.0f;
+float g_benchmark_report_timer = 0.0f;
+int   g_benchmark_frames = 0;
+Uint64 g_benchmark_update_counts = 0;
+Uint64 g_benchmark_render_counts = 0;
+
+//input actions; held ones last while the key is down, the rest happen once per press
+const InputActions ACTION_TURN_LEFT = 1 << 0,
+ACTION_TURN_RIGHT = 1 << 1,
+ACTION_THRUST = 1 << 2,
+ACTION_PARTICLE_BENCHMARK = 1 << 3;
+
+InputRecorder g_input_recorder;        //--record FILE: every tick's input, written at exit
+InputReplay g_input_replay;            //--replay FILE: plays a recording back without a window
+InputActions g_held_actions = 0;
+
+
+//everything the simulation needs, none of it GL, so replays can run without a window
+void initialise_game()
 {
-    // STEP 1: Loading the image file
-    int width, height, number_of_components;
-    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
-
-    if (image == NULL)
-    {
-        LOG("Unable to load image. Make sure the path is correct.");
-        LOG(filepath);
-        assert(false);
-    }
-
-    // STEP 2: Generating and binding a texture ID to our image
-    GLuint textureID;
-    glGenTextures(NUMBER_OF_TEXTURES, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, image);
-
-    // STEP 3: Setting our texture filter parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    initializeBoxes(g_boxes);
 
-    // STEP 4: Releasing our file from memory and returning our texture id
-    stbi_image_free(image);
+    view_matrix = glm::mat4(1.0f);
+    g_projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
 
-    return textureID;
+    //  PLAYER  //
+    g_game_state.player = new Entity();
+    g_game_state.player->set_position(glm::vec3(-3.0f, 3.0f, 0.0f));
+    g_game_state.player->set_velocity(glm::vec3(0.0f));
 }
 
 void initialise()
@@ -155,53 +198,88 @@ void initialise()
     // Initialise video and joystick subsystems
     SDL_Init(SDL_INIT_VIDEO);
 
+    if (g_core_profile) {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    }
+
     g_display_window = SDL_CreateWindow("Lunar Lander",
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         WINDOW_WIDTH, WINDOW_HEIGHT,
         SDL_WINDOW_OPENGL);
 
-    SDL_GLContext context = SDL_GL_CreateContext(g_display_window);
-    SDL_GL_MakeCurrent(g_display_window, context);
+    g_gl_context = SDL_GL_CreateContext(g_display_window);
+    SDL_GL_MakeCurrent(g_display_window, g_gl_context);
 
 #ifdef _WINDOWS
+    glewExperimental = GL_TRUE; //core contexts don't list extensions the old way
     glewInit();
 #endif
 
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
 
-    g_shader_program.load(V_SHADER_PATH, F_SHADER_PATH);
+    initialise_game();
 
-    view_matrix = glm::mat4(1.0f);
-    g_projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f); 
+    // Both programs are started before either is waited on, so they compile together
+    if (g_core_profile) {
+        g_core_renderer.start_load(V_CORE_SHADER_PATH, F_CORE_SHADER_PATH);
+        g_particles.start_load(V_CORE_PARTICLE_SHADER_PATH, F_CORE_PARTICLE_SHADER_PATH);
+        g_core_renderer.finish_load();
+        g_particles.finish_load(true);
+    }
+    else {
+        g_shader_program.start_load(V_SHADER_PATH, F_SHADER_PATH);
+        g_particles.start_load(V_PARTICLE_SHADER_PATH, F_PARTICLE_SHADER_PATH);
+        g_shader_program.finish_load();
+        g_particles.finish_load();
 
-    g_shader_program.set_projection_matrix(g_projection_matrix);
-    g_shader_program.set_view_matrix(view_matrix);
+        g_shader_program.set_projection_matrix(g_projection_matrix);
+        g_shader_program.set_view_matrix(view_matrix);
 
-    glUseProgram(g_shader_program.get_program_id());
+        g_gl_state.use_program(g_shader_program.get_program_id());
+    }
+    g_stream_buffer.create(STREAM_BUFFER_BYTES);
+    g_stats_overlay.create();
 
     glClearColor(255.0f, 255.0f, 255.0f, 1.0f); //sets background to white by default
 
-    g_black_box_texture_id = load_texture(BLACK_BOX_SPRITE_FILEPATH);
-    g_red_box_texture_id = load_texture(RED_BOX_SPRITE_FILEPATH);
-    g_win_texture_id = load_texture(WIN_SPRITE_FILEPATH);
-    g_lose_texture_id = load_texture(LOSE_SPRITE_FILEPATH);
+    //textures show up over the first few frames
+    g_texture_loader.start();
+    g_black_box_texture_id = g_texture_loader.load(BLACK_BOX_SPRITE_FILEPATH);
+    g_red_box_texture_id = g_texture_loader.load(RED_BOX_SPRITE_FILEPATH);
+    g_win_texture_id = g_texture_loader.load(WIN_SPRITE_FILEPATH);
+    g_lose_texture_id = g_texture_loader.load(LOSE_SPRITE_FILEPATH);
 
-    initializeBoxes(g_boxes);
-
-    //  PLAYER  //
-    g_game_state.player = new Entity();
-    g_game_state.player->set_position(glm::vec3(-3.0f, 3.0f, 0.0f));
-    g_game_state.player->set_velocity(glm::vec3(0.0f));
-    g_game_state.player->set_idle_texture_id(load_texture(IDLE_SPRITE_FILEPATH));
-    g_game_state.player->set_moving_texture_id(load_texture(MOVING_SPRITE_FILEPATH));
+    g_game_state.player->set_idle_texture_id(g_texture_loader.load(IDLE_SPRITE_FILEPATH));
+    g_game_state.player->set_moving_texture_id(g_texture_loader.load(MOVING_SPRITE_FILEPATH));
 
     // enable blending
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    g_gl_state.set_blend(true);
+    g_gl_state.set_blend_function(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+//the game only ever sees input as actions, so a replay drives it exactly as the keyboard did
+void apply_actions(InputActions held, InputActions pressed)
+{
+    g_held_actions = held;
+
+    if (pressed & ACTION_PARTICLE_BENCHMARK) {
+        g_particle_benchmark = !g_particle_benchmark;
+        g_particles.clear();
+        LOG((g_particle_benchmark ? "Particle benchmark ON" : "Particle benchmark OFF"));
+    }
+
+    if (held & ACTION_TURN_LEFT) g_game_state.player->set_turning(1.0f);
+    else if (held & ACTION_TURN_RIGHT) g_game_state.player->set_turning(-1.0f);
+    else g_game_state.player->set_turning(0.0f);
+    g_game_state.player->set_acceleration((held & ACTION_THRUST) != 0);
 }
 
 void process_input()
 {
+    PROFILE_SCOPE("process_input");
+    InputActions pressed = 0;
     SDL_Event event;
 
     while (SDL_PollEvent(&event))
@@ -219,6 +297,12 @@ void process_input()
             case SDLK_q:
                 g_game_is_running = false;
                 break;
+            case SDLK_b:
+                pressed |= ACTION_PARTICLE_BENCHMARK;
+                break;
+            case SDLK_F3:
+                g_stats_overlay.toggle();
+                break;
             default:
                 break;
             }
@@ -227,37 +311,92 @@ void process_input()
         }
     }
 
-    //key hold checks                                                                       
+    //key hold checks
     const Uint8* key_state = SDL_GetKeyboardState(NULL);
+    InputActions held = 0;
 
-    if (key_state[SDL_SCANCODE_LEFT])
-    {
-        g_game_state.player->rotate_left();
-    }
-    else if (key_state[SDL_SCANCODE_RIGHT])
-    {
-        g_game_state.player->rotate_right();
-    }
-    if (key_state[SDL_SCANCODE_SPACE])
-    {
-        g_game_state.player->set_acceleration(true);
+    if (key_state[SDL_SCANCODE_LEFT]) held |= ACTION_TURN_LEFT;
+    else if (key_state[SDL_SCANCODE_RIGHT]) held |= ACTION_TURN_RIGHT;
+    if (key_state[SDL_SCANCODE_SPACE]) held |= ACTION_THRUST;
+
+    apply_actions(held, pressed);
+    g_input_recorder.press(pressed);
+}
+
+void emit_exhaust(float particles_per_second, float lifetime, float delta_time)
+{
+    float angle = glm::radians(g_game_state.player->get_ship_angle());
+    glm::vec3 exhaust_direction = glm::vec3(sin(angle), -cos(angle), 0.0f); //opposite of thrust
+    glm::vec3 nozzle = g_game_state.player->get_position() + exhaust_direction * NOZZLE_OFFSET;
+
+    g_exhaust_accumulator += particles_per_second * delta_time;
+    int count = (int)g_exhaust_accumulator;
+    g_exhaust_accumulator -= count;
+
+    g_particles.emit(nozzle, exhaust_direction, EXHAUST_SPREAD, EXHAUST_SPEED, lifetime, count);
+}
+
+void update_particle_benchmark(float delta_time)
+{
+    emit_exhaust(BENCHMARK_EXHAUST_PER_SECOND, BENCHMARK_LIFETIME, delta_time);
+
+    //every box gets hit on a timer so the impact path is exercised as well
+    g_benchmark_impact_timer += delta_time;
+    if (g_benchmark_impact_timer >= BENCHMARK_IMPACT_INTERVAL) {
+        g_benchmark_impact_timer = 0.0f;
+        for (const auto& box : g_boxes) {
+            g_particles.burst(box.m_position, IMPACT_SPEED, BENCHMARK_LIFETIME, BENCHMARK_IMPACT_PARTICLES);
+        }
     }
-    else {
-        g_game_state.player->set_acceleration(false);
+
+    g_benchmark_report_timer += delta_time;
+}
+
+//reads render-side stats, so with the render thread it has to run while that thread is idle
+void report_particle_benchmark()
+{
+    if (g_particle_benchmark && g_benchmark_report_timer >= 1.0f && g_benchmark_frames > 0) {
+        double counts_per_ms = (double)SDL_GetPerformanceFrequency() / MILLISECONDS_IN_SECOND;
+        std::cout << "particles: " << g_particles.get_live_count()
+            << " | update " << g_benchmark_update_counts / counts_per_ms / g_benchmark_frames << " ms"
+            << " | render " << g_benchmark_render_counts / counts_per_ms / g_benchmark_frames << " ms"
+            << " | stream " << (g_stream_buffer.is_persistent() ? "persistent" : "orphaned")
+            << " " << g_stream_buffer.get_bytes_streamed() / g_benchmark_frames / 1024 << " KiB/frame"
+            << " fence waits " << g_stream_buffer.get_fence_waits() << " (" << g_stream_buffer.get_fence_wait_ms() << " ms)"
+            << " | gl calls " << g_gl_state.get_issued_calls() / g_benchmark_frames
+            << " skipped " << g_gl_state.get_skipped_calls() / g_benchmark_frames
+            << std::endl;
+        if (g_use_render_thread) {
+            std::cout << "render thread: busy " << g_render_thread.get_render_ms() / g_render_thread.get_frames() << " ms/frame"
+                << " | simulation waited " << g_render_thread.get_wait_ms() / g_render_thread.get_frames() << " ms/frame"
+                << std::endl;
+            g_render_thread.reset_stats();
+        }
+
+        g_benchmark_report_timer = 0.0f;
+        g_benchmark_frames = 0;
+        g_benchmark_update_counts = 0;
+        g_benchmark_render_counts = 0;
+        g_stream_buffer.reset_stats();
+        g_gl_state.reset_counters();
     }
 }
 
-void update()
+//advances the game by one fixed step
+void simulate(float delta_time)
 {
     if (not g_game_end) {
-        float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND; // get the current number of ticks
-        float delta_time = ticks - g_previous_ticks; // the delta time is the difference from the last frame
-        g_previous_ticks = ticks;
-
         g_game_state.player->update(delta_time);
 
+        if (g_game_state.player->get_accelerating()) {
+            emit_exhaust(EXHAUST_PARTICLES_PER_SECOND, EXHAUST_LIFETIME, delta_time);
+        }
+
         for (const auto& box : g_boxes) {
             if (g_game_state.player->check_collision(box.m_position)) {
+                g_particles.burst(box.m_position, IMPACT_SPEED, IMPACT_LIFETIME, IMPACT_PARTICLES);
+                if (g_particle_benchmark) continue; //the benchmark keeps running through collisions
+
                 if (box.is_black) {
                     g_game_win = true;
                     std::cout << "WIN" << std::endl;
@@ -270,77 +409,210 @@ void update()
             }
         }
     }
+
+}
+
+void update(int steps)
+{
+    PROFILE_SCOPE("update");
+    //the lander always moves in steps of FIXED_TIMESTEP, however fast frames come
+    for (int i = 0; i < steps; i++) {
+        g_input_recorder.record_tick(g_held_actions);
+        simulate(g_timestep.get_step());
+    }
+    g_game_state.player->interpolate(g_timestep.get_alpha());
+
+    //particles and animation are only for show, so they just follow real time
+    float delta_time = g_timestep.get_frame_seconds();
+
+    if (g_particle_benchmark) {
+        update_particle_benchmark(delta_time);
+    }
+
+    g_animation_system.update(delta_time);
+
+    Uint64 particle_start = SDL_GetPerformanceCounter();
+    g_particles.update(delta_time);
+    if (g_particle_benchmark) g_benchmark_update_counts += SDL_GetPerformanceCounter() - particle_start;
 }
 
-void render() {
-    glClear(GL_COLOR_BUFFER_BIT);
+//swaps separately from execute_commands() so the GPU scope ends before the frame goes out
+void present()
+{
+    PROFILE_SCOPE("swap");
+    SDL_GL_SwapWindow(g_display_window);
+    g_profiler.end_gpu_frame();
+}
+
+//every frame is recorded here, then drawn by whichever backend is in use
+void record_frame(CommandList* list)
+{
+    PROFILE_SCOPE("record_frame");
+    list->reset();
+    list->clear();
+    list->set_camera(view_matrix, g_projection_matrix);
 
     if (! g_game_end) {
         for (auto& box : g_boxes) {
-            if (box.is_black) {
-                box.render(&g_shader_program, &g_black_box_texture_id);
-            }
-            else {
-                box.render(&g_shader_program, &g_red_box_texture_id);
-            }
+            list->draw_quad(box.m_model_matrix, box.is_black ? g_black_box_texture_id : g_red_box_texture_id);
         }
 
-        g_game_state.player->render(&g_shader_program);
-        
+        g_game_state.player->render(list);
     }
     else {
-        g_shader_program.set_model_matrix(glm::mat4(1.0f));
-
-        //float vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-        float tex_coords[] = { 0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
-
-        if (g_game_win) {
-            glBindTexture(GL_TEXTURE_2D, g_win_texture_id);
-            int SCALE = 100;
-            float model_width = 525.0f / SCALE;
-            float model_height = 260.0f / SCALE;
-            float vertices[] = {
-                -model_width / 2.0f, -model_height / 2.0f,
-                model_width / 2.0f, -model_height / 2.0f,
-                model_width / 2.0f, model_height / 2.0f,
-                -model_width / 2.0f, -model_height / 2.0f,
-                model_width / 2.0f, model_height / 2.0f,
-                -model_width / 2.0f, model_height / 2.0f
-            };
-            glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-        }
-        else {
-            glBindTexture(GL_TEXTURE_2D, g_lose_texture_id);
-            int SCALE = 250;
-            float model_width = 1200.0f / SCALE;
-            float model_height = 670.0f / SCALE;
-            float vertices[] = {
-                -model_width / 2.0f, -model_height / 2.0f,
-                model_width / 2.0f, -model_height / 2.0f,
-                model_width / 2.0f, model_height / 2.0f,
-                -model_width / 2.0f, -model_height / 2.0f,
-                model_width / 2.0f, model_height / 2.0f,
-                -model_width / 2.0f, model_height / 2.0f
-            };
-            glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
+        glm::vec3 size = g_game_win ? glm::vec3(525.0f / 100, 260.0f / 100, 1.0f) : glm::vec3(1200.0f / 250, 670.0f / 250, 1.0f);
+        list->draw_quad(glm::scale(glm::mat4(1.0f), size), g_game_win ? g_win_texture_id : g_lose_texture_id);
+    }
+
+    g_particles.record(list);
+
+    if (g_stats_overlay.is_visible()) {
+        list->draw_quad(g_stats_overlay.get_model_matrix(-5.0f, 3.75f, STATS_OVERLAY_UNITS_PER_TEXEL), g_stats_overlay.get_texture_id());
+    }
+}
+
+//runs on the render thread, or on the main thread without --render-thread
+void execute_commands(const CommandList& list)
+{
+    PROFILE_SCOPE("execute_commands");
+    PROFILE_GPU_SCOPE("execute_commands");
+
+    if (g_gl_backend != NULL) {
+        g_texture_loader.update();
+        g_stats_overlay.update(g_render_stats.get_last_frame());
+    }
+
+    g_render_backend->execute(list);
+
+    if (g_gl_backend != NULL) {
+        if (g_particle_benchmark) g_benchmark_render_counts += g_gl_backend->take_particle_counts();
+        g_stream_buffer.end_frame();
+    }
+    if (g_particle_benchmark) g_benchmark_frames++;
+    g_render_stats.end_frame();
+}
+
+//picks what recorded frames are executed on; GL only when there is a context
+void start_render_backend(RendererType renderer, const char* record_path, bool has_context)
+{
+    g_render_backend = NULL;
+    if (renderer == RENDERER_SOFTWARE && has_context) {
+        LOG("The software renderer only runs with --replay; drawing with GL");
+        renderer = RENDERER_GL;
+    }
+
+    if (renderer == RENDERER_NULL) {
+        g_render_backend = &g_null_backend;
+    }
+    else if (renderer == RENDERER_SOFTWARE) {
+        //it keeps its own copies of the textures, under its own names
+        g_software_backend = new SoftwareRenderBackend(&g_particles);
+        g_software_backend->start(WINDOW_WIDTH, WINDOW_HEIGHT);
+        g_software_backend->set_clear_colour(glm::vec4(1.0f)); //white, as glClearColor in initialise()
+        g_black_box_texture_id = g_software_backend->load_texture(BLACK_BOX_SPRITE_FILEPATH);
+        g_red_box_texture_id = g_software_backend->load_texture(RED_BOX_SPRITE_FILEPATH);
+        g_win_texture_id = g_software_backend->load_texture(WIN_SPRITE_FILEPATH);
+        g_lose_texture_id = g_software_backend->load_texture(LOSE_SPRITE_FILEPATH);
+        g_game_state.player->set_idle_texture_id(g_software_backend->load_texture(IDLE_SPRITE_FILEPATH));
+        g_game_state.player->set_moving_texture_id(g_software_backend->load_texture(MOVING_SPRITE_FILEPATH));
+        g_render_backend = g_software_backend;
+    }
+    else if (has_context) {
+        g_gl_backend = new GLRenderBackend(&g_shader_program, g_core_profile ? &g_core_renderer : NULL, &g_particles, &g_stream_buffer);
+        g_render_backend = g_gl_backend;
+    }
+
+    if (record_path != NULL) {
+        g_command_recorder = new RecordingRenderBackend(g_render_backend);
+        if (g_command_recorder->start(record_path)) g_render_backend = g_command_recorder;
+    }
+}
+
+//draws a recorded command stream back in the window, with no simulation behind it
+void run_command_playback(CommandStreamReader* reader)
+{
+    while (g_game_is_running && reader->next(&g_command_list)) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_q)) g_game_is_running = false;
         }
-        
-        
-        glEnableVertexAttribArray(g_shader_program.get_position_attribute());
-        glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, tex_coords);
-        glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        execute_commands(g_command_list);
+        present();
+        g_profiler.end_frame();
+        g_frame_recorder.end_frame(g_frame_pacer.is_hidden());
+        g_frame_pacer.wait(g_display_window);
+    }
+    LOG("Played back " << reader->get_frame() << " of " << reader->get_frame_count() << " recorded frames");
+}
 
-        glDisableVertexAttribArray(g_shader_program.get_position_attribute());
-        glDisableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+//draws the last frame again and reads it back, to compare with the software renderer's
+void dump_gl_frame(const char* path)
+{
+    if (g_gl_backend == NULL || g_use_render_thread) {
+        LOG("--dump-frame needs GL drawing on the main thread");
+        return;
     }
 
-    SDL_GL_SwapWindow(g_display_window);
+    //straight to GL, so a --record-commands stream doesn't gain the extra frame
+    record_frame(&g_command_list);
+    g_gl_backend->execute(g_command_list);
+    std::vector<unsigned int> pixels(WINDOW_WIDTH * WINDOW_HEIGHT);
+    glReadPixels(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    if (write_tga(path, WINDOW_WIDTH, WINDOW_HEIGHT, pixels.data(), true)) LOG("Wrote the last frame to " << path);
+}
+
+//everything the simulation decides, for telling whether two replays ended the same way
+unsigned int hash_game_state()
+{
+    StateHash hash;
+    hash.add(g_game_state.player->get_position());
+    hash.add(g_game_state.player->get_velocity());
+    hash.add(g_game_state.player->get_ship_angle());
+    hash.add(g_game_state.player->get_fuel());
+    hash.add(g_game_end);
+    hash.add(g_game_win);
+    return hash.get();
+}
+
+//no window and no GL: each frame is one tick of the recording, run as fast as it will go
+void run_replay()
+{
+    g_timestep.start(g_input_replay.get_step());
+
+    InputActions held, pressed;
+    while (g_game_is_running && g_input_replay.next(&held, &pressed)) {
+        apply_actions(held, pressed);
+        update(g_timestep.advance(g_timestep.get_step()));
+        //with --renderer null or --record-commands the frame is recorded too, so its CPU cost is part of the run
+        if (g_render_backend != NULL) {
+            record_frame(&g_command_list);
+            execute_commands(g_command_list);
+        }
+        g_profiler.end_frame();
+        g_frame_recorder.end_frame();
+    }
+
+    LOG("Replayed " << g_input_replay.get_tick() << " ticks | particles " << g_particles.get_live_count()
+        << " | state hash " << std::hex << hash_game_state() << std::dec);
 }
 
 void shutdown()
 {
+    //a replay of the recording should end on the same hash
+    if (g_input_recorder.is_recording()) LOG("State hash " << std::hex << hash_game_state() << std::dec);
+    g_input_recorder.stop();
+    g_render_thread.stop();
+    //the render thread let go of the context; the GL cleanup below needs it back
+    if (g_use_render_thread && g_gl_context != NULL) SDL_GL_MakeCurrent(g_display_window, g_gl_context);
+    //after the render thread, which may still be executing a frame on it
+    if (g_command_recorder != NULL) g_command_recorder->stop();
+    if (g_render_backend != NULL) g_render_backend->print_summary();
+    if (g_software_backend != NULL) g_software_backend->stop();
+    g_texture_loader.stop();
+    if (g_frame_report_path != NULL) g_frame_recorder.write_report(g_frame_report_path);
+    g_frame_recorder.print_summary();
+    g_profiler.stop();
     SDL_Quit();
 }
 
@@ -355,15 +627,112 @@ int main(int argc, char* argv[])
 * Academic Misconduct.
 **/
 {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--core") == 0) g_core_profile = true;
+        if (strcmp(argv[i], "--render-thread") == 0) g_use_render_thread = true;
+    }
+    SwapMode swap_mode = SWAP_VSYNC;
+    float target_fps = 0.0f;   //0 = as fast as the swap mode allows
+    parse_frame_pacing_arguments(argc, argv, &swap_mode, &target_fps);
+
+    //--trace FILE writes a Chrome trace of the whole run at exit
+    g_profiler.start(parse_trace_argument(argc, argv));
+    g_profiler.set_thread_name("Main");
+
+    //--render-stats FILE logs every frame's GL workload as CSV, and reports how long the textures took
+    const char* render_stats_path = NULL;
+    bool stats_overlay = false;
+    parse_render_stats_arguments(argc, argv, &render_stats_path, &stats_overlay);
+    if (render_stats_path != NULL) g_render_stats.open_csv(render_stats_path);
+    g_texture_loader.set_report_timing(render_stats_path != NULL);
+    g_stats_overlay.set_visible(stats_overlay);
+
+    //--frame-report FILE writes the frame time report at exit; --hitch-ms N moves the hitch budget
+    float hitch_budget_ms = FRAME_HITCH_BUDGET_MS;
+    parse_frame_report_arguments(argc, argv, &g_frame_report_path, &hitch_budget_ms);
+
+    //--record FILE logs the input of every tick; --replay FILE plays one back headless
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    parse_input_recording_arguments(argc, argv, &record_path, &replay_path);
+
+    //--renderer null counts frames instead of drawing them, --renderer software draws them
+    //on the CPU; --record-commands FILE writes every frame's commands, --replay-commands FILE
+    //draws them back; --dump-frame FILE saves the last frame drawn as a TGA
+    RendererType renderer = RENDERER_GL;
+    const char* command_record_path = NULL;
+    const char* command_replay_path = NULL;
+    const char* dump_path = NULL;
+    parse_render_backend_arguments(argc, argv, &renderer, &command_record_path, &command_replay_path, &dump_path);
+
+    if (replay_path != NULL) {
+        if (!g_input_replay.load(replay_path)) return 1;
+        srand(g_input_replay.get_seed());
+        initialise_game();
+        start_render_backend(renderer, command_record_path, false);
+        g_frame_recorder.start(hitch_budget_ms);
+        run_replay();
+        if (dump_path != NULL) {
+            if (g_software_backend == NULL) LOG("--dump-frame with --replay needs --renderer software");
+            else if (g_software_backend->write_tga(dump_path)) LOG("Wrote the last frame to " << dump_path);
+        }
+        shutdown();
+        return 0;
+    }
+
     initialise();
+    //the queries belong to the context, so the render thread can use them too
+    g_profiler.start_gpu();
+    //the swap interval belongs to the context, so it's set before the render thread takes it
+    g_frame_pacer.start(swap_mode, target_fps);
+    g_timestep.start();
+    g_frame_recorder.start(hitch_budget_ms);
+    if (record_path != NULL) {
+        unsigned int seed = (unsigned int)SDL_GetPerformanceCounter();
+        srand(seed);
+        g_input_recorder.start(record_path, seed, g_timestep.get_step());
+    }
+
+    start_render_backend(renderer, command_record_path, true);
+
+    if (command_replay_path != NULL) {
+        //the textures were just loaded in the order the recording run loaded them, so they have the same names
+        CommandStreamReader reader;
+        if (reader.open(command_replay_path)) run_command_playback(&reader);
+        shutdown();
+        return 0;
+    }
+
+    if (g_use_render_thread) {
+        //hand the context over; from here on only the render thread touches GL
+        SDL_GL_MakeCurrent(g_display_window, NULL);
+        g_render_thread.start(g_display_window, g_gl_context, execute_commands);
+    }
 
     while (g_game_is_running)
     {
         process_input();
-        update();
-        render();
+        update(g_timestep.advance());
+
+        if (g_use_render_thread) {
+            //this frame is recorded while the render thread is still drawing the previous one
+            record_frame(g_render_thread.get_command_list());
+            g_render_thread.wait_idle();
+            report_particle_benchmark();
+            g_render_thread.submit();
+        }
+        else {
+            record_frame(&g_command_list);
+            execute_commands(g_command_list);
+            present();
+            report_particle_benchmark();
+        }
+        g_profiler.end_frame();
+        g_frame_recorder.end_frame(g_frame_pacer.is_hidden());
+        g_frame_pacer.wait(g_display_window);
     }
 
+    if (dump_path != NULL) dump_gl_frame(dump_path);
     shutdown();
     return 0;
 }
@@ -0,0 +1,11 @@
+#version 120
+
+uniform vec4 color;
+varying float alphaVar;
+
+void main() {
+    // Soft round dot instead of a square point
+    vec2 offset = gl_PointCoord - vec2(0.5, 0.5);
+    float falloff = 1.0 - clamp(dot(offset, offset) * 4.0, 0.0, 1.0);
+    gl_FragColor = vec4(color.rgb, color.a * alphaVar * falloff);
+}
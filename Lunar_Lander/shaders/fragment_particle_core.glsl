@@ -0,0 +1,13 @@
+#version 330 core
+
+uniform vec4 color;
+in float alphaVar;
+
+out vec4 fragColor;
+
+void main() {
+    // Soft round dot instead of a square point
+    vec2 offset = gl_PointCoord - vec2(0.5, 0.5);
+    float falloff = 1.0 - clamp(dot(offset, offset) * 4.0, 0.0, 1.0);
+    fragColor = vec4(color.rgb, color.a * alphaVar * falloff);
+}
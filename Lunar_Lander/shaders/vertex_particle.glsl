@@ -0,0 +1,19 @@
+#version 120
+
+attribute float positionX;
+attribute float positionY;
+attribute float alpha;
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+uniform float pointSize;
+
+varying float alphaVar;
+
+void main()
+{
+	vec4 p = viewMatrix * vec4(positionX, positionY, 0.0, 1.0);
+    alphaVar = alpha;
+    gl_PointSize = pointSize;
+	gl_Position = projectionMatrix * p;
+}
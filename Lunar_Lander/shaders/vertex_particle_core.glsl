@@ -0,0 +1,23 @@
+#version 330 core
+
+in float positionX;
+in float positionY;
+in float alpha;
+
+layout(std140) uniform Camera
+{
+    mat4 viewMatrix;
+    mat4 projectionMatrix;
+};
+
+uniform float pointSize;
+
+out float alphaVar;
+
+void main()
+{
+    vec4 p = viewMatrix * vec4(positionX, positionY, 0.0, 1.0);
+    alphaVar = alpha;
+    gl_PointSize = pointSize;
+    gl_Position = projectionMatrix * p;
+}
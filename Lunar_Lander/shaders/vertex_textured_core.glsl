@@ -0,0 +1,21 @@
+#version 330 core
+
+in vec4 position;
+in vec2 texCoord;
+
+layout(std140) uniform Camera
+{
+    mat4 viewMatrix;
+    mat4 projectionMatrix;
+};
+
+uniform mat4 modelMatrix;
+
+out vec2 texCoordVar;
+
+void main()
+{
+    vec4 p = viewMatrix * modelMatrix * position;
+    texCoordVar = texCoord;
+    gl_Position = projectionMatrix * p;
+}
@@ -0,0 +1,193 @@
+#include "BallPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BALLS_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+BallPool::BallPool(float collision_x, float collision_y, float wall_y, float exit_x, float ball_size)
+{
+    m_collision_x = collision_x;
+    m_collision_y = collision_y;
+    m_wall_y = wall_y;
+    m_exit_x = exit_x;
+    m_ball_size = ball_size;
+}
+
+void BallPool::spawn(glm::vec3 position, glm::vec3 movement)
+{
+    m_position_x.push_back(position.x);
+    m_position_y.push_back(position.y);
+    m_movement_x.push_back(movement.x);
+    m_movement_y.push_back(movement.y);
+    m_previous_x.push_back(position.x);
+    m_previous_y.push_back(position.y);
+}
+
+void BallPool::clear()
+{
+    m_position_x.clear();
+    m_position_y.clear();
+    m_movement_x.clear();
+    m_movement_y.clear();
+    m_previous_x.clear();
+    m_previous_y.clear();
+
+    m_left_exit = false;
+    m_right_exit = false;
+}
+
+void BallPool::update_range(int start, int end, float step, const SweepArena& arena)
+{
+    for (int i = start; i < end; i++)
+    {
+        float x = m_position_x[i];
+        float y = m_position_y[i];
+
+        if (x > m_exit_x || x < -m_exit_x)
+        {
+            if (m_respawn_exited) x = 0.0f;
+            else if (x > m_exit_x) m_right_exit = true;
+            else m_left_exit = true;
+        }
+
+        if (ball_needs_sweep(x, y, m_movement_x[i], m_movement_y[i], step, arena))
+        {
+            sweep_ball(x, y, m_movement_x[i], m_movement_y[i], step, arena);
+            m_swept_count++;
+        }
+        else
+        {
+            x += m_movement_x[i] * step;
+            y += m_movement_y[i] * step;
+        }
+
+        m_position_x[i] = x;
+        m_position_y[i] = y;
+    }
+}
+
+void BallPool::save_previous()
+{
+    m_previous_x = m_position_x;
+    m_previous_y = m_position_y;
+}
+
+void BallPool::update(float delta_time, float speed, const glm::vec3& paddle, const glm::vec3& paddle2)
+{
+    save_previous();
+    m_left_exit = false;
+    m_right_exit = false;
+    m_swept_count = 0;
+
+    int count = get_count();
+    int simd_end = 0;
+    float step = speed * delta_time;
+
+    SweepArena arena;
+    arena.collision_x = m_collision_x;
+    arena.collision_y = m_collision_y;
+    arena.wall_y = m_wall_y;
+    arena.paddle_x[0] = paddle.x;
+    arena.paddle_y[0] = paddle.y;
+    arena.paddle_x[1] = paddle2.x;
+    arena.paddle_y[1] = paddle2.y;
+
+#ifdef BALLS_USE_SSE
+    simd_end = count & ~3;
+
+    float* position_x = m_position_x.data();
+    float* position_y = m_position_y.data();
+    float* movement_x = m_movement_x.data();
+    float* movement_y = m_movement_y.data();
+
+    const __m128 sign_bit = _mm_set1_ps(-0.0f);
+    const __m128 collision_x = _mm_set1_ps(m_collision_x);
+    const __m128 collision_y = _mm_set1_ps(m_collision_y);
+    const __m128 paddle_x = _mm_set1_ps(paddle.x);
+    const __m128 paddle_y = _mm_set1_ps(paddle.y);
+    const __m128 paddle2_x = _mm_set1_ps(paddle2.x);
+    const __m128 paddle2_y = _mm_set1_ps(paddle2.y);
+    const __m128 wall = _mm_set1_ps(m_wall_y);
+    const __m128 exit_right = _mm_set1_ps(m_exit_x);
+    const __m128 exit_left = _mm_set1_ps(-m_exit_x);
+    const __m128 step4 = _mm_set1_ps(step);
+
+    int left_mask = 0;
+    int right_mask = 0;
+
+    for (int i = 0; i < simd_end; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(position_x + i);
+        __m128 y = _mm_loadu_ps(position_y + i);
+        __m128 dx = _mm_mul_ps(_mm_loadu_ps(movement_x + i), step4);
+        __m128 dy = _mm_mul_ps(_mm_loadu_ps(movement_y + i), step4);
+
+        __m128 right = _mm_cmpgt_ps(x, exit_right);
+        __m128 left = _mm_cmplt_ps(x, exit_left);
+        if (m_respawn_exited)
+        {
+            x = _mm_andnot_ps(_mm_or_ps(left, right), x);
+        }
+        else
+        {
+            right_mask |= _mm_movemask_ps(right);
+            left_mask |= _mm_movemask_ps(left);
+        }
+
+        // Same test as ball_needs_sweep, for four balls at once; andnot with the sign bit is fabs
+        __m128 reach_x = _mm_andnot_ps(sign_bit, dx);
+        __m128 reach_y = _mm_andnot_ps(sign_bit, dy);
+        __m128 near_wall = _mm_cmpge_ps(_mm_add_ps(_mm_andnot_ps(sign_bit, y), reach_y), wall);
+        __m128 near_paddle = _mm_and_ps(
+            _mm_cmplt_ps(_mm_andnot_ps(sign_bit, _mm_sub_ps(x, paddle_x)), _mm_add_ps(collision_x, reach_x)),
+            _mm_cmplt_ps(_mm_andnot_ps(sign_bit, _mm_sub_ps(y, paddle_y)), _mm_add_ps(collision_y, reach_y)));
+        __m128 near_paddle2 = _mm_and_ps(
+            _mm_cmplt_ps(_mm_andnot_ps(sign_bit, _mm_sub_ps(x, paddle2_x)), _mm_add_ps(collision_x, reach_x)),
+            _mm_cmplt_ps(_mm_andnot_ps(sign_bit, _mm_sub_ps(y, paddle2_y)), _mm_add_ps(collision_y, reach_y)));
+        __m128 needs_sweep = _mm_or_ps(near_wall, _mm_or_ps(near_paddle, near_paddle2));
+
+        // Free balls move straight away; the rest keep their start position for the sweep
+        _mm_storeu_ps(position_x + i, _mm_or_ps(_mm_and_ps(needs_sweep, x), _mm_andnot_ps(needs_sweep, _mm_add_ps(x, dx))));
+        _mm_storeu_ps(position_y + i, _mm_or_ps(_mm_and_ps(needs_sweep, y), _mm_andnot_ps(needs_sweep, _mm_add_ps(y, dy))));
+
+        int sweep_mask = _mm_movemask_ps(needs_sweep);
+        for (int lane = 0; sweep_mask != 0; lane++, sweep_mask >>= 1)
+        {
+            if ((sweep_mask & 1) == 0) continue;
+            int index = i + lane;
+            sweep_ball(position_x[index], position_y[index], movement_x[index], movement_y[index], step, arena);
+            m_swept_count++;
+        }
+    }
+
+    m_right_exit = right_mask != 0;
+    m_left_exit = left_mask != 0;
+#endif
+
+    // Whatever doesn't fill a full group of four (or everything, without SSE)
+    update_range(simd_end, count, step, arena);
+}
+
+void BallPool::write_sprites(SpriteInstance *instance, const AtlasRegion& region, float rotation_degrees, float alpha) const
+{
+    int count = get_count();
+    float rotation = rotation_degrees * 0.01745329252f;
+
+    for (int i = 0; i < count; i++, instance++)
+    {
+        instance->x = m_previous_x[i] + (m_position_x[i] - m_previous_x[i]) * alpha;
+        instance->y = m_previous_y[i] + (m_position_y[i] - m_previous_y[i]) * alpha;
+        instance->rotation = rotation;
+        instance->scale_x = m_ball_size;
+        instance->scale_y = m_ball_size;
+        instance->u = region.u;
+        instance->v = region.v;
+        instance->uv_width = region.width;
+        instance->uv_height = region.height;
+        instance->red = 1.0f;
+        instance->green = 1.0f;
+        instance->blue = 1.0f;
+        instance->alpha = 1.0f;
+    }
+}
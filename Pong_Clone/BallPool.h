@@ -0,0 +1,68 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "BallSweep.h"
+#include "InstancedRenderer.h"
+#include "TextureAtlas.h"
+
+class BallPool
+{
+private:
+    // ————— BALLS ————— //
+    // One array per component (SoA) so the update can process four balls per step.
+    // Only balls that could touch a wall or paddle this step take the exact swept
+    // path in BallSweep; everything else just moves.
+    std::vector<float> m_position_x;
+    std::vector<float> m_position_y;
+    std::vector<float> m_movement_x;
+    std::vector<float> m_movement_y;
+    std::vector<float> m_previous_x;    // positions before the last step, for interpolation
+    std::vector<float> m_previous_y;
+
+    // ————— ARENA ————— //
+    float m_collision_x;    // paddle/ball overlap distances
+    float m_collision_y;
+    float m_wall_y;         // balls bounce off y = +-m_wall_y
+    float m_exit_x;         // balls past x = +-m_exit_x have left the arena
+    float m_ball_size;
+
+    bool m_respawn_exited = false;
+    bool m_left_exit  = false;
+    bool m_right_exit = false;
+    int  m_swept_count = 0;
+
+    void update_range(int start, int end, float step, const SweepArena& arena);
+
+public:
+    // ————— METHODS ————— //
+    BallPool(float collision_x, float collision_y, float wall_y, float exit_x, float ball_size);
+
+    void spawn(glm::vec3 position, glm::vec3 movement);
+    void clear();
+    // One fixed step; remembers where the balls were first
+    void update(float delta_time, float speed, const glm::vec3& paddle, const glm::vec3& paddle2);
+    // For callers that move the balls themselves
+    void save_previous();
+    // Writes one sprite per ball into `instance`, which has room for get_count(), so
+    // they all go out in a single draw. `alpha` places them between the previous and
+    // current step (0 = previous, 1 = current)
+    void write_sprites(SpriteInstance *instance, const AtlasRegion& region, float rotation_degrees, float alpha) const;
+
+    // ————— GETTERS ————— //
+    int       const get_count()      const { return (int) m_position_x.size(); };
+    glm::vec3 const get_position(int index) const { return glm::vec3(m_position_x[index], m_position_y[index], 0.0f); };
+    bool      const get_left_exit()  const { return m_left_exit;  };
+    bool      const get_right_exit() const { return m_right_exit; };
+    int       const get_swept_count() const { return m_swept_count; };
+
+    // ————— SETTERS ————— //
+    void const set_position(int index, glm::vec3 position) { m_position_x[index] = position.x; m_position_y[index] = position.y; };
+    // When set, balls that leave the arena are put back in the middle instead of ending the game
+    void const set_respawn_exited(bool respawn) { m_respawn_exited = respawn; };
+};
@@ -0,0 +1,127 @@
+#include "BallSweep.h"
+#include <math.h>
+
+enum SweepNormal { noNormal, normalX, normalY };
+
+int sweep_ball(float& x, float& y, float& movement_x, float& movement_y, float step, const SweepArena& arena)
+{
+    int bounces = 0;
+
+    // Already past a wall and still heading out (e.g. spawned there): turn it around
+    if ((y > arena.wall_y && movement_y > 0.0f) || (y < -arena.wall_y && movement_y < 0.0f))
+    {
+        movement_y = -movement_y;
+        bounces++;
+    }
+
+    // A paddle that moved onto the ball pushes it back out the way it came
+    for (int p = 0; p < 2; p++)
+    {
+        float dx = arena.paddle_x[p] - x;
+        if (fabs(dx) < arena.collision_x && fabs(arena.paddle_y[p] - y) < arena.collision_y && movement_x * dx > 0.0f)
+        {
+            movement_x = -movement_x;
+            bounces++;
+        }
+    }
+
+    float remaining = 1.0f; // fraction of the step still to travel
+
+    while (remaining > 0.0f && bounces < MAX_SWEEP_BOUNCES)
+    {
+        float velocity_x = movement_x * step;
+        float velocity_y = movement_y * step;
+
+        float impact = remaining;
+        SweepNormal normal = noNormal;
+
+        // Walls are horizontal lines, so only y matters
+        if (velocity_y > 0.0f && y <= arena.wall_y)
+        {
+            float t = (arena.wall_y - y) / velocity_y;
+            if (t < impact) { impact = t; normal = normalY; }
+        }
+        else if (velocity_y < 0.0f && y >= -arena.wall_y)
+        {
+            float t = (-arena.wall_y - y) / velocity_y;
+            if (t < impact) { impact = t; normal = normalY; }
+        }
+
+        // Paddles: slab test of the ball's path against each box
+        for (int p = 0; p < 2; p++)
+        {
+            float left = arena.paddle_x[p] - arena.collision_x;
+            float right = arena.paddle_x[p] + arena.collision_x;
+            float bottom = arena.paddle_y[p] - arena.collision_y;
+            float top = arena.paddle_y[p] + arena.collision_y;
+
+            float enter_x, exit_x, enter_y, exit_y;
+
+            if (velocity_x != 0.0f)
+            {
+                float t1 = (left - x) / velocity_x;
+                float t2 = (right - x) / velocity_x;
+                enter_x = fminf(t1, t2);
+                exit_x = fmaxf(t1, t2);
+            }
+            else
+            {
+                if (x <= left || x >= right) continue;
+                enter_x = -INFINITY;
+                exit_x = INFINITY;
+            }
+
+            if (velocity_y != 0.0f)
+            {
+                float t1 = (bottom - y) / velocity_y;
+                float t2 = (top - y) / velocity_y;
+                enter_y = fminf(t1, t2);
+                exit_y = fmaxf(t1, t2);
+            }
+            else
+            {
+                if (y <= bottom || y >= top) continue;
+                enter_y = -INFINITY;
+                exit_y = INFINITY;
+            }
+
+            float enter = fmaxf(enter_x, enter_y);
+            float exit = fminf(exit_x, exit_y);
+
+            // Only count paths that enter the box from outside within this step
+            if (enter >= 0.0f && enter <= exit && enter < impact)
+            {
+                impact = enter;
+                normal = enter_x > enter_y ? normalX : normalY;
+            }
+        }
+
+        x += velocity_x * impact;
+        y += velocity_y * impact;
+        remaining -= impact;
+
+        if (normal == noNormal) break;
+
+        if (normal == normalX) movement_x = -movement_x;
+        else movement_y = -movement_y;
+        bounces++;
+    }
+
+    return bounces;
+}
+
+bool ball_needs_sweep(float x, float y, float movement_x, float movement_y, float step, const SweepArena& arena)
+{
+    float reach_x = fabs(movement_x * step);
+    float reach_y = fabs(movement_y * step);
+
+    if (fabs(y) + reach_y >= arena.wall_y) return true;
+
+    for (int p = 0; p < 2; p++)
+    {
+        if (fabs(x - arena.paddle_x[p]) < arena.collision_x + reach_x &&
+            fabs(y - arena.paddle_y[p]) < arena.collision_y + reach_y) return true;
+    }
+
+    return false;
+}
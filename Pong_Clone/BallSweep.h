@@ -0,0 +1,27 @@
+#pragma once
+
+// Upper bound on bounces resolved for one ball in one step. A ball wedged
+// between a paddle and a wall stops here instead of spinning forever.
+const int MAX_SWEEP_BOUNCES = 8;
+
+// Everything a ball can bounce off. Paddles are boxes of half size
+// (collision_x, collision_y) around the ball centre, i.e. the paddle already
+// grown by the ball, so the ball itself can be swept as a point.
+struct SweepArena
+{
+    float collision_x;
+    float collision_y;
+    float wall_y;
+    float paddle_x[2];
+    float paddle_y[2];
+};
+
+// Moves a ball through one step of length `step` (speed * delta time), finding
+// the exact time of impact against the walls and both paddles and reflecting
+// off the face it hit, as many times as happen within the step. Paddles are
+// treated as standing still for the step. Returns the number of bounces.
+int sweep_ball(float& x, float& y, float& movement_x, float& movement_y, float step, const SweepArena& arena);
+
+// Conservative test for whether a ball could touch anything during the step.
+// Balls that can't are moved with a plain position += movement * step.
+bool ball_needs_sweep(float x, float y, float movement_x, float movement_y, float step, const SweepArena& arena);
@@ -0,0 +1,58 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "InstancedRenderer.h"
+
+enum RenderCommandType { RENDER_CLEAR, RENDER_CAMERA, RENDER_QUAD, RENDER_SPRITES };
+
+const int SPRITE_INSTANCE_FLOATS = sizeof(SpriteInstance) / sizeof(float);
+
+// One recorded draw or state change. Matrices, vertices and sprite instances
+// are copied into the list's float data; `data_offset` says where this
+// command's start.
+struct RenderCommand
+{
+    RenderCommandType type;
+    GLuint texture_id;
+    int    data_offset;
+    int    count;           // quad: 0 for the unit quad, 6 with its own vertices; sprites: instance count
+};
+
+// A frame's worth of rendering, recorded without touching GL, so the same
+// frame can be drawn, only counted, or written to a file. Everything is
+// copied in, so the simulation is free to move on as soon as a command is
+// recorded. The vectors keep their capacity across frames.
+class CommandList
+{
+private:
+    std::vector<RenderCommand> m_commands;
+    std::vector<float> m_data;
+
+    RenderCommand& push(RenderCommandType type, int floats);
+
+public:
+    void reset() { m_commands.clear(); m_data.clear(); };
+
+    void clear();
+    void set_camera(const glm::mat4& view_matrix, const glm::mat4& projection_matrix);
+    void draw_quad(const glm::mat4& model_matrix, GLuint texture_id);
+    // vertices and tex_coords hold 6 vertices of 2 floats each
+    void draw_quad(const glm::mat4& model_matrix, GLuint texture_id, const float* vertices, const float* tex_coords);
+    // Returns room for `count` sprites from one texture, drawn in one go. Fill
+    // it before recording anything else; the next command may move it.
+    SpriteInstance* draw_sprites(GLuint texture_id, int count);
+    // Replaces the list with commands read back from a recording
+    void assign(const std::vector<RenderCommand>& commands, const std::vector<float>& data) { m_commands = commands; m_data = data; };
+
+    const std::vector<RenderCommand>& get_commands() const { return m_commands; };
+    const float* get_data(int offset)                const { return m_data.data() + offset; };
+    size_t       get_data_size()                     const { return m_data.size(); };
+    glm::mat4    get_matrix(int offset)              const;
+    const SpriteInstance* get_sprites(int offset)    const { return (const SpriteInstance*) (m_data.data() + offset); };
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <SDL.h>
+
+const float FIXED_TIMESTEP = 1.0f / 60.0f;   // seconds simulated per step
+const int   FIXED_TIMESTEP_MAX_STEPS = 8;    // per frame; any more real time than that is dropped
+
+// Turns real time into a whole number of fixed simulation steps. advance()
+// reads the performance counter once a frame and says how many steps to run;
+// whatever is left over carries into the next frame, and get_alpha() is how
+// far the present lies between the last two simulated states, for rendering.
+// Capping the steps per frame keeps a slow frame from asking for more steps,
+// which would make the next frame slower still.
+class FixedTimestep
+{
+private:
+    Uint64 m_frequency = 1;
+    Uint64 m_previous_counter = 0;
+    double m_accumulator = 0.0;
+    float  m_step = FIXED_TIMESTEP;
+    int    m_max_steps = FIXED_TIMESTEP_MAX_STEPS;
+    double m_frame_seconds = 0.0;
+
+    // ————— STATS ————— //
+    double m_dropped_seconds = 0.0;
+    unsigned long long m_total_steps = 0;
+
+public:
+    void start(float step = FIXED_TIMESTEP, int max_steps = FIXED_TIMESTEP_MAX_STEPS);
+    // Steps to run for the real time since the last call
+    int  advance();
+    // The same for a given amount of time, for headless runs and replays
+    int  advance(double seconds);
+
+    float const get_step()  const { return m_step; };
+    // Real time the last advance() covered
+    float const get_frame_seconds() const { return (float) m_frame_seconds; };
+    // 0 = draw the previous state, 1 = draw the latest one
+    float const get_alpha() const { return (float) (m_accumulator / m_step); };
+    double const get_dropped_seconds() const { return m_dropped_seconds; };
+    unsigned long long const get_total_steps() const { return m_total_steps; };
+};
@@ -0,0 +1,175 @@
+#include "FrameTimeRecorder.h"
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const int HALF_SUB_BUCKETS = FRAME_HISTOGRAM_SUB_BUCKETS / 2;
+
+// ————— HISTOGRAM ————— //
+
+int FrameTimeHistogram::bucket_index(Uint64 us)
+{
+    if (us < (Uint64) FRAME_HISTOGRAM_SUB_BUCKETS) return (int) us;
+
+    // Shift until the value fits in the top half of a sub-bucket range
+    int shift = 0;
+    while ((us >> shift) >= (Uint64) FRAME_HISTOGRAM_SUB_BUCKETS) shift++;
+    if (shift > FRAME_HISTOGRAM_MAX_SHIFT) return FRAME_HISTOGRAM_BUCKETS - 1;
+
+    return FRAME_HISTOGRAM_SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + (int) (us >> shift) - HALF_SUB_BUCKETS;
+}
+
+Uint64 FrameTimeHistogram::bucket_upper(int index)
+{
+    if (index < FRAME_HISTOGRAM_SUB_BUCKETS) return (Uint64) index;
+
+    int shift = (index - FRAME_HISTOGRAM_SUB_BUCKETS) / HALF_SUB_BUCKETS + 1;
+    Uint64 sub_bucket = (index - FRAME_HISTOGRAM_SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+void FrameTimeHistogram::record(Uint64 us)
+{
+    m_counts[bucket_index(us)]++;
+    m_total++;
+    m_sum_us += us;
+    m_max_us = std::max(m_max_us, us);
+}
+
+Uint64 FrameTimeHistogram::value_at_percentile(double percentile) const
+{
+    if (m_total == 0) return 0;
+
+    Uint64 rank = (Uint64) ceil(percentile / 100.0 * m_total);
+    if (rank < 1) rank = 1;
+
+    Uint64 seen = 0;
+    for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += m_counts[i];
+        if (seen >= rank) return std::min(bucket_upper(i), m_max_us);
+    }
+    return m_max_us;
+}
+
+// ————— RECORDER ————— //
+
+void FrameTimeRecorder::start(float budget_ms)
+{
+    m_frequency = SDL_GetPerformanceFrequency();
+    m_start_counts = SDL_GetPerformanceCounter();
+    m_last_counts = m_start_counts;
+    m_budget_ms = budget_ms;
+    m_hitches.reserve(FRAME_MAX_HITCHES);
+}
+
+void FrameTimeRecorder::end_frame(bool throttled)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 elapsed = now - m_last_counts;
+    m_last_counts = now;
+    if (throttled) return;
+
+    m_histogram.record(elapsed * 1000000 / m_frequency);
+    m_frames++;
+
+    double ms = elapsed * 1000.0 / m_frequency;
+    if (ms <= m_budget_ms) return;
+
+    m_hitch_count++;
+    if (m_hitches.size() >= (size_t) FRAME_MAX_HITCHES) return;
+
+    FrameHitch hitch;
+    hitch.frame = m_frames - 1;
+    hitch.time_seconds = (double) (now - m_start_counts) / m_frequency;
+    hitch.ms = ms;
+    hitch.end_counts = now;
+
+    const std::vector<ScopeTotal>& scopes = g_profiler.get_frame_scopes();
+    hitch.scopes.assign(scopes.begin(), scopes.begin() + std::min(scopes.size(), (size_t) FRAME_HITCH_TOP_SCOPES));
+
+    Uint64 window = (Uint64) (FRAME_HITCH_MARK_SECONDS * m_frequency);
+    hitch.marks = g_profiler.get_recent_marks(now > window ? now - window : 0);
+
+    m_hitches.push_back(hitch);
+}
+
+bool FrameTimeRecorder::write_report(const char* path) const
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        std::cout << "Unable to write frame report " << path << std::endl;
+        return false;
+    }
+
+    fprintf(file, "{\"frames\":%d,\"seconds\":%.3f,\"budget_ms\":%.3f,\"hitches\":%d,\n", m_frames,
+        (double) (m_last_counts - m_start_counts) / m_frequency, m_budget_ms, m_hitch_count);
+    fprintf(file, "\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p95_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,\n",
+        m_histogram.get_mean_us() / 1000.0, m_histogram.value_at_percentile(50.0) / 1000.0, m_histogram.value_at_percentile(95.0) / 1000.0,
+        m_histogram.value_at_percentile(99.0) / 1000.0, m_histogram.get_max_us() / 1000.0);
+
+    // Only the buckets in use, as [largest microseconds in the bucket, frames]
+    fprintf(file, "\"histogram_us\":[");
+    const char* separator = "";
+    for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++)
+    {
+        if (m_histogram.get_count(i) == 0) continue;
+        fprintf(file, "%s[%llu,%llu]", separator, (unsigned long long) FrameTimeHistogram::bucket_upper(i), (unsigned long long) m_histogram.get_count(i));
+        separator = ",";
+    }
+    fprintf(file, "],\n\"hitch_frames\":[");
+
+    for (size_t i = 0; i < m_hitches.size(); i++)
+    {
+        const FrameHitch& hitch = m_hitches[i];
+        fprintf(file, "%s\n{\"frame\":%d,\"time_s\":%.3f,\"ms\":%.3f,\"scopes\":[", i > 0 ? "," : "", hitch.frame, hitch.time_seconds, hitch.ms);
+
+        for (size_t j = 0; j < hitch.scopes.size(); j++)
+        {
+            const ScopeTotal& scope = hitch.scopes[j];
+            fprintf(file, "%s{\"name\":", j > 0 ? "," : "");
+            write_json_string(file, scope.name);
+            fprintf(file, ",\"gpu\":%s,\"ms\":%.3f,\"count\":%d}", scope.gpu ? "true" : "false", scope.ms, scope.count);
+        }
+        fprintf(file, "],\"marks\":[");
+
+        for (size_t j = 0; j < hitch.marks.size(); j++)
+        {
+            const ProfileMark& mark = hitch.marks[j];
+            fprintf(file, "%s{\"name\":", j > 0 ? "," : "");
+            write_json_string(file, mark.name);
+            fprintf(file, ",\"detail\":");
+            write_json_string(file, mark.detail);
+            fprintf(file, ",\"ms_before_end\":%.3f}", (double) (hitch.end_counts - mark.time) * 1000.0 / m_frequency);
+        }
+        fprintf(file, "]}");
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+
+void FrameTimeRecorder::print_summary() const
+{
+    if (m_frames == 0) return;
+
+    char line[160];
+    snprintf(line, sizeof(line), "%d frames: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms; %d over %.1f ms", m_frames,
+        m_histogram.value_at_percentile(50.0) / 1000.0, m_histogram.value_at_percentile(95.0) / 1000.0,
+        m_histogram.value_at_percentile(99.0) / 1000.0, m_histogram.get_max_us() / 1000.0, m_hitch_count, m_budget_ms);
+    std::cout << line << std::endl;
+}
+
+void parse_frame_report_arguments(int argc, char* argv[], const char** report_path, float* budget_ms)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--frame-report") == 0) *report_path = argv[i + 1];
+        if (strcmp(argv[i], "--hitch-ms") == 0) *budget_ms = (float) atof(argv[i + 1]);
+    }
+}
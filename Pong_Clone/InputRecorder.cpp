@@ -0,0 +1,151 @@
+#include "InputRecorder.h"
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+
+// ————— RECORDING ————— //
+
+void InputRecorder::start(const char* path, unsigned int seed, float step)
+{
+    m_runs.clear();
+    m_pending_pressed = 0;
+    m_ticks = 0;
+    m_seed = seed;
+    m_step = step;
+    m_path = path;
+}
+
+void InputRecorder::record_tick(InputActions held)
+{
+    if (m_path == NULL) return;
+
+    InputActions pressed = m_pending_pressed;
+    m_pending_pressed = 0;
+    m_ticks++;
+
+    // A tick with presses always starts a run of its own
+    if (pressed == 0 && !m_runs.empty() && m_runs.back().held == held && m_runs.back().pressed == 0)
+    {
+        m_runs.back().ticks++;
+        return;
+    }
+    m_runs.push_back({ held, pressed, 1 });
+}
+
+bool InputRecorder::stop()
+{
+    if (m_path == NULL) return false;
+    const char* path = m_path;
+    m_path = NULL;
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        std::cout << "Unable to write input recording " << path << std::endl;
+        return false;
+    }
+
+    InputRecordingHeader header = {};
+    header.magic = INPUT_RECORDING_MAGIC;
+    header.version = INPUT_RECORDING_VERSION;
+    header.seed = m_seed;
+    header.tick_count = m_ticks;
+    header.run_count = (unsigned int) m_runs.size();
+    header.step = m_step;
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (written && !m_runs.empty()) written = fwrite(m_runs.data(), sizeof(InputRun), m_runs.size(), file) == m_runs.size();
+    fclose(file);
+
+    if (!written) std::cout << "Unable to write input recording " << path << std::endl;
+    else std::cout << "Recorded " << m_ticks << " ticks of input to " << path << std::endl;
+    return written;
+}
+
+// ————— REPLAY ————— //
+
+bool InputReplay::load(const char* path)
+{
+    m_header = InputRecordingHeader();
+    m_runs.clear();
+    m_run = 0;
+    m_run_tick = 0;
+    m_tick = 0;
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        std::cout << "Unable to open input recording " << path << std::endl;
+        return false;
+    }
+
+    InputRecordingHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+        && header.magic == INPUT_RECORDING_MAGIC && header.version == INPUT_RECORDING_VERSION && header.step > 0.0f;
+    if (valid)
+    {
+        // The header's count is only believed if the file really holds that
+        // many runs, so a damaged one can't ask for a huge allocation
+        long runs_start = ftell(file);
+        valid = fseek(file, 0, SEEK_END) == 0 && (unsigned long long) (ftell(file) - runs_start) == (unsigned long long) header.run_count * sizeof(InputRun)
+            && fseek(file, runs_start, SEEK_SET) == 0;
+    }
+    if (valid)
+    {
+        m_runs.resize(header.run_count);
+        valid = header.run_count == 0 || fread(m_runs.data(), sizeof(InputRun), m_runs.size(), file) == m_runs.size();
+    }
+    fclose(file);
+
+    unsigned long long ticks = 0;
+    for (const InputRun& run : m_runs) ticks += run.ticks;
+    valid = valid && ticks == header.tick_count;
+
+    if (!valid)
+    {
+        std::cout << path << " isn't an input recording this build can read" << std::endl;
+        m_runs.clear();
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+bool InputReplay::next(InputActions* held, InputActions* pressed)
+{
+    while (m_run < m_runs.size() && m_run_tick >= m_runs[m_run].ticks)
+    {
+        m_run++;
+        m_run_tick = 0;
+    }
+    if (m_run == m_runs.size()) return false;
+
+    const InputRun& run = m_runs[m_run];
+    *held = run.held;
+    *pressed = m_run_tick == 0 ? run.pressed : 0;
+    m_run_tick++;
+    m_tick++;
+    return true;
+}
+
+// ————— HASH ————— //
+
+void StateHash::add(const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*) data;
+    for (size_t i = 0; i < size; i++)
+    {
+        m_hash ^= bytes[i];
+        m_hash *= 16777619u;
+    }
+}
+
+void parse_input_recording_arguments(int argc, char* argv[], const char** record_path, const char** replay_path)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--record") == 0) *record_path = argv[i + 1];
+        if (strcmp(argv[i], "--replay") == 0) *replay_path = argv[i + 1];
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stddef.h>
+#include <vector>
+
+// One bit per game action; what each bit means is up to the game
+typedef unsigned short InputActions;
+
+const unsigned int INPUT_RECORDING_MAGIC = 0x54504E49;     // "INPT"
+const unsigned int INPUT_RECORDING_VERSION = 1;
+
+// A recording is a header followed by runs: each run is a number of
+// simulation ticks that all had the same input. Held keys barely change from
+// one tick to the next, so a minute of play is usually a few hundred bytes.
+struct InputRecordingHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int seed;          // what rand() was seeded with before the first tick
+    unsigned int tick_count;
+    unsigned int run_count;
+    float        step;          // seconds per tick
+};
+
+struct InputRun
+{
+    InputActions held;          // down for the whole tick
+    InputActions pressed;       // went down just before the tick; only ever on a run of one
+    unsigned int ticks;
+};
+
+// Logs the input every simulation tick sees while the game is played live.
+// press() is called as key presses come in and record_tick() once per fixed
+// step, right before the step runs; presses wait for the next tick, so a
+// frame that runs no steps loses nothing.
+class InputRecorder
+{
+private:
+    std::vector<InputRun> m_runs;
+    InputActions m_pending_pressed = 0;
+    unsigned int m_ticks = 0;
+    unsigned int m_seed = 0;
+    float        m_step = 0.0f;
+    const char*  m_path = NULL;
+
+public:
+    void start(const char* path, unsigned int seed, float step);
+    void press(InputActions actions) { m_pending_pressed |= actions; };
+    void record_tick(InputActions held);
+    // Writes the file
+    bool stop();
+
+    bool const is_recording() const { return m_path != NULL; };
+};
+
+// Plays a recording back one tick at a time
+class InputReplay
+{
+private:
+    InputRecordingHeader  m_header = {};
+    std::vector<InputRun> m_runs;
+    size_t       m_run = 0;
+    unsigned int m_run_tick = 0;
+    unsigned int m_tick = 0;
+
+public:
+    bool load(const char* path);
+    // False once every tick has been handed out
+    bool next(InputActions* held, InputActions* pressed);
+
+    bool         const is_loaded()      const { return m_header.magic == INPUT_RECORDING_MAGIC; };
+    unsigned int const get_seed()       const { return m_header.seed; };
+    float        const get_step()       const { return m_header.step; };
+    unsigned int const get_tick_count() const { return m_header.tick_count; };
+    unsigned int const get_tick()       const { return m_tick; };
+};
+
+// FNV-1a over whatever the game feeds it, so two runs of the same recording
+// can be checked for ending in the same state
+class StateHash
+{
+private:
+    unsigned int m_hash = 2166136261u;
+
+public:
+    void add(const void* data, size_t size);
+    template <typename T>
+    void add(const T& value) { add(&value, sizeof(value)); };
+
+    unsigned int const get() const { return m_hash; };
+};
+
+// Reads --record FILE and --replay FILE from the command line
+void parse_input_recording_arguments(int argc, char* argv[], const char** record_path, const char** replay_path);
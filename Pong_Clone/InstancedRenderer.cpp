@@ -0,0 +1,113 @@
+#include "InstancedRenderer.h"
+#include "RenderStats.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+// Unit quad centred on the origin; the instance scale sizes it. Texture v runs
+// bottom to top, so an instance flips the image with a negative uv_height.
+const float QUAD_VERTICES[] = {
+    // position    texCoord
+    -0.5f, -0.5f,  0.0f, 0.0f,
+     0.5f, -0.5f,  1.0f, 0.0f,
+     0.5f,  0.5f,  1.0f, 1.0f,
+    -0.5f, -0.5f,  0.0f, 0.0f,
+     0.5f,  0.5f,  1.0f, 1.0f,
+    -0.5f,  0.5f,  0.0f, 1.0f
+};
+
+void InstancedRenderer::load(const char* vertex_shader_file, const char* fragment_shader_file)
+{
+    start_load(vertex_shader_file, fragment_shader_file);
+    finish_load();
+}
+
+void InstancedRenderer::start_load(const char* vertex_shader_file, const char* fragment_shader_file)
+{
+    // glDrawArraysInstanced is 3.1 and glVertexAttribDivisor is 3.3
+    int major = 0, minor = 0;
+    const char* version = (const char*) glGetString(GL_VERSION);
+    if (version == NULL || sscanf(version, "%d.%d", &major, &minor) != 2 || major * 10 + minor < 33)
+    {
+        printf("OpenGL %s has no instancing, using the batched path\n", version ? version : "?");
+        return;
+    }
+
+    m_program.start_load(vertex_shader_file, fragment_shader_file);
+    m_loading = true;
+}
+
+void InstancedRenderer::finish_load()
+{
+    if (!m_loading) return;
+    m_loading = false;
+
+    m_program.finish_load();
+
+    m_offset_attribute   = glGetAttribLocation(m_program.get_program_id(), "instanceOffset");
+    m_rotation_attribute = glGetAttribLocation(m_program.get_program_id(), "instanceRotation");
+    m_scale_attribute    = glGetAttribLocation(m_program.get_program_id(), "instanceScale");
+    m_uv_attribute       = glGetAttribLocation(m_program.get_program_id(), "instanceUV");
+    m_tint_attribute     = glGetAttribLocation(m_program.get_program_id(), "instanceTint");
+    m_attribute_mask = m_program.get_attribute_mask() | attribute_bit(m_offset_attribute) | attribute_bit(m_rotation_attribute)
+        | attribute_bit(m_scale_attribute) | attribute_bit(m_uv_attribute) | attribute_bit(m_tint_attribute);
+
+    glGenBuffers(1, &m_quad_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICES), QUAD_VERTICES, GL_STATIC_DRAW);
+
+    // Everything else in the game draws from client memory, which only works
+    // while no buffer is bound
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_supported = true;
+}
+
+void InstancedRenderer::bind_instance_attribute(GLint attribute, int components, size_t offset)
+{
+    if (attribute < 0) return;
+
+    glVertexAttribPointer(attribute, components, GL_FLOAT, false, sizeof(SpriteInstance), (const void*) offset);
+    glVertexAttribDivisor(attribute, 1);
+}
+
+void InstancedRenderer::draw(const SpriteInstance* instances, int count, GLuint texture_id, const glm::mat4& view_matrix, const glm::mat4& projection_matrix,
+                             StreamBuffer* stream)
+{
+    if (!m_supported || count == 0) return;
+
+    g_gl_state.use_program(m_program.get_program_id());
+    m_program.set_view_matrix(view_matrix);
+    m_program.set_projection_matrix(projection_matrix);
+    g_gl_state.bind_texture(texture_id);
+
+    size_t bytes = count * sizeof(SpriteInstance);
+    size_t offset;
+    memcpy(stream->reserve(bytes, offset), instances, bytes);
+    stream->commit();
+
+    glBindBuffer(GL_ARRAY_BUFFER, stream->get_buffer());
+    bind_instance_attribute(m_offset_attribute,   2, offset + offsetof(SpriteInstance, x));
+    bind_instance_attribute(m_rotation_attribute, 1, offset + offsetof(SpriteInstance, rotation));
+    bind_instance_attribute(m_scale_attribute,    2, offset + offsetof(SpriteInstance, scale_x));
+    bind_instance_attribute(m_uv_attribute,       4, offset + offsetof(SpriteInstance, u));
+    bind_instance_attribute(m_tint_attribute,     4, offset + offsetof(SpriteInstance, red));
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_buffer);
+    glVertexAttribPointer(m_program.get_position_attribute(), 2, GL_FLOAT, false, 4 * sizeof(float), (const void*) 0);
+    glVertexAttribPointer(m_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 4 * sizeof(float), (const void*) (2 * sizeof(float)));
+    g_gl_state.set_attributes(m_attribute_mask);
+
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei) count);
+    g_render_stats.count_draw(GL_TRIANGLES, 6, count);
+
+    // The cache only knows which attributes are enabled, so the divisors go
+    // back to 0 here for the sprite program, which may reuse these locations,
+    // and no buffer is left bound for the draws from client memory
+    GLint instance_attributes[] = { m_offset_attribute, m_rotation_attribute, m_scale_attribute, m_uv_attribute, m_tint_attribute };
+    for (GLint attribute : instance_attributes)
+    {
+        if (attribute >= 0) glVertexAttribDivisor(attribute, 0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+
+// Everything the instanced vertex shader needs to place one sprite. The
+// transform is built on the GPU, so the CPU never touches a matrix.
+struct SpriteInstance
+{
+    float x, y;
+    float rotation;                 // radians
+    float scale_x, scale_y;
+    float u, v, uv_width, uv_height;
+    float red, green, blue, alpha;
+};
+
+// Draws any number of textured quads with one glDrawArraysInstanced call.
+// Needs GL 3.3; is_supported() is false on older contexts, and the GL backend
+// then expands the sprites into a streamed batch itself.
+class InstancedRenderer
+{
+private:
+    ShaderProgram m_program;
+    bool   m_supported = false;
+    bool   m_loading = false;
+
+    GLuint m_quad_buffer = 0;
+
+    GLint m_offset_attribute;
+    GLint m_rotation_attribute;
+    GLint m_scale_attribute;
+    GLint m_uv_attribute;
+    GLint m_tint_attribute;
+    unsigned int m_attribute_mask = 0;      // the quad's attributes and the instance ones, for GLState
+
+    void bind_instance_attribute(GLint attribute, int components, size_t offset);
+
+public:
+    void load(const char* vertex_shader_file, const char* fragment_shader_file);
+    // Split like ShaderProgram's, so the program can compile alongside others
+    void start_load(const char* vertex_shader_file, const char* fragment_shader_file);
+    void finish_load();
+
+    // Copies the instances into the stream buffer and draws them all
+    void draw(const SpriteInstance* instances, int count, GLuint texture_id, const glm::mat4& view_matrix, const glm::mat4& projection_matrix,
+              StreamBuffer* stream);
+
+    bool const is_supported()         const { return m_supported; };
+};
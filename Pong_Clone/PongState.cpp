@@ -0,0 +1,78 @@
+#include "PongState.h"
+#include "BallSweep.h"
+#include <string.h>
+
+// Same starting spots as the local game
+const float START_Y[MAX_PONG_BALLS] = { 0.0f, 2.0f, -2.0f };
+const float START_MOVEMENT[MAX_PONG_BALLS] = { 0.5f, -0.5f, -0.5f };
+
+void pong_reset(PongState& state, int ball_count)
+{
+    // Zero everything, padding included, so pong_hash sees the same bytes on every peer
+    memset(&state, 0, sizeof(state));
+
+    state.ball_speed = PONG_BALL_SPEED;
+    state.ball_count = (unsigned char) (ball_count < MAX_PONG_BALLS ? ball_count : MAX_PONG_BALLS);
+    state.result = pongPlaying;
+
+    for (int i = 0; i < state.ball_count; i++)
+    {
+        state.ball_y[i] = START_Y[i];
+        state.movement_x[i] = START_MOVEMENT[i];
+        state.movement_y[i] = START_MOVEMENT[i];
+    }
+}
+
+void pong_simulate(PongState& state, PongInput input, PongInput input2, float delta_time)
+{
+    state.frame++;
+    if (state.result != pongPlaying) return;
+
+    PongInput inputs[2] = { input, input2 };
+    for (int p = 0; p < 2; p++)
+    {
+        if (state.paddle_y[p] < PONG_PADDLE_LIMIT && (inputs[p] & PONG_INPUT_UP)) state.paddle_y[p] += PONG_PADDLE_SPEED * delta_time;
+        if (state.paddle_y[p] > -PONG_PADDLE_LIMIT && (inputs[p] & PONG_INPUT_DOWN)) state.paddle_y[p] -= PONG_PADDLE_SPEED * delta_time;
+    }
+
+    SweepArena arena;
+    arena.collision_x = PONG_COLLISION_X;
+    arena.collision_y = PONG_COLLISION_Y;
+    arena.wall_y = PONG_WALL_Y;
+    arena.paddle_x[0] = -PONG_PADDLE_X;
+    arena.paddle_y[0] = state.paddle_y[0];
+    arena.paddle_x[1] = PONG_PADDLE_X;
+    arena.paddle_y[1] = state.paddle_y[1];
+
+    float step = state.ball_speed * delta_time;
+
+    for (int i = 0; i < state.ball_count; i++)
+    {
+        // Leaving on the right is a point for player 1, on the left for player 2
+        if (state.ball_x[i] > PONG_EXIT_X) state.result = pongPlayer1Wins;
+        if (state.ball_x[i] < -PONG_EXIT_X) state.result = pongPlayer2Wins;
+
+        if (ball_needs_sweep(state.ball_x[i], state.ball_y[i], state.movement_x[i], state.movement_y[i], step, arena))
+        {
+            sweep_ball(state.ball_x[i], state.ball_y[i], state.movement_x[i], state.movement_y[i], step, arena);
+        }
+        else
+        {
+            state.ball_x[i] += state.movement_x[i] * step;
+            state.ball_y[i] += state.movement_y[i] * step;
+        }
+    }
+}
+
+unsigned int pong_hash(const PongState& state)
+{
+    // FNV-1a
+    const unsigned char* bytes = (const unsigned char*) &state;
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(state); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
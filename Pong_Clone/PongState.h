@@ -0,0 +1,43 @@
+#pragma once
+
+// The whole of a Pong match as plain data: no pointers, no std::vector, so a
+// snapshot is just a copy of the struct and restoring it is another copy.
+// Used wherever a match has to be stepped without a window (netplay rollback,
+// the match server), with the same rules as the local game in main.cpp.
+
+const int MAX_PONG_BALLS = 3;
+
+const float PONG_PADDLE_X = 4.0f;
+const float PONG_PADDLE_LIMIT = 3.5f;
+const float PONG_PADDLE_SPEED = 5.0f;
+const float PONG_COLLISION_X = 0.375f;
+const float PONG_COLLISION_Y = 0.8f;
+const float PONG_WALL_Y = 3.5f;
+const float PONG_EXIT_X = 5.0f;
+const float PONG_BALL_SPEED = 3.0f;
+
+// One byte of input per player per frame
+typedef unsigned char PongInput;
+const PongInput PONG_INPUT_UP   = 1 << 0;
+const PongInput PONG_INPUT_DOWN = 1 << 1;
+
+enum PongResult { pongPlaying, pongPlayer1Wins, pongPlayer2Wins };
+
+struct PongState
+{
+    int   frame;
+    float paddle_y[2];
+    float ball_x[MAX_PONG_BALLS];
+    float ball_y[MAX_PONG_BALLS];
+    float movement_x[MAX_PONG_BALLS];
+    float movement_y[MAX_PONG_BALLS];
+    float ball_speed;
+    unsigned char ball_count;
+    unsigned char result;
+};
+
+void pong_reset(PongState& state, int ball_count);
+void pong_simulate(PongState& state, PongInput input, PongInput input2, float delta_time);
+
+// Cheap checksum of the state, for spotting desyncs between peers
+unsigned int pong_hash(const PongState& state);
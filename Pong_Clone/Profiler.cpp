@@ -0,0 +1,330 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+
+Profiler g_profiler;
+
+const int PROFILER_GPU_TRACK = 1000;    // trace thread id of the GPU track
+
+static thread_local Profiler* t_owner = NULL;
+static thread_local void*     t_buffer = NULL;
+
+Profiler::~Profiler()
+{
+    for (ThreadBuffer* buffer : m_threads) delete buffer;
+}
+
+void Profiler::start(const char* trace_path)
+{
+    m_frequency = SDL_GetPerformanceFrequency();
+    m_start_counts = SDL_GetPerformanceCounter();
+    m_trace_path = trace_path != NULL ? trace_path : "";
+    if (!m_trace_path.empty()) m_trace.reserve(PROFILER_TRACE_EVENTS / 16);
+}
+
+void Profiler::stop()
+{
+    end_frame();
+    if (!m_trace_path.empty() && write_trace(m_trace_path.c_str()))
+    {
+        std::cout << "Wrote " << m_trace.size() << " profile events to " << m_trace_path << std::endl;
+    }
+
+    // The queries go with the context; it may not be current here any more
+    m_gpu_supported = false;
+}
+
+Profiler::ThreadBuffer* Profiler::get_thread_buffer()
+{
+    if (t_owner == this) return (ThreadBuffer*) t_buffer;
+
+    ThreadBuffer* buffer = new ThreadBuffer();
+    {
+        std::lock_guard<std::mutex> lock(m_threads_mutex);
+        buffer->index = (int) m_threads.size();
+        buffer->name = "Thread " + std::to_string(buffer->index);
+        m_threads.push_back(buffer);
+    }
+    t_owner = this;
+    t_buffer = buffer;
+    return buffer;
+}
+
+void Profiler::set_thread_name(const char* name)
+{
+    ThreadBuffer* buffer = get_thread_buffer();
+    std::lock_guard<std::mutex> lock(m_threads_mutex);
+    buffer->name = name;
+}
+
+void Profiler::record(const char* name, Uint64 start_counts, Uint64 end_counts, bool gpu)
+{
+    ThreadBuffer* buffer = get_thread_buffer();
+
+    unsigned int write = buffer->write.load(std::memory_order_relaxed);
+    if (write - buffer->read.load(std::memory_order_acquire) >= (unsigned int) PROFILER_THREAD_EVENTS)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ProfileEvent& event = buffer->events[write % PROFILER_THREAD_EVENTS];
+    event.name = name;
+    event.start = start_counts;
+    event.end = end_counts;
+    event.thread = buffer->index;
+    event.gpu = gpu;
+    buffer->write.store(write + 1, std::memory_order_release);
+}
+
+// ————— MARKS ————— //
+
+void Profiler::mark(const char* name, const char* detail)
+{
+    ProfileMark mark;
+    mark.name = name;
+    snprintf(mark.detail, sizeof(mark.detail), "%s", detail != NULL ? detail : "");
+    mark.time = SDL_GetPerformanceCounter();
+    mark.thread = get_thread_buffer()->index;
+
+    std::lock_guard<std::mutex> lock(m_marks_mutex);
+    m_recent_marks[m_mark_count++ % PROFILER_RECENT_MARKS] = mark;
+    if (!m_trace_path.empty() && m_trace_marks.size() < PROFILER_TRACE_EVENTS) m_trace_marks.push_back(mark);
+}
+
+std::vector<ProfileMark> Profiler::get_recent_marks(Uint64 since_counts) const
+{
+    std::vector<ProfileMark> marks;
+    std::lock_guard<std::mutex> lock(m_marks_mutex);
+
+    int first = m_mark_count > PROFILER_RECENT_MARKS ? m_mark_count - PROFILER_RECENT_MARKS : 0;
+    for (int i = first; i < m_mark_count; i++)
+    {
+        const ProfileMark& mark = m_recent_marks[i % PROFILER_RECENT_MARKS];
+        if (mark.time >= since_counts) marks.push_back(mark);
+    }
+    return marks;
+}
+
+// ————— GPU ————— //
+
+void Profiler::start_gpu()
+{
+    if (!PROFILER_ENABLED || m_gpu_supported) return;
+
+    int major = 0, minor = 0;
+    const char* version = (const char*) glGetString(GL_VERSION);
+    bool core_timer_query = version != NULL && sscanf(version, "%d.%d", &major, &minor) == 2 && major * 10 + minor >= 33;
+    if (!core_timer_query && !SDL_GL_ExtensionSupported("GL_ARB_timer_query"))
+    {
+        std::cout << "No timer queries, GPU scopes won't be timed" << std::endl;
+        return;
+    }
+
+    for (GpuFrame& frame : m_gpu_frames)
+    {
+        glGenQueries(PROFILER_GPU_SCOPES * 2, frame.queries);
+        frame.count = 0;
+    }
+    m_gpu_frame = 0;
+    m_gpu_depth = 0;
+    m_gpu_supported = true;
+    sync_gpu_clock();
+}
+
+// GL_TIMESTAMP is on the GPU's own clock; pairing a reading with the
+// performance counter lets query results be placed next to the CPU events
+void Profiler::sync_gpu_clock()
+{
+    glGetInteger64v(GL_TIMESTAMP, &m_gpu_sync_ns);
+    m_gpu_sync_counts = SDL_GetPerformanceCounter();
+    m_gpu_frames_since_sync = 0;
+}
+
+void Profiler::begin_gpu(const char* name)
+{
+    if (!m_gpu_supported || m_gpu_depth == PROFILER_GPU_SCOPES) return;
+
+    GpuFrame& frame = m_gpu_frames[m_gpu_frame];
+    int index = frame.count < PROFILER_GPU_SCOPES ? frame.count++ : -1;
+    m_gpu_stack[m_gpu_depth++] = index;
+    if (index < 0) return;
+
+    frame.names[index] = name;
+    frame.last_query = frame.queries[index * 2];
+    glQueryCounter(frame.last_query, GL_TIMESTAMP);
+}
+
+void Profiler::end_gpu()
+{
+    if (!m_gpu_supported || m_gpu_depth == 0) return;
+
+    int index = m_gpu_stack[--m_gpu_depth];
+    if (index < 0) return;
+
+    GpuFrame& frame = m_gpu_frames[m_gpu_frame];
+    frame.last_query = frame.queries[index * 2 + 1];
+    glQueryCounter(frame.last_query, GL_TIMESTAMP);
+}
+
+void Profiler::read_gpu_frame(GpuFrame& frame)
+{
+    if (frame.count == 0) return;
+
+    // Results come back in order, so the last query answers for the frame.
+    // If even that isn't in yet the frame is dropped rather than waited for.
+    GLint available = 0;
+    glGetQueryObjectiv(frame.last_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available)
+    {
+        for (int i = 0; i < frame.count; i++)
+        {
+            GLuint64 begin_ns = 0, end_ns = 0;
+            glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin_ns);
+            glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end_ns);
+
+            double begin_offset = ((double) (GLint64) begin_ns - m_gpu_sync_ns) * m_frequency / 1e9;
+            double end_offset = ((double) (GLint64) end_ns - m_gpu_sync_ns) * m_frequency / 1e9;
+            record(frame.names[i], m_gpu_sync_counts + (Sint64) begin_offset, m_gpu_sync_counts + (Sint64) end_offset, true);
+        }
+    }
+    frame.count = 0;
+}
+
+void Profiler::end_gpu_frame()
+{
+    if (!m_gpu_supported) return;
+
+    // A scope still open here is abandoned rather than carried over
+    m_gpu_depth = 0;
+    m_gpu_frame = (m_gpu_frame + 1) % PROFILER_GPU_FRAMES;
+    read_gpu_frame(m_gpu_frames[m_gpu_frame]);
+
+    if (++m_gpu_frames_since_sync >= PROFILER_GPU_RESYNC_FRAMES) sync_gpu_clock();
+}
+
+// ————— FRAME ————— //
+
+void Profiler::end_frame()
+{
+    std::vector<ThreadBuffer*> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_threads_mutex);
+        threads = m_threads;
+    }
+
+    m_frame_scopes.clear();
+    bool tracing = !m_trace_path.empty();
+
+    for (ThreadBuffer* buffer : threads)
+    {
+        unsigned int read = buffer->read.load(std::memory_order_relaxed);
+        unsigned int write = buffer->write.load(std::memory_order_acquire);
+
+        for (; read != write; read++)
+        {
+            const ProfileEvent& event = buffer->events[read % PROFILER_THREAD_EVENTS];
+            double ms = (event.end - event.start) * 1000.0 / m_frequency;
+
+            // Literals with the same text are usually, but not always, merged
+            auto total = std::find_if(m_frame_scopes.begin(), m_frame_scopes.end(), [&event](const ScopeTotal& scope) {
+                return scope.gpu == event.gpu && (scope.name == event.name || strcmp(scope.name, event.name) == 0);
+            });
+            if (total == m_frame_scopes.end()) m_frame_scopes.push_back({ event.name, event.gpu, ms, 1 });
+            else
+            {
+                total->ms += ms;
+                total->count++;
+            }
+
+            if (!tracing) continue;
+            if (m_trace.size() < PROFILER_TRACE_EVENTS) m_trace.push_back(event);
+            else m_trace_dropped++;
+        }
+        buffer->read.store(write, std::memory_order_release);
+    }
+
+    std::sort(m_frame_scopes.begin(), m_frame_scopes.end(), [](const ScopeTotal& a, const ScopeTotal& b) { return a.ms > b.ms; });
+}
+
+// ————— TRACE ————— //
+
+void write_json_string(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (; *text != '\0'; text++)
+    {
+        if (*text == '"' || *text == '\\') fputc('\\', file);
+        if ((unsigned char) *text >= ' ') fputc(*text, file);
+    }
+    fputc('"', file);
+}
+
+bool Profiler::write_trace(const char* path) const
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        std::cout << "Unable to write profile trace " << path << std::endl;
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    {
+        std::lock_guard<std::mutex> lock(m_threads_mutex);
+        for (const ThreadBuffer* buffer : m_threads)
+        {
+            fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", buffer->index);
+            write_json_string(file, buffer->name.c_str());
+            fprintf(file, "}},\n");
+
+            unsigned int dropped = buffer->dropped.load();
+            if (dropped > 0) std::cout << buffer->name << " overflowed its profile buffer, " << dropped << " events lost" << std::endl;
+        }
+    }
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", PROFILER_GPU_TRACK);
+
+    // Complete events, in microseconds from start()
+    for (const ProfileEvent& event : m_trace)
+    {
+        double start_us = ((double) event.start - (double) m_start_counts) * 1e6 / m_frequency;
+        double duration_us = (event.end - event.start) * 1e6 / m_frequency;
+
+        fprintf(file, ",\n{\"name\":");
+        write_json_string(file, event.name);
+        fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", event.gpu ? PROFILER_GPU_TRACK : event.thread, start_us, duration_us);
+    }
+
+    // Marks as instant events on the thread that made them
+    {
+        std::lock_guard<std::mutex> lock(m_marks_mutex);
+        for (const ProfileMark& mark : m_trace_marks)
+        {
+            double time_us = ((double) mark.time - (double) m_start_counts) * 1e6 / m_frequency;
+
+            fprintf(file, ",\n{\"name\":");
+            write_json_string(file, mark.name);
+            fprintf(file, ",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"detail\":", mark.thread, time_us);
+            write_json_string(file, mark.detail);
+            fprintf(file, "}}");
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    if (m_trace_dropped > 0) std::cout << "Profile trace was full, " << m_trace_dropped << " events left out" << std::endl;
+    return true;
+}
+
+const char* parse_trace_argument(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--trace") == 0) return argv[i + 1];
+    }
+    return NULL;
+}
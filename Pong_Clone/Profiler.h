@@ -0,0 +1,194 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Builds that define PROFILER_ENABLED=0 keep none of the markers below
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+const int    PROFILER_THREAD_EVENTS = 16384;      // per thread, between two end_frame() calls
+const int    PROFILER_GPU_SCOPES = 64;            // per frame
+const int    PROFILER_GPU_LATENCY = 4;            // frames before GPU timings are read back
+const int    PROFILER_GPU_FRAMES = PROFILER_GPU_LATENCY + 1;  // the frame being recorded plus those in flight
+const int    PROFILER_GPU_RESYNC_FRAMES = 120;    // how often the GPU clock is lined up with the CPU's again
+const size_t PROFILER_TRACE_EVENTS = 1 << 20;     // kept for the trace file; later ones are dropped
+const int    PROFILER_RECENT_MARKS = 64;
+const int    PROFILER_MARK_DETAIL = 96;
+
+struct ProfileEvent
+{
+    const char* name;       // a string literal; only the pointer is kept
+    Uint64 start, end;      // performance counter
+    int    thread;          // index into the profiler's threads
+    bool   gpu;
+};
+
+// Something that happened at one moment and is worth seeing next to the
+// timings: a texture arriving, a shader compiling, a map being rebuilt
+struct ProfileMark
+{
+    const char* name;       // a string literal, as for events
+    char   detail[PROFILER_MARK_DETAIL];
+    Uint64 time;
+    int    thread;
+};
+
+// Time spent in one scope over the last frame
+struct ScopeTotal
+{
+    const char* name;
+    bool   gpu;
+    double ms;
+    int    count;
+};
+
+// Records where frame time goes. PROFILE_SCOPE marks a block on whichever
+// thread runs it; each thread writes into a ring of its own, so recording
+// takes no lock. end_frame() on the main thread drains the rings, totals the
+// frame per scope and keeps the events for a Chrome trace
+// (chrome://tracing or ui.perfetto.dev).
+//
+// PROFILE_GPU_SCOPE brackets GL work with GL_TIMESTAMP queries. Results are
+// read PROFILER_GPU_LATENCY frames later, once the GPU is certainly done, so
+// nothing waits on them; GPU scopes show on a track of their own, placed on
+// the CPU timeline. Needs GL 3.3 or ARB_timer_query, and does nothing without.
+class Profiler
+{
+private:
+    struct ThreadBuffer
+    {
+        std::string  name;
+        int          index;
+        ProfileEvent events[PROFILER_THREAD_EVENTS];
+        std::atomic<unsigned int> write{0};     // moved by the owning thread only
+        std::atomic<unsigned int> read{0};      // moved by end_frame() only
+        std::atomic<unsigned int> dropped{0};
+    };
+
+    struct GpuFrame
+    {
+        GLuint      queries[PROFILER_GPU_SCOPES * 2];
+        const char* names[PROFILER_GPU_SCOPES];
+        int         count = 0;
+        GLuint      last_query = 0;             // issued last, so answered last
+    };
+
+    Uint64 m_frequency = 1;
+    Uint64 m_start_counts = 0;
+
+    mutable std::mutex m_threads_mutex;         // only taken the first time a thread records
+    std::vector<ThreadBuffer*> m_threads;
+
+    // ————— GPU ————— //
+    bool     m_gpu_supported = false;
+    GpuFrame m_gpu_frames[PROFILER_GPU_FRAMES];
+    int      m_gpu_frame = 0;
+    int      m_gpu_stack[PROFILER_GPU_SCOPES];  // open scopes, as indices into the frame
+    int      m_gpu_depth = 0;
+    int      m_gpu_frames_since_sync = 0;
+    GLint64  m_gpu_sync_ns = 0;
+    Uint64   m_gpu_sync_counts = 0;
+
+    // ————— FRAME ————— //
+    std::vector<ScopeTotal> m_frame_scopes;
+
+    // ————— MARKS ————— //
+    mutable std::mutex m_marks_mutex;           // marks are rare enough to simply lock
+    ProfileMark m_recent_marks[PROFILER_RECENT_MARKS];
+    int m_mark_count = 0;
+    std::vector<ProfileMark> m_trace_marks;
+
+    // ————— TRACE ————— //
+    std::string m_trace_path;
+    std::vector<ProfileEvent> m_trace;
+    size_t m_trace_dropped = 0;
+
+    ThreadBuffer* get_thread_buffer();
+    void sync_gpu_clock();
+    void read_gpu_frame(GpuFrame& frame);
+
+public:
+    ~Profiler();
+
+    // An empty or NULL trace path keeps no events beyond the current frame
+    void start(const char* trace_path = NULL);
+    // Writes the trace, if one was asked for
+    void stop();
+
+    void set_thread_name(const char* name);
+    // Safe from any thread
+    void record(const char* name, Uint64 start_counts, Uint64 end_counts, bool gpu = false);
+
+    // Safe from any thread; `detail` is copied
+    void mark(const char* name, const char* detail = NULL);
+    // Marks made at or after `since_counts`, oldest first
+    std::vector<ProfileMark> get_recent_marks(Uint64 since_counts) const;
+
+    // ————— GPU, on the thread with the context ————— //
+    void start_gpu();
+    void begin_gpu(const char* name);
+    void end_gpu();
+    // Once per frame, after the frame's last GPU scope
+    void end_gpu_frame();
+
+    // Once per frame on the main thread
+    void end_frame();
+    // Last frame's scopes, longest first
+    const std::vector<ScopeTotal>& get_frame_scopes() const { return m_frame_scopes; };
+
+    bool write_trace(const char* path) const;
+
+    bool   const is_gpu_supported() const { return m_gpu_supported; };
+    Uint64 const get_start_counts() const { return m_start_counts; };
+    Uint64 const get_frequency()    const { return m_frequency; };
+};
+
+extern Profiler g_profiler;
+
+class ProfileScope
+{
+private:
+    const char* m_name;
+    Uint64      m_start;
+
+public:
+    ProfileScope(const char* name) : m_name(name), m_start(SDL_GetPerformanceCounter()) {};
+    ~ProfileScope() { g_profiler.record(m_name, m_start, SDL_GetPerformanceCounter()); };
+};
+
+class GpuProfileScope
+{
+public:
+    GpuProfileScope(const char* name) { g_profiler.begin_gpu(name); };
+    ~GpuProfileScope() { g_profiler.end_gpu(); };
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpu_profile_scope_, __LINE__)(name)
+#define PROFILE_MARK(name, detail) g_profiler.mark(name, detail)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#define PROFILE_MARK(name, detail)
+#endif
+
+// Writes `text` as a quoted JSON string
+void write_json_string(FILE* file, const char* text);
+
+// Reads --trace FILE from the command line; NULL when it isn't there
+const char* parse_trace_argument(int argc, char* argv[]);
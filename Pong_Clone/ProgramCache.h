@@ -0,0 +1,21 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include <string>
+
+// On-disk cache of linked program binaries (GL 4.1 / ARB_get_program_binary).
+// Entries are keyed by both shader sources plus the driver's vendor, renderer
+// and version strings, so editing a shader or updating the driver simply
+// misses and rebuilds. A binary the driver refuses is deleted and rebuilt too.
+const char PROGRAM_CACHE_DIRECTORY[] = "shader_cache";
+
+bool program_cache_supported();
+unsigned long long program_cache_key(const std::string& vertex_source, const std::string& fragment_source);
+// Returns a linked program, or 0 when there is no usable entry for this key
+GLuint program_cache_load(unsigned long long key);
+void program_cache_save(unsigned long long key, GLuint program);
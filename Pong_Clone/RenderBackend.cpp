@@ -0,0 +1,293 @@
+#include "RenderBackend.h"
+#include "GLState.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include <iostream>
+#include <math.h>
+#include <string.h>
+
+const int MATRIX_FLOATS = 16;
+const int QUAD_FLOATS = 12;        // 6 vertices x 2
+
+// The instanced shader's unit quad; a corner's texture coordinate is the
+// corner plus a half
+const float SPRITE_CORNERS[QUAD_FLOATS] = { -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f };
+
+// ————— GL ————— //
+
+void GLRenderBackend::execute(const CommandList& list)
+{
+    PROFILE_SCOPE("GLRenderBackend::execute");
+    const float quad_vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
+    const float quad_tex_coords[] = { 0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
+    glm::mat4 view, projection;
+
+    for (const RenderCommand& command : list.get_commands())
+    {
+        const float* data = list.get_data(command.data_offset);
+
+        switch (command.type)
+        {
+        case RENDER_CLEAR:
+            glClear(GL_COLOR_BUFFER_BIT);
+            break;
+        case RENDER_CAMERA:
+            view = list.get_matrix(command.data_offset);
+            projection = list.get_matrix(command.data_offset + MATRIX_FLOATS);
+            m_program->set_view_matrix(view);
+            m_program->set_projection_matrix(projection);
+            break;
+        case RENDER_QUAD:
+            g_gl_state.use_program(m_program->get_program_id());
+            m_program->set_model_matrix(list.get_matrix(command.data_offset));
+            g_gl_state.bind_texture(command.texture_id);
+
+            glVertexAttribPointer(m_program->get_position_attribute(), 2, GL_FLOAT, false, 0, command.count == 0 ? quad_vertices : data + MATRIX_FLOATS);
+            glVertexAttribPointer(m_program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, command.count == 0 ? quad_tex_coords : data + MATRIX_FLOATS + QUAD_FLOATS);
+            g_gl_state.set_attributes(m_program->get_attribute_mask());
+
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            g_render_stats.count_client_draw(GL_TRIANGLES, 6, 4 * sizeof(float));
+            break;
+        case RENDER_SPRITES:
+            if (m_instanced_renderer != NULL) m_instanced_renderer->draw(list.get_sprites(command.data_offset), command.count, command.texture_id, view, projection, m_stream);
+            else draw_sprite_batch(list.get_sprites(command.data_offset), command.count, command.texture_id);
+            break;
+        }
+    }
+}
+
+void GLRenderBackend::draw_sprite_batch(const SpriteInstance* sprites, int count, GLuint texture_id)
+{
+    if (count == 0) return;
+
+    // Positions then texture coordinates, written straight into the stream buffer.
+    // The tint is dropped; the sprite program has no per-vertex colour.
+    size_t block = count * QUAD_FLOATS * sizeof(float);
+    size_t offset;
+    float* vertex = (float*) m_stream->reserve(block * 2, offset);
+    float* texture_coordinate = vertex + count * QUAD_FLOATS;
+
+    // Sprites next to each other mostly share a spin and a size (every ball
+    // does), so the rotated corners are only worked out again when they change
+    float corners[QUAD_FLOATS];
+    float rotation = 0.0f, scale_x = 0.0f, scale_y = 0.0f;
+    bool have_corners = false;
+
+    for (int i = 0; i < count; i++)
+    {
+        const SpriteInstance& sprite = sprites[i];
+        if (!have_corners || sprite.rotation != rotation || sprite.scale_x != scale_x || sprite.scale_y != scale_y)
+        {
+            rotation = sprite.rotation;
+            scale_x = sprite.scale_x;
+            scale_y = sprite.scale_y;
+            have_corners = true;
+
+            float cos_angle = cosf(rotation);
+            float sin_angle = sinf(rotation);
+            for (int j = 0; j < QUAD_FLOATS; j += 2)
+            {
+                float x = SPRITE_CORNERS[j] * scale_x, y = SPRITE_CORNERS[j + 1] * scale_y;
+                corners[j] = x * cos_angle - y * sin_angle;
+                corners[j + 1] = x * sin_angle + y * cos_angle;
+            }
+        }
+
+        for (int j = 0; j < QUAD_FLOATS; j += 2)
+        {
+            vertex[j] = sprite.x + corners[j];
+            vertex[j + 1] = sprite.y + corners[j + 1];
+            texture_coordinate[j] = sprite.u + (SPRITE_CORNERS[j] + 0.5f) * sprite.uv_width;
+            texture_coordinate[j + 1] = sprite.v + (SPRITE_CORNERS[j + 1] + 0.5f) * sprite.uv_height;
+        }
+        vertex += QUAD_FLOATS;
+        texture_coordinate += QUAD_FLOATS;
+    }
+    m_stream->commit();
+
+    m_program->set_model_matrix(glm::mat4(1.0f));
+    g_gl_state.bind_texture(texture_id);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_stream->get_buffer());
+    glVertexAttribPointer(m_program->get_position_attribute(), 2, GL_FLOAT, false, 0, (const void*) offset);
+    glVertexAttribPointer(m_program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, (const void*) (offset + block));
+    g_gl_state.set_attributes(m_program->get_attribute_mask());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glDrawArrays(GL_TRIANGLES, 0, count * 6);
+    g_render_stats.count_draw(GL_TRIANGLES, count * 6);
+}
+
+// ————— COUNTS ————— //
+
+void CommandStreamCounts::add(const CommandList& list)
+{
+    frames++;
+    commands += (int) list.get_commands().size();
+    for (const RenderCommand& command : list.get_commands())
+    {
+        if (command.type == RENDER_QUAD) quads++;
+        if (command.type == RENDER_SPRITES) sprites += command.count;
+    }
+    bytes += list.get_commands().size() * sizeof(RenderCommand) + list.get_data_size() * sizeof(float);
+}
+
+void CommandStreamCounts::print(const char* what) const
+{
+    if (frames == 0) return;
+    std::cout << what << ": " << frames << " frames | per frame " << (float) commands / frames << " commands, "
+        << (float) quads / frames << " quads, " << (float) sprites / frames << " sprites, "
+        << bytes / frames / 1024.0f << " KiB" << std::endl;
+}
+
+// ————— RECORDING ————— //
+
+bool RecordingRenderBackend::start(const char* path)
+{
+    stop();
+    m_file = fopen(path, "wb");
+    if (m_file == NULL)
+    {
+        std::cout << "Unable to write command stream " << path << std::endl;
+        return false;
+    }
+
+    // The frame count is patched in once the stream is finished
+    CommandStreamHeader header = { COMMAND_STREAM_MAGIC, COMMAND_STREAM_VERSION, 0 };
+    fwrite(&header, sizeof(header), 1, m_file);
+    m_path = path;
+    m_counts = CommandStreamCounts();
+    return true;
+}
+
+void RecordingRenderBackend::stop()
+{
+    if (m_file == NULL) return;
+
+    CommandStreamHeader header = { COMMAND_STREAM_MAGIC, COMMAND_STREAM_VERSION, (unsigned int) m_counts.frames };
+    fseek(m_file, 0, SEEK_SET);
+    bool written = fwrite(&header, sizeof(header), 1, m_file) == 1;
+    written = fclose(m_file) == 0 && written;
+    m_file = NULL;
+
+    if (!written) std::cout << "Unable to write command stream " << m_path << std::endl;
+    else std::cout << "Recorded " << m_counts.frames << " frames of render commands to " << m_path << std::endl;
+}
+
+void RecordingRenderBackend::execute(const CommandList& list)
+{
+    if (m_file != NULL)
+    {
+        PROFILE_SCOPE("RecordingRenderBackend::execute");
+        const std::vector<RenderCommand>& commands = list.get_commands();
+        CommandStreamFrame frame = { (unsigned int) commands.size(), (unsigned int) list.get_data_size() };
+
+        bool written = fwrite(&frame, sizeof(frame), 1, m_file) == 1;
+        if (written && frame.command_count > 0) written = fwrite(commands.data(), sizeof(RenderCommand), frame.command_count, m_file) == frame.command_count;
+        if (written && frame.data_count > 0) written = fwrite(list.get_data(0), sizeof(float), frame.data_count, m_file) == frame.data_count;
+
+        if (written)
+        {
+            m_counts.add(list);
+        }
+        else
+        {
+            // Out of disk most likely; what's there so far is still readable
+            std::cout << "Unable to write command stream " << m_path << ", recording stopped" << std::endl;
+            stop();
+        }
+    }
+
+    if (m_next != NULL) m_next->execute(list);
+}
+
+void RecordingRenderBackend::print_summary() const
+{
+    m_counts.print("Command stream");
+    if (m_next != NULL) m_next->print_summary();
+}
+
+// ————— PLAYBACK ————— //
+
+// How many floats a command reads from the list's data
+static long long get_command_floats(const RenderCommand& command)
+{
+    switch (command.type)
+    {
+    case RENDER_CAMERA:  return MATRIX_FLOATS * 2;
+    case RENDER_QUAD:    return command.count == 0 ? MATRIX_FLOATS : MATRIX_FLOATS + QUAD_FLOATS * 2;
+    case RENDER_SPRITES: return command.count * (long long) SPRITE_INSTANCE_FLOATS;
+    default:             return 0;
+    }
+}
+
+bool CommandStreamReader::open(const char* path)
+{
+    close();
+    m_file = fopen(path, "rb");
+    if (m_file == NULL)
+    {
+        std::cout << "Unable to open command stream " << path << std::endl;
+        return false;
+    }
+
+    if (fread(&m_header, sizeof(m_header), 1, m_file) != 1
+        || m_header.magic != COMMAND_STREAM_MAGIC || m_header.version != COMMAND_STREAM_VERSION)
+    {
+        std::cout << path << " isn't a command stream this build can read" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void CommandStreamReader::close()
+{
+    if (m_file != NULL) fclose(m_file);
+    m_file = NULL;
+    m_header = CommandStreamHeader();
+    m_frame = 0;
+}
+
+bool CommandStreamReader::next(CommandList* list)
+{
+    // Read to the end rather than to frame_count, so a stream from a run that
+    // never got to stop() still plays
+    if (m_file == NULL) return false;
+
+    CommandStreamFrame frame;
+    if (fread(&frame, sizeof(frame), 1, m_file) != 1) return false;
+    m_commands.resize(frame.command_count);
+    m_data.resize(frame.data_count);
+
+    bool valid = (frame.command_count == 0 || fread(m_commands.data(), sizeof(RenderCommand), frame.command_count, m_file) == frame.command_count)
+        && (frame.data_count == 0 || fread(m_data.data(), sizeof(float), frame.data_count, m_file) == frame.data_count);
+
+    // A command reaching past its frame's data would read out of bounds later
+    for (const RenderCommand& command : m_commands)
+    {
+        if (command.type < RENDER_CLEAR || command.type > RENDER_SPRITES || command.count < 0 || command.data_offset < 0
+            || command.data_offset + get_command_floats(command) > frame.data_count) valid = false;
+    }
+    if (!valid)
+    {
+        std::cout << "Command stream is damaged or cut short at frame " << m_frame << std::endl;
+        close();
+        return false;
+    }
+
+    list->assign(m_commands, m_data);
+    m_frame++;
+    return true;
+}
+
+void parse_render_backend_arguments(int argc, char* argv[], RendererType* renderer, const char** record_path, const char** replay_path)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--renderer") == 0) *renderer = strcmp(argv[i + 1], "null") == 0 ? RENDERER_NULL : RENDERER_GL;
+        if (strcmp(argv[i], "--record-commands") == 0) *record_path = argv[i + 1];
+        if (strcmp(argv[i], "--replay-commands") == 0) *replay_path = argv[i + 1];
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <stdio.h>
+#include "CommandList.h"
+#include "InstancedRenderer.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+
+const unsigned int COMMAND_STREAM_MAGIC = 0x444D4350;     // "PCMD"
+const unsigned int COMMAND_STREAM_VERSION = 1;
+
+enum RendererType { RENDERER_GL, RENDERER_NULL };
+
+// What a recorded frame is executed on. The game records each frame into a
+// CommandList once; the backend decides what happens to it. GL draws it, the
+// null backend only counts it, so the CPU side of a frame can be measured
+// without a GPU, and the recording backend writes it to a file.
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() {};
+
+    virtual void execute(const CommandList& list) = 0;
+    virtual void print_summary() const {};
+};
+
+// Draws quads through the sprite program and sprite batches through the
+// instanced renderer. Without GL 3.3 (no instanced renderer) a batch is
+// expanded into the stream buffer instead and still goes out in one draw.
+// Needs the context current on the calling thread.
+class GLRenderBackend : public RenderBackend
+{
+private:
+    ShaderProgram*     m_program;
+    InstancedRenderer* m_instanced_renderer;    // NULL without instancing
+    StreamBuffer*      m_stream;
+
+    void draw_sprite_batch(const SpriteInstance* sprites, int count, GLuint texture_id);
+
+public:
+    GLRenderBackend(ShaderProgram* program, InstancedRenderer* instanced_renderer, StreamBuffer* stream)
+        : m_program(program), m_instanced_renderer(instanced_renderer), m_stream(stream) {};
+
+    void execute(const CommandList& list) override;
+};
+
+// What the null and recording backends saw, summed over every frame
+struct CommandStreamCounts
+{
+    int    frames = 0;
+    int    commands = 0;
+    int    quads = 0;
+    int    sprites = 0;
+    size_t bytes = 0;           // the lists' command and float data
+
+    void add(const CommandList& list);
+    void print(const char* what) const;
+};
+
+// Drops every frame but keeps the counts
+class NullRenderBackend : public RenderBackend
+{
+private:
+    CommandStreamCounts m_counts;
+
+public:
+    void execute(const CommandList& list) override { m_counts.add(list); };
+    void print_summary() const override { m_counts.print("Null renderer"); };
+
+    const CommandStreamCounts& get_counts() const { return m_counts; };
+};
+
+// A command stream file is a header followed by one block per frame: the
+// command and float counts, then the RenderCommands and the floats as the
+// list held them. Texture names are written as they were, so a playback
+// has to build the same atlas first.
+struct CommandStreamHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int frame_count;   // filled in by stop(); 0 if the run never got there
+};
+
+struct CommandStreamFrame
+{
+    unsigned int command_count;
+    unsigned int data_count;
+};
+
+// Writes every frame to a file, then hands it on to `next` (if any), so the
+// game can keep drawing while it records
+class RecordingRenderBackend : public RenderBackend
+{
+private:
+    RenderBackend* m_next;
+    FILE*          m_file = NULL;
+    const char*    m_path = NULL;
+    CommandStreamCounts m_counts;
+
+public:
+    RecordingRenderBackend(RenderBackend* next = NULL) : m_next(next) {};
+    ~RecordingRenderBackend() { stop(); };
+
+    bool start(const char* path);
+    // Finishes the header and closes the file
+    void stop();
+
+    void execute(const CommandList& list) override;
+    void print_summary() const override;
+
+    bool const is_recording() const { return m_file != NULL; };
+};
+
+// Reads a command stream back a frame at a time
+class CommandStreamReader
+{
+private:
+    FILE* m_file = NULL;
+    CommandStreamHeader m_header = {};
+    unsigned int m_frame = 0;
+    std::vector<RenderCommand> m_commands;
+    std::vector<float> m_data;
+
+public:
+    ~CommandStreamReader() { close(); };
+
+    bool open(const char* path);
+    void close();
+    // Fills `list` with the next frame; false at the end of the stream
+    bool next(CommandList* list);
+
+    unsigned int const get_frame_count() const { return m_header.frame_count; };
+    unsigned int const get_frame()       const { return m_frame; };
+};
+
+// Reads --renderer gl|null, --record-commands FILE and --replay-commands FILE
+// from the command line
+void parse_render_backend_arguments(int argc, char* argv[], RendererType* renderer, const char** record_path, const char** replay_path);
@@ -0,0 +1,199 @@
+#include "RenderStats.h"
+#include "GLState.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <ctype.h>
+#include <iostream>
+#include <string.h>
+
+RenderStats g_render_stats;
+
+const int FONT_WIDTH = 5;
+const int FONT_HEIGHT = 7;
+const int CELL_WIDTH = FONT_WIDTH + 1;
+const int CELL_HEIGHT = FONT_HEIGHT + 2;
+const int OVERLAY_MARGIN = 3;
+
+// One byte per row, top row first, the leftmost pixel in bit 4
+const char FONT_CHARACTERS[] = " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.:/-%";
+const unsigned char FONT_ROWS[][FONT_HEIGHT] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // space
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },  // 0
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },  // 9
+    { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 },  // A
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },
+    { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },
+    { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },
+    { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },
+    { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 },
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },  // Z
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },  // .
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },  // :
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },  // /
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },  // -
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },  // %
+};
+
+// ————— COUNTERS ————— //
+
+void RenderStats::count_draw(GLenum mode, int vertex_count, int instance_count)
+{
+    int triangles = 0;
+    if (mode == GL_TRIANGLES) triangles = vertex_count / 3;
+    else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && vertex_count > 2) triangles = vertex_count - 2;
+
+    m_current.draw_calls++;
+    m_current.triangles += triangles * instance_count;
+}
+
+void RenderStats::count_client_draw(GLenum mode, int vertex_count, size_t bytes_per_vertex)
+{
+    count_draw(mode, vertex_count);
+    m_current.client_vertex_bytes += vertex_count * bytes_per_vertex;
+}
+
+void RenderStats::end_frame()
+{
+    if (m_csv != NULL)
+    {
+        fprintf(m_csv, "%d,%d,%d,%d,%d,%d,%zu\n", m_frame, m_current.draw_calls, m_current.triangles, m_current.texture_binds,
+            m_current.program_switches, m_current.uniform_uploads, m_current.client_vertex_bytes);
+    }
+
+    m_last = m_current;
+    m_current = RenderFrameStats();
+    m_frame++;
+}
+
+bool RenderStats::open_csv(const char* path)
+{
+    close_csv();
+    m_csv = fopen(path, "w");
+    if (m_csv == NULL)
+    {
+        std::cout << "Unable to write render stats to " << path << std::endl;
+        return false;
+    }
+
+    fprintf(m_csv, "frame,draw_calls,triangles,texture_binds,program_switches,uniform_uploads,client_vertex_bytes\n");
+    return true;
+}
+
+void RenderStats::close_csv()
+{
+    if (m_csv == NULL) return;
+    fclose(m_csv);
+    m_csv = NULL;
+}
+
+// ————— OVERLAY ————— //
+
+void RenderStatsOverlay::create()
+{
+    m_width = RENDER_STATS_OVERLAY_COLUMNS * CELL_WIDTH + OVERLAY_MARGIN * 2;
+    m_height = RENDER_STATS_OVERLAY_LINES * CELL_HEIGHT + OVERLAY_MARGIN * 2;
+    m_pixels.assign((size_t) m_width * m_height * 4, 0);
+
+    glGenTextures(1, &m_texture_id);
+    g_gl_state.bind_texture(m_texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void RenderStatsOverlay::draw_text(int column, int line, const char* text)
+{
+    for (; *text != '\0' && column < RENDER_STATS_OVERLAY_COLUMNS; text++, column++)
+    {
+        const char* found = strchr(FONT_CHARACTERS, toupper((unsigned char) *text));
+        const unsigned char* rows = FONT_ROWS[found != NULL ? found - FONT_CHARACTERS : 0];
+
+        int left = OVERLAY_MARGIN + column * CELL_WIDTH;
+        int top = OVERLAY_MARGIN + line * CELL_HEIGHT;
+        for (int y = 0; y < FONT_HEIGHT; y++)
+        {
+            for (int x = 0; x < FONT_WIDTH; x++)
+            {
+                if (!(rows[y] & (0x10 >> x))) continue;
+                unsigned char* pixel = &m_pixels[((size_t) (top + y) * m_width + left + x) * 4];
+                pixel[0] = pixel[1] = pixel[2] = pixel[3] = 255;
+            }
+        }
+    }
+}
+
+void RenderStatsOverlay::update(const RenderFrameStats& stats)
+{
+    if (m_texture_id == 0 || !m_visible) return;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (m_refresh_counts != 0 && now - m_refresh_counts < RENDER_STATS_OVERLAY_REFRESH_SECONDS * SDL_GetPerformanceFrequency()) return;
+    m_refresh_counts = now;
+
+    // Translucent black behind the text
+    for (size_t i = 0; i < m_pixels.size(); i += 4)
+    {
+        m_pixels[i] = m_pixels[i + 1] = m_pixels[i + 2] = 0;
+        m_pixels[i + 3] = 160;
+    }
+
+    char line[RENDER_STATS_OVERLAY_COLUMNS + 1];
+    snprintf(line, sizeof(line), "DRAW CALLS %9d", stats.draw_calls);
+    draw_text(0, 0, line);
+    snprintf(line, sizeof(line), "TRIANGLES %10d", stats.triangles);
+    draw_text(0, 1, line);
+    snprintf(line, sizeof(line), "TEXTURE BINDS %6d", stats.texture_binds);
+    draw_text(0, 2, line);
+    snprintf(line, sizeof(line), "PROGRAMS %11d", stats.program_switches);
+    draw_text(0, 3, line);
+    snprintf(line, sizeof(line), "UNIFORMS %11d", stats.uniform_uploads);
+    draw_text(0, 4, line);
+    snprintf(line, sizeof(line), "CLIENT KB %10.1f", stats.client_vertex_bytes / 1024.0);
+    draw_text(0, 5, line);
+
+    g_gl_state.bind_texture(m_texture_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, m_pixels.data());
+}
+
+glm::mat4 RenderStatsOverlay::get_model_matrix(float left, float top, float units_per_texel) const
+{
+    // The sprite quad is a unit square around the origin
+    float width = m_width * units_per_texel, height = m_height * units_per_texel;
+    glm::mat4 model_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(left + width / 2.0f, top - height / 2.0f, 0.0f));
+    return glm::scale(model_matrix, glm::vec3(width, height, 1.0f));
+}
+
+void parse_render_stats_arguments(int argc, char* argv[], const char** csv_path, bool* overlay)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--render-stats") == 0 && i + 1 < argc) *csv_path = argv[++i];
+        else if (strcmp(argv[i], "--stats-overlay") == 0) *overlay = true;
+    }
+}
@@ -0,0 +1,148 @@
+#include "RollbackSession.h"
+#include <chrono>
+#include <string.h>
+
+// Packet layout: 'P' 'R', newest frame (int), count (byte), then `count` inputs
+// oldest first, ending at the newest frame
+const int PACKET_HEADER_SIZE = 2 + sizeof(int) + 1;
+const int PACKET_MAX_SIZE = PACKET_HEADER_SIZE + ROLLBACK_INPUT_REDUNDANCY;
+
+RollbackSession::RollbackSession(UdpSocket* socket, UdpAddress peer, int local_player, int input_delay, float frame_time, int ball_count)
+{
+    m_socket = socket;
+    m_peer = peer;
+    m_local_player = local_player;
+    m_input_delay = input_delay;
+    m_frame_time = frame_time;
+
+    pong_reset(m_state, ball_count);
+
+    for (int i = 0; i < ROLLBACK_INPUT_BUFFER; i++)
+    {
+        m_local_inputs[i] = 0;
+        m_remote_inputs[i] = 0;
+        m_remote_frames[i] = -1;
+    }
+}
+
+void RollbackSession::simulate_frame()
+{
+    int frame = m_state.frame;
+    int slot = frame % ROLLBACK_INPUT_BUFFER;
+
+    m_snapshots[frame % ROLLBACK_WINDOW] = m_state;
+
+    // No real input yet: guess the peer is still holding whatever they last pressed,
+    // and remember the guess so it can be checked when the real one shows up
+    if (m_remote_frames[slot] != frame)
+    {
+        m_remote_inputs[slot] = m_confirmed_frame >= 0 ? m_remote_inputs[m_confirmed_frame % ROLLBACK_INPUT_BUFFER] : 0;
+    }
+
+    PongInput local_input = m_local_inputs[slot];
+    PongInput remote_input = m_remote_inputs[slot];
+
+    if (m_local_player == 0) pong_simulate(m_state, local_input, remote_input, m_frame_time);
+    else pong_simulate(m_state, remote_input, local_input, m_frame_time);
+}
+
+void RollbackSession::send_inputs(int newest_frame)
+{
+    if (newest_frame < 0) return;
+
+    int count = newest_frame + 1 < ROLLBACK_INPUT_REDUNDANCY ? newest_frame + 1 : ROLLBACK_INPUT_REDUNDANCY;
+
+    unsigned char packet[PACKET_MAX_SIZE];
+    packet[0] = 'P';
+    packet[1] = 'R';
+    memcpy(packet + 2, &newest_frame, sizeof(int));
+    packet[2 + sizeof(int)] = (unsigned char) count;
+
+    for (int i = 0; i < count; i++)
+    {
+        int frame = newest_frame - count + 1 + i;
+        packet[PACKET_HEADER_SIZE + i] = m_local_inputs[frame % ROLLBACK_INPUT_BUFFER];
+    }
+
+    m_socket->send(m_peer, packet, PACKET_HEADER_SIZE + count);
+}
+
+void RollbackSession::poll()
+{
+    unsigned char packet[PACKET_MAX_SIZE];
+    UdpAddress from;
+    int size;
+
+    while ((size = m_socket->receive(&from, packet, sizeof(packet))) > 0)
+    {
+        if (!(from == m_peer) || size < PACKET_HEADER_SIZE || packet[0] != 'P' || packet[1] != 'R') continue;
+
+        int newest_frame;
+        memcpy(&newest_frame, packet + 2, sizeof(int));
+        int count = packet[2 + sizeof(int)];
+        if (count > ROLLBACK_INPUT_REDUNDANCY || size < PACKET_HEADER_SIZE + count) continue;
+
+        for (int i = 0; i < count; i++)
+        {
+            int frame = newest_frame - count + 1 + i;
+
+            // Already known, or so far ahead it would overwrite a slot we still need
+            if (frame <= m_confirmed_frame || frame >= m_confirmed_frame + ROLLBACK_INPUT_BUFFER) continue;
+
+            int slot = frame % ROLLBACK_INPUT_BUFFER;
+            if (m_remote_frames[slot] == frame) continue;
+
+            PongInput input = packet[PACKET_HEADER_SIZE + i];
+
+            // This frame was already simulated on a guess; if the guess was wrong, go back
+            if (frame < m_state.frame && m_remote_inputs[slot] != input)
+            {
+                if (m_rollback_frame < 0 || frame < m_rollback_frame) m_rollback_frame = frame;
+            }
+
+            m_remote_inputs[slot] = input;
+            m_remote_frames[slot] = frame;
+        }
+
+        while (m_remote_frames[(m_confirmed_frame + 1) % ROLLBACK_INPUT_BUFFER] == m_confirmed_frame + 1)
+        {
+            m_confirmed_frame++;
+        }
+    }
+}
+
+bool RollbackSession::advance(PongInput local_input)
+{
+    poll();
+
+    if (m_rollback_frame >= 0)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        int current_frame = m_state.frame;
+        m_state = m_snapshots[m_rollback_frame % ROLLBACK_WINDOW];
+        while (m_state.frame < current_frame) simulate_frame();
+
+        m_last_resimulate_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_last_rollback_frames = current_frame - m_rollback_frame;
+        if (m_last_resimulate_ms > m_max_resimulate_ms) m_max_resimulate_ms = m_last_resimulate_ms;
+        if (m_last_rollback_frames > m_max_rollback_frames) m_max_rollback_frames = m_last_rollback_frames;
+        m_rollbacks++;
+        m_rollback_frame = -1;
+    }
+
+    // Running further ahead would overwrite the snapshot we may need to roll back to
+    int frame = m_state.frame;
+    if (frame - m_confirmed_frame >= ROLLBACK_WINDOW)
+    {
+        m_stalls++;
+        send_inputs(frame + m_input_delay - 1);
+        return false;
+    }
+
+    m_local_inputs[(frame + m_input_delay) % ROLLBACK_INPUT_BUFFER] = local_input;
+    send_inputs(frame + m_input_delay);
+
+    simulate_frame();
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "PongState.h"
+#include "UdpSocket.h"
+
+// How many past frames can be rolled back. Each one costs a PongState copy.
+const int ROLLBACK_WINDOW = 16;
+// Ring size for inputs; the peer can run up to ROLLBACK_WINDOW frames ahead of us
+const int ROLLBACK_INPUT_BUFFER = 64;
+// Every packet repeats this many of the latest local inputs, so a lost packet is
+// covered by the next one and nothing ever has to be resent
+const int ROLLBACK_INPUT_REDUNDANCY = 8;
+
+// Two-player netplay over UDP with input delay, prediction and rollback.
+// Each frame the local input is scheduled `input_delay` frames ahead and sent to
+// the peer. Missing remote input is predicted by repeating the last one we know.
+// When the real input turns out different, the state is restored from the
+// snapshot of that frame and every frame since is simulated again.
+class RollbackSession
+{
+private:
+    UdpSocket* m_socket;
+    UdpAddress m_peer;
+    int   m_local_player;       // 0 plays the left paddle, 1 the right
+    int   m_input_delay;
+    float m_frame_time;
+
+    PongState m_state;
+    PongState m_snapshots[ROLLBACK_WINDOW];     // state at the start of frame f lives in f % ROLLBACK_WINDOW
+
+    PongInput m_local_inputs[ROLLBACK_INPUT_BUFFER];
+    PongInput m_remote_inputs[ROLLBACK_INPUT_BUFFER];   // confirmed, or whatever we predicted
+    int       m_remote_frames[ROLLBACK_INPUT_BUFFER];   // which frame each confirmed slot belongs to, -1 if unconfirmed
+    int       m_confirmed_frame = -1;                   // every remote input up to here is known
+    int       m_rollback_frame  = -1;                   // earliest mispredicted frame, -1 if none
+
+    // ————— STATS ————— //
+    int    m_rollbacks = 0;
+    int    m_stalls = 0;
+    int    m_last_rollback_frames = 0;
+    int    m_max_rollback_frames = 0;
+    double m_last_resimulate_ms = 0.0;
+    double m_max_resimulate_ms = 0.0;
+
+    void simulate_frame();
+    void send_inputs(int newest_frame);
+    void poll();
+
+public:
+    RollbackSession(UdpSocket* socket, UdpAddress peer, int local_player, int input_delay, float frame_time, int ball_count);
+
+    // Schedules this frame's local input, then runs one frame (plus any rollback).
+    // Returns false when the peer is too far behind and the frame had to wait.
+    bool advance(PongInput local_input);
+
+    // ————— GETTERS ————— //
+    const PongState& get_state()            const { return m_state; };
+    int    const get_frame()                const { return m_state.frame; };
+    int    const get_confirmed_frame()      const { return m_confirmed_frame; };
+    int    const get_rollbacks()            const { return m_rollbacks; };
+    int    const get_stalls()               const { return m_stalls; };
+    int    const get_last_rollback_frames() const { return m_last_rollback_frames; };
+    int    const get_max_rollback_frames()  const { return m_max_rollback_frames; };
+    double const get_last_resimulate_ms()   const { return m_last_resimulate_ms; };
+    double const get_max_resimulate_ms()    const { return m_max_resimulate_ms; };
+};
@@ -10,6 +10,8 @@
 #include <fstream>
 #include <sstream>
 #include "glm/mat4x4.hpp"
+#include "GLState.h"
+#include "ProgramCache.h"
 
 class ShaderProgram
 {
@@ -17,7 +19,8 @@ private:
     void cleanup();
 
     GLuint load_shader_from_string(const std::string& shader_contents, GLenum shader_type);
-    GLuint load_shader_from_file(const std::string& shader_file, GLenum shader_type);
+    std::string read_shader_file(const std::string& shader_file);
+    void print_shader_log(GLuint shader);
 
     GLuint m_program_id;
 
@@ -32,9 +35,26 @@ private:
     GLuint m_vertex_shader;
     GLuint m_fragment_shader;
 
+    unsigned long long m_cache_key;
+    bool m_from_cache = false;
+
+    // Last values sent to each uniform, so repeated sets can be skipped
+    glm::mat4 m_projection_matrix_value;
+    glm::mat4 m_model_matrix_value;
+    glm::mat4 m_view_matrix_value;
+    float     m_colour_value[4];
+    bool      m_projection_matrix_valid = false;
+    bool      m_model_matrix_valid = false;
+    bool      m_view_matrix_valid = false;
+    bool      m_colour_valid = false;
+
 public:
 
     void load(const char* vertex_shader_file, const char* fragment_shader_file);
+    // Split load: start several programs, do other work while the driver
+    // compiles them (in parallel with KHR_parallel_shader_compile), then finish
+    void start_load(const char* vertex_shader_file, const char* fragment_shader_file);
+    void finish_load();
 
     void set_model_matrix(const glm::mat4& matrix);
     void set_projection_matrix(const glm::mat4& matrix);
@@ -44,6 +64,7 @@ public:
     GLuint const get_program_id()               const { return m_program_id; };
     GLuint const get_position_attribute()       const { return m_position_attribute; };
     GLuint const get_tex_coordinate_attribute() const { return m_tex_coord_attribute; };
+    unsigned int const get_attribute_mask()     const { return attribute_bit(m_position_attribute) | attribute_bit(m_tex_coord_attribute); };
 
     void set_program_id(GLuint program_id) { m_program_id = program_id; };
 };
\ No newline at end of file
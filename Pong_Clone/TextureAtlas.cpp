@@ -0,0 +1,245 @@
+#include "TextureAtlas.h"
+#include "stb_image.h"
+#include "Profiler.h"
+#include "GLState.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <string.h>
+
+struct PackRect
+{
+    int x, y, width, height;
+};
+
+// One page's free space as the maximal free rectangles (which may overlap)
+class MaxRectsPage
+{
+private:
+    std::vector<PackRect> m_free;
+
+    void split(const PackRect& free, const PackRect& used)
+    {
+        if (used.x < free.x + free.width && used.x + used.width > free.x)
+        {
+            if (used.y > free.y && used.y < free.y + free.height)
+                m_free.push_back({ free.x, free.y, free.width, used.y - free.y });
+            if (used.y + used.height < free.y + free.height)
+                m_free.push_back({ free.x, used.y + used.height, free.width, free.y + free.height - (used.y + used.height) });
+        }
+        if (used.y < free.y + free.height && used.y + used.height > free.y)
+        {
+            if (used.x > free.x && used.x < free.x + free.width)
+                m_free.push_back({ free.x, free.y, used.x - free.x, free.height });
+            if (used.x + used.width < free.x + free.width)
+                m_free.push_back({ used.x + used.width, free.y, free.x + free.width - (used.x + used.width), free.height });
+        }
+    }
+
+    static bool contains(const PackRect& outer, const PackRect& inner)
+    {
+        return inner.x >= outer.x && inner.y >= outer.y
+            && inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+    }
+
+public:
+    MaxRectsPage(int width, int height) { m_free.push_back({ 0, 0, width, height }); };
+
+    bool insert(int width, int height, PackRect& placed)
+    {
+        int best = -1, best_short = 1 << 30, best_long = 1 << 30;
+        for (size_t i = 0; i < m_free.size(); i++)
+        {
+            const PackRect& free = m_free[i];
+            if (free.width < width || free.height < height) continue;
+
+            int short_side = std::min(free.width - width, free.height - height);
+            int long_side = std::max(free.width - width, free.height - height);
+            if (short_side < best_short || (short_side == best_short && long_side < best_long))
+            {
+                best = (int) i;
+                best_short = short_side;
+                best_long = long_side;
+            }
+        }
+        if (best == -1) return false;
+
+        placed = { m_free[best].x, m_free[best].y, width, height };
+
+        // Every free rectangle the new one overlaps is replaced by what's left of it
+        size_t count = m_free.size();
+        for (size_t i = 0; i < count; )
+        {
+            const PackRect free = m_free[i];
+            bool overlaps = placed.x < free.x + free.width && placed.x + placed.width > free.x
+                && placed.y < free.y + free.height && placed.y + placed.height > free.y;
+            if (!overlaps) { i++; continue; }
+
+            split(free, placed);
+            m_free[i] = m_free.back();
+            m_free.pop_back();
+            if (m_free.size() < count) count--;
+        }
+
+        // Drop rectangles that another one already covers
+        for (size_t i = 0; i < m_free.size(); i++)
+        {
+            for (size_t j = i + 1; j < m_free.size(); j++)
+            {
+                if (contains(m_free[j], m_free[i]))
+                {
+                    m_free.erase(m_free.begin() + i);
+                    i--;
+                    break;
+                }
+                if (contains(m_free[i], m_free[j]))
+                {
+                    m_free.erase(m_free.begin() + j);
+                    j--;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+int TextureAtlas::add(const char* filepath)
+{
+    Entry entry;
+    entry.filepath = filepath;
+    m_entries.push_back(entry);
+    m_regions.push_back(AtlasRegion());
+    return (int) m_entries.size() - 1;
+}
+
+void TextureAtlas::decode()
+{
+    std::atomic<int> next(0);
+    int threads = std::max(1, std::min((int) m_entries.size(), SDL_GetCPUCount()));
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; t++)
+    {
+        workers.push_back(std::thread([this, &next]() {
+            g_profiler.set_thread_name("Atlas decoder");
+            for (int i = next++; i < (int) m_entries.size(); i = next++)
+            {
+                PROFILE_SCOPE("TextureAtlas::decode");
+                Entry& entry = m_entries[i];
+                int number_of_components;
+                entry.pixels = stbi_load(entry.filepath.c_str(), &entry.width, &entry.height, &number_of_components, STBI_rgb_alpha);
+            }
+        }));
+    }
+    for (std::thread& worker : workers) worker.join();
+}
+
+void TextureAtlas::pack(std::vector<int>& page_widths, std::vector<int>& page_heights)
+{
+    // Largest first packs tightest
+    std::vector<int> order;
+    for (int i = 0; i < (int) m_entries.size(); i++)
+    {
+        if (m_entries[i].pixels != NULL) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return std::max(m_entries[a].width, m_entries[a].height) > std::max(m_entries[b].width, m_entries[b].height);
+    });
+
+    std::vector<MaxRectsPage> pages;
+    for (int index : order)
+    {
+        Entry& entry = m_entries[index];
+        int width = entry.width + m_padding * 2, height = entry.height + m_padding * 2;
+
+        PackRect placed;
+        int page = 0;
+        while (page < (int) pages.size() && !pages[page].insert(width, height, placed)) page++;
+
+        if (page == (int) pages.size())
+        {
+            // A sprite bigger than a page gets a page of its own size
+            pages.push_back(MaxRectsPage(std::max(m_page_size, width), std::max(m_page_size, height)));
+            page_widths.push_back(0);
+            page_heights.push_back(0);
+            pages.back().insert(width, height, placed);
+        }
+
+        entry.page = page;
+        entry.x = placed.x;
+        entry.y = placed.y;
+
+        // Pages are trimmed to what is used
+        page_widths[page] = std::max(page_widths[page], placed.x + width);
+        page_heights[page] = std::max(page_heights[page], placed.y + height);
+    }
+}
+
+void TextureAtlas::upload(int page, int width, int height, GLint filter)
+{
+    PROFILE_SCOPE("TextureAtlas::upload");
+    std::vector<unsigned char> pixels((size_t) width * height * 4, 0);
+
+    for (const Entry& entry : m_entries)
+    {
+        if (entry.pixels == NULL || entry.page != page) continue;
+
+        // Copy the sprite into the middle of its cell and stretch its edge rows
+        // and columns out over the padding, so filtering never reaches a neighbour
+        int cell_width = entry.width + m_padding * 2, cell_height = entry.height + m_padding * 2;
+        for (int y = 0; y < cell_height; y++)
+        {
+            int source_y = std::min(std::max(y - m_padding, 0), entry.height - 1);
+            for (int x = 0; x < cell_width; x++)
+            {
+                int source_x = std::min(std::max(x - m_padding, 0), entry.width - 1);
+                memcpy(&pixels[((size_t) (entry.y + y) * width + entry.x + x) * 4], &entry.pixels[((size_t) source_y * entry.width + source_x) * 4], 4);
+            }
+        }
+    }
+
+    g_gl_state.bind_texture(m_pages[page]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void TextureAtlas::build(GLint filter)
+{
+    PROFILE_SCOPE("TextureAtlas::build");
+    PROFILE_MARK("texture atlas build", NULL);
+    decode();
+
+    std::vector<int> page_widths, page_heights;
+    pack(page_widths, page_heights);
+
+    m_pages.resize(page_widths.size());
+    glGenTextures((GLsizei) m_pages.size(), m_pages.data());
+    for (size_t page = 0; page < m_pages.size(); page++) upload((int) page, page_widths[page], page_heights[page], filter);
+
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        Entry& entry = m_entries[i];
+        if (entry.pixels == NULL)
+        {
+            std::cout << "Unable to load image. Make sure the path is correct." << '\n' << entry.filepath << std::endl;
+            continue;
+        }
+
+        float page_width = (float) page_widths[entry.page], page_height = (float) page_heights[entry.page];
+        AtlasRegion& region = m_regions[i];
+        region.texture_id = m_pages[entry.page];
+        region.u = (entry.x + m_padding) / page_width;
+        region.v = (entry.y + m_padding) / page_height;
+        region.width = entry.width / page_width;
+        region.height = entry.height / page_height;
+        region.pixel_width = entry.width;
+        region.pixel_height = entry.height;
+
+        stbi_image_free(entry.pixels);
+        entry.pixels = NULL;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include <string>
+#include <vector>
+
+const int ATLAS_PAGE_SIZE = 2048;
+const int ATLAS_PADDING = 2;         // texels around each sprite, filled with its edge
+
+// Where a sprite ended up: the page texture and its rectangle in page UVs.
+// Texture coordinates written for the whole sprite (0..1) go through map().
+struct AtlasRegion
+{
+    GLuint texture_id = 0;
+    float  u = 0.0f, v = 0.0f;
+    float  width = 1.0f, height = 1.0f;
+    int    pixel_width = 0, pixel_height = 0;
+
+    void map(const float* tex_coords, float* out, int vertex_count) const
+    {
+        for (int i = 0; i < vertex_count * 2; i += 2)
+        {
+            out[i] = u + tex_coords[i] * width;
+            out[i + 1] = v + tex_coords[i + 1] * height;
+        }
+    };
+};
+
+// Packs a scene's sprites into as few textures as possible, so drawing them
+// needs no texture switches and can go out in one batch. add() every sprite,
+// then build(): the files are decoded in parallel, packed with MaxRects
+// (best short side fit, largest first) and uploaded one texture per page.
+class TextureAtlas
+{
+private:
+    struct Entry
+    {
+        std::string    filepath;
+        unsigned char* pixels = NULL;
+        int width = 0, height = 0;
+        int page = 0, x = 0, y = 0;   // top-left of the padded cell
+    };
+
+    int m_page_size;
+    int m_padding;
+    std::vector<Entry> m_entries;
+    std::vector<GLuint> m_pages;
+    std::vector<AtlasRegion> m_regions;
+
+    void decode();
+    void pack(std::vector<int>& page_widths, std::vector<int>& page_heights);
+    void upload(int page, int width, int height, GLint filter);
+
+public:
+    TextureAtlas(int page_size = ATLAS_PAGE_SIZE, int padding = ATLAS_PADDING) : m_page_size(page_size), m_padding(padding) {};
+
+    // Returns a handle for get_region(), valid once build() has run
+    int  add(const char* filepath);
+    void build(GLint filter = GL_NEAREST);
+
+    const AtlasRegion& get_region(int handle) const { return m_regions[handle]; };
+    int const get_page_count() const { return (int) m_pages.size(); };
+};
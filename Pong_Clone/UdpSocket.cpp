@@ -0,0 +1,228 @@
+#include "UdpSocket.h"
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static double now_ms()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool start_sockets()
+{
+#ifdef _WIN32
+    static bool started = false;
+    if (!started)
+    {
+        WSADATA data;
+        started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }
+    return started;
+#else
+    return true;
+#endif
+}
+
+bool udp_resolve(const char* host, unsigned short port, UdpAddress* address)
+{
+    if (!start_sockets()) return false;
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* result = NULL;
+    if (getaddrinfo(host, NULL, &hints, &result) != 0 || result == NULL)
+    {
+        std::cout << "Unable to resolve host: " << host << std::endl;
+        return false;
+    }
+
+    address->host = ((sockaddr_in*) result->ai_addr)->sin_addr.s_addr;
+    address->port = htons(port);
+    freeaddrinfo(result);
+    return true;
+}
+
+bool operator==(const UdpAddress& a, const UdpAddress& b)
+{
+    return a.host == b.host && a.port == b.port;
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+}
+
+bool UdpSocket::open(unsigned short port)
+{
+    if (!start_sockets()) return false;
+
+    long long handle = (long long) socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+    if (handle == (long long) INVALID_SOCKET) handle = -1;
+#endif
+    if (handle == -1)
+    {
+        std::cout << "Unable to create UDP socket" << std::endl;
+        return false;
+    }
+
+    sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+
+    // Non-blocking, so polling from the game loop never stalls a frame
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    bool configured = bind((SOCKET) handle, (sockaddr*) &local, sizeof(local)) == 0
+        && ioctlsocket((SOCKET) handle, FIONBIO, &non_blocking) == 0;
+#else
+    bool configured = bind((int) handle, (sockaddr*) &local, sizeof(local)) == 0
+        && fcntl((int) handle, F_SETFL, fcntl((int) handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+
+    m_handle = handle;
+    if (!configured)
+    {
+        std::cout << "Unable to bind UDP port " << port << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void UdpSocket::close()
+{
+    if (m_handle == -1) return;
+#ifdef _WIN32
+    closesocket((SOCKET) m_handle);
+#else
+    ::close((int) m_handle);
+#endif
+    m_handle = -1;
+    m_pending.clear();
+}
+
+unsigned short UdpSocket::get_port() const
+{
+    sockaddr_in local;
+    socklen_t length = sizeof(local);
+#ifdef _WIN32
+    if (getsockname((SOCKET) m_handle, (sockaddr*) &local, &length) != 0) return 0;
+#else
+    if (getsockname((int) m_handle, (sockaddr*) &local, &length) != 0) return 0;
+#endif
+    return ntohs(local.sin_port);
+}
+
+float UdpSocket::random_unit()
+{
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return (m_seed >> 8) * (1.0f / 16777216.0f);
+}
+
+void UdpSocket::send_now(const UdpAddress& to, const void* data, int size)
+{
+    sockaddr_in remote;
+    memset(&remote, 0, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = to.host;
+    remote.sin_port = to.port;
+
+#ifdef _WIN32
+    sendto((SOCKET) m_handle, (const char*) data, size, 0, (sockaddr*) &remote, sizeof(remote));
+#else
+    sendto((int) m_handle, data, size, 0, (sockaddr*) &remote, sizeof(remote));
+#endif
+}
+
+void UdpSocket::send(const UdpAddress& to, const void* data, int size)
+{
+    if (m_handle == -1) return;
+    m_sent++;
+
+    if (m_loss > 0.0f && random_unit() < m_loss)
+    {
+        m_dropped++;
+        return;
+    }
+
+    if (m_latency_ms <= 0.0 && m_jitter_ms <= 0.0)
+    {
+        send_now(to, data, size);
+        return;
+    }
+
+    PendingPacket packet;
+    packet.release_time = now_ms() + m_latency_ms + m_jitter_ms * random_unit();
+    packet.to = to;
+    packet.data.assign((const unsigned char*) data, (const unsigned char*) data + size);
+    m_pending.push_back(packet);
+}
+
+void UdpSocket::flush()
+{
+    if (m_pending.empty()) return;
+
+    // Jitter can put packets out of order, just like a real network would
+    double now = now_ms();
+    size_t kept = 0;
+    for (size_t i = 0; i < m_pending.size(); i++)
+    {
+        if (m_pending[i].release_time <= now)
+        {
+            send_now(m_pending[i].to, m_pending[i].data.data(), (int) m_pending[i].data.size());
+        }
+        else
+        {
+            if (kept != i) m_pending[kept] = std::move(m_pending[i]);
+            kept++;
+        }
+    }
+    m_pending.resize(kept);
+}
+
+int UdpSocket::receive(UdpAddress* from, void* buffer, int capacity)
+{
+    if (m_handle == -1) return 0;
+    flush();
+
+    sockaddr_in remote;
+    socklen_t length = sizeof(remote);
+#ifdef _WIN32
+    int bytes = recvfrom((SOCKET) m_handle, (char*) buffer, capacity, 0, (sockaddr*) &remote, &length);
+#else
+    int bytes = (int) recvfrom((int) m_handle, buffer, capacity, 0, (sockaddr*) &remote, &length);
+#endif
+    if (bytes <= 0) return 0;
+
+    if (from != NULL)
+    {
+        from->host = remote.sin_addr.s_addr;
+        from->port = remote.sin_port;
+    }
+    m_received++;
+    return bytes;
+}
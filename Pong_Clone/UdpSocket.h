@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+
+// IPv4 address and port, both in network byte order. Kept free of any
+// platform socket headers so this file can sit next to SDL and GL includes.
+struct UdpAddress
+{
+    unsigned int   host = 0;
+    unsigned short port = 0;
+};
+
+bool udp_resolve(const char* host, unsigned short port, UdpAddress* address);
+bool operator==(const UdpAddress& a, const UdpAddress& b);
+
+class UdpSocket
+{
+private:
+    struct PendingPacket
+    {
+        double release_time;
+        UdpAddress to;
+        std::vector<unsigned char> data;
+    };
+
+    long long m_handle = -1;
+
+    // ————— SIMULATED NETWORK ————— //
+    // Outgoing packets wait here until their simulated latency has passed
+    std::vector<PendingPacket> m_pending;
+    double m_latency_ms = 0.0;
+    double m_jitter_ms  = 0.0;
+    float  m_loss       = 0.0f;
+    unsigned int m_seed = 0x2545F491u;
+
+    // ————— STATS ————— //
+    int m_sent     = 0;
+    int m_dropped  = 0;
+    int m_received = 0;
+
+    float random_unit();
+    void  send_now(const UdpAddress& to, const void* data, int size);
+
+public:
+    ~UdpSocket();
+
+    // Binds to the given port on every interface; 0 picks any free port
+    bool open(unsigned short port);
+    void close();
+
+    void send(const UdpAddress& to, const void* data, int size);
+    // Returns the number of bytes read, or 0 when nothing is waiting. Never blocks.
+    int  receive(UdpAddress* from, void* buffer, int capacity);
+    // Sends whatever delayed packets are due; receive() does this too
+    void flush();
+
+    unsigned short get_port() const;
+    bool const is_open()      const { return m_handle != -1; };
+    int  const get_sent()     const { return m_sent;     };
+    int  const get_dropped()  const { return m_dropped;  };
+    int  const get_received() const { return m_received; };
+
+    void set_simulated_latency(double latency_ms, double jitter_ms) { m_latency_ms = latency_ms; m_jitter_ms = jitter_ms; };
+    void set_simulated_loss(float loss) { m_loss = loss; };
+};
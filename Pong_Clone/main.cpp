@@ -12,11 +12,27 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
 #include "stb_image.h"
+#include "TextureAtlas.h"
+#include "FramePacer.h"
+#include "FrameTimeRecorder.h"
+#include "FixedTimestep.h"
+#include "InputRecorder.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "CommandList.h"
+#include "RenderBackend.h"
+#include "BallPool.h"
+#include "RollbackSession.h"
+#include <stdlib.h>
+#include <string.h>
 
 #define LOG(argument) std::cout << argument << '\n'
 
 SDL_Window* g_display_window;
 bool g_game_is_running = true; //tracks whether game is running
+FramePacer g_frame_pacer;      //caps the frame rate, slows right down while minimized
+FrameTimeRecorder g_frame_recorder;    //frame time percentiles and hitches, reported at exit
+const char* g_frame_report_path = NULL;     //--frame-report FILE; no report without it
 
 //DEFINE GLOBAL CONSTANTS
 const int WINDOW_WIDTH = 640 * 2,
@@ -29,15 +45,32 @@ VIEWPORT_HEIGHT = WINDOW_HEIGHT;
 
 const char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
 F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
+const char V_INSTANCED_SHADER_PATH[] = "shaders/vertex_instanced.glsl",
+F_INSTANCED_SHADER_PATH[] = "shaders/fragment_instanced.glsl";
 
-const float MILLISECONDS_IN_SECOND = 1000.0;
 const float DEGREES_PER_SECOND = 90.0f;
 const float MINIMUM_X_COLLISION_DISTANCE = 0.375f;
 const float MINIMUM_Y_COLLISION_DISTANCE = 0.8f;
-
-const int NUMBER_OF_TEXTURES = 1; // to be generated, that is
-const GLint LEVEL_OF_DETAIL = 0;  // base image level; Level n is the nth mipmap reduction image
-const GLint TEXTURE_BORDER = 0;   // this value MUST be zero
+const float WALL_Y = 3.5f;
+const float EXIT_X = 5.0f;
+const float BALL_SIZE = 100.0f / 200.0f;   //cat.png is 100 by 100, drawn at a scale of 200
+
+const int STRESS_BALL_COUNT = 100000;
+const float STRESS_STATS_SECONDS = 1.0f;   //how often stress mode prints its numbers
+const size_t STREAM_BUFFER_BYTES = 1 << 20; //per frame; grows to fit stress mode
+const float STATS_OVERLAY_UNITS_PER_TEXEL = 2.0f * 10.0f / WINDOW_WIDTH;   //two screen pixels per texel
+const float BALL_SPEED_RAMP = 0.5f;        //how much faster the balls get every second in speed-ramp mode
+
+//netplay settings
+const float NET_FRAME_TIME = 1.0f / 60.0f; //rollback needs every peer to step the same fixed amount
+const int   NET_MAX_STEPS = 15;            //don't try to catch up on more than a quarter second after a hitch
+const int   NET_INPUT_DELAY = 2;           //frames of local input delay, hides most of the rollbacks
+const int   NET_BALL_COUNT = 1;
+const int   NET_STATS_FRAMES = 300;        //log rollback stats this often
+
+//where the first three balls start and which way they head
+const glm::vec3 BALL_STARTS[] = { glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, -2.0f, 0.0f) };
+const glm::vec3 BALL_MOVEMENTS[] = { glm::vec3(0.5f, 0.5f, 0.0f), glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(-0.5f, -0.5f, 0.0f) };
 
 //filepaths for assets
 const char PADDLE_SPRITE_FILEPATH[] = "sprites/paw.png";     //120 by 240
@@ -46,19 +79,27 @@ const char OVER_SPRITE_FILEPATH[] = "sprites/player1wins.png";    //422 by 182
 const char OVER2_SPRITE_FILEPATH[] = "sprites/player2wins.png";    //422 by 182
 
 //DEFINE GLOBAL VARIABLES
-//texture files
-GLuint g_paddle_texture_id;
-GLuint g_ball_texture_id;
-GLuint g_over_texture_id;
-GLuint g_over2_texture_id;
+//sprites, all packed into one atlas texture so drawing them never switches textures
+TextureAtlas g_atlas;
+int g_paddle_sprite;
+int g_ball_sprite;
+int g_over_sprite;
+int g_over2_sprite;
 
 ShaderProgram g_shader_program; //shader program
+InstancedRenderer g_instanced_renderer; //draws the paddles and every ball in one call when GL 3.3 is available
+StreamBuffer g_stream_buffer;           //per-frame vertex data, triple buffered
+RenderStatsOverlay g_stats_overlay;     //F3 or --stats-overlay
+GLRenderBackend* g_gl_backend = NULL;   //draws recorded frames; NULL without a context or with --renderer null
+NullRenderBackend g_null_backend;       //--renderer null: frames are recorded and counted, never drawn
+RecordingRenderBackend* g_command_recorder = NULL;   //--record-commands FILE, in front of whichever draws
+RenderBackend* g_render_backend = NULL; //where recorded frames go
+CommandList g_command_list;             //the paddles, balls and overlay of the frame being drawn
 glm::mat4 view_matrix, g_projection_matrix;
-//model matrices of assets use
-glm::mat4 g_player_model_matrix, g_player2_model_matrix, g_ball_model_matrix, g_ball2_model_matrix, g_ball3_model_matrix;
-
-float g_previous_ticks = 0.0f; //used for delta time calculation
 
+FixedTimestep g_timestep;      //turns real time into fixed simulation steps
+glm::vec3 g_player_previous_position, g_player2_previous_position; //before the last step, for interpolation
+glm::vec3 g_player_draw_position, g_player2_draw_position;         //where the paddles are drawn this frame
 
 glm::vec3 g_player_position = glm::vec3(0.0f, 0.0f, 0.0f);    
 glm::vec3 g_player_movement = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -66,64 +107,57 @@ glm::vec3 g_player_movement = glm::vec3(0.0f, 0.0f, 0.0f);
 glm::vec3 g_player2_position = glm::vec3(0.0f, 0.0f, 0.0f);
 glm::vec3 g_player2_movement = glm::vec3(0.0f, 0.0f, 0.0f);
 
-glm::vec3 g_ball_position = glm::vec3(0.0f, 0.0f, 0.0f);
-glm::vec3 g_ball_movement = glm::vec3(0.0f, 0.0f, 0.0f);
-
-glm::vec3 g_ball2_position = glm::vec3(0.0f, 0.0f, 0.0f);
-glm::vec3 g_ball2_movement = glm::vec3(0.0f, 0.0f, 0.0f);
-
-glm::vec3 g_ball3_position = glm::vec3(0.0f, 0.0f, 0.0f);
-glm::vec3 g_ball3_movement = glm::vec3(0.0f, 0.0f, 0.0f);
+BallPool g_balls(MINIMUM_X_COLLISION_DISTANCE, MINIMUM_Y_COLLISION_DISTANCE, WALL_Y, EXIT_X, BALL_SIZE);
 
 float g_player_speed = 5.0f;
 float g_ball_speed = 3.0f;
 
 float g_rot_angle = 0.0f;
+float g_previous_rot_angle = 0.0f;
+float g_draw_rot_angle = 0.0f;
 const float ROT_SPEED = 300.0f;
 
-enum CollisionType { noC, horizC, vertC};
-
-enum BallsNumber {noBalls, oneBall, twoBalls, threeBalls};
-BallsNumber g_balls_number = noBalls;
-
-bool g_balls_generated = false;
+//input actions; held ones last while the key is down, the rest happen once per press
+const InputActions ACTION_PLAYER_UP = 1 << 0,
+ACTION_PLAYER_DOWN = 1 << 1,
+ACTION_PLAYER2_UP = 1 << 2,
+ACTION_PLAYER2_DOWN = 1 << 3,
+ACTION_SINGLEPLAYER = 1 << 4,
+ACTION_ONE_BALL = 1 << 5,
+ACTION_TWO_BALLS = 1 << 6,
+ACTION_THREE_BALLS = 1 << 7,
+ACTION_STRESS_MODE = 1 << 8,
+ACTION_SPEED_RAMP = 1 << 9;
+
+bool g_stress_mode = false;
+float g_stress_stats_timer = 0.0f;
+int g_stress_stats_frames = 0;
+bool g_speed_ramp = false;
+
+UdpSocket g_net_socket;
+RollbackSession* g_net_session = NULL;     //only set when started with --net
+int g_net_stats_frame = 0;
 
 bool g_gameover = false;
 bool g_singleplayer = false;
 bool g_player1_wins = true;
 
+InputRecorder g_input_recorder;        //--record FILE: every tick's input, written at exit
+InputReplay g_input_replay;            //--replay FILE: plays a recording back without a window
+InputActions g_held_actions = 0;
+
 
 
 //START OF CODE -----------------------------------------------------------------------------------------
 
-//FUNCTION PROFESSOR WROTE IN CLASS
-GLuint load_texture(const char* filepath)
+//packs every sprite into the atlas based on filepath; a replay adds them too, so the frames it
+//records have their regions, though with no atlas built there are no textures behind them
+void add_sprites()
 {
-    // STEP 1: Loading the image file
-    int width, height, number_of_components;
-    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
-
-    if (image == NULL)
-    {
-        LOG("Unable to load image. Make sure the path is correct.");
-        LOG(filepath);
-        assert(false);
-    }
-
-    // STEP 2: Generating and binding a texture ID to our image
-    GLuint textureID;
-    glGenTextures(NUMBER_OF_TEXTURES, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, image);
-
-    // STEP 3: Setting our texture filter parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    // STEP 4: Releasing our file from memory and returning our texture id
-    stbi_image_free(image);
-
-    return textureID;
+    g_paddle_sprite = g_atlas.add(PADDLE_SPRITE_FILEPATH);
+    g_ball_sprite = g_atlas.add(BALL_SPRITE_FILEPATH);
+    g_over_sprite = g_atlas.add(OVER_SPRITE_FILEPATH);
+    g_over2_sprite = g_atlas.add(OVER2_SPRITE_FILEPATH);
 }
 
 void initialise()
@@ -145,17 +179,17 @@ void initialise()
 
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
 
-    g_shader_program.load(V_SHADER_PATH, F_SHADER_PATH);
+    // Both programs compile while the buffers are made and the atlas is packed
+    g_shader_program.start_load(V_SHADER_PATH, F_SHADER_PATH);
+    g_instanced_renderer.start_load(V_INSTANCED_SHADER_PATH, F_INSTANCED_SHADER_PATH);
+    g_stream_buffer.create(STREAM_BUFFER_BYTES);
+    g_stats_overlay.create();
 
-    g_player_model_matrix = glm::mat4(1.0f);
-    g_player2_model_matrix = glm::mat4(1.0f);
-    g_ball_model_matrix = glm::mat4(1.0f);
-    g_ball2_model_matrix = glm::mat4(1.0f);
-    g_ball3_model_matrix = glm::mat4(1.0f);
+    add_sprites();
+    g_atlas.build();
 
-    g_ball_movement = glm::vec3(0.5f, 0.5f, 0.0f);
-    g_ball2_movement = glm::vec3(-0.5f, -0.5f, 0.0f);
-    g_ball3_movement = glm::vec3(-0.5f, -0.5f, 0.0f);
+    g_shader_program.finish_load();
+    g_instanced_renderer.finish_load();
 
     view_matrix = glm::mat4(1.0f);  // Defines the position (location and orientation) of the camera
     g_projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);  // Defines the characteristics of your camera, such as clip planes, field of view, projection method etc.
@@ -164,340 +198,322 @@ void initialise()
     g_shader_program.set_view_matrix(view_matrix);
     // Notice we haven't set our model matrix yet!
 
-    glUseProgram(g_shader_program.get_program_id());
+    g_gl_state.use_program(g_shader_program.get_program_id());
 
-    glClearColor(255.0f, 255.0f, 255.0f, 1.0f); //sets background to white by default
-
-    //loads textures based on filepath
-    g_paddle_texture_id = load_texture(PADDLE_SPRITE_FILEPATH);
-    g_ball_texture_id = load_texture(BALL_SPRITE_FILEPATH);
-    g_over_texture_id = load_texture(OVER_SPRITE_FILEPATH);
-    g_over2_texture_id = load_texture(OVER2_SPRITE_FILEPATH);
+    glClearColor(255.0f/255.0f, 182.0f / 255.0f, 193.0f / 255.0f, 1.0f); //sets background to pink
 
     // enable blending
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    g_gl_state.set_blend(true);
+    g_gl_state.set_blend_function(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-void process_input()
+void spawn_balls(int count)
+{
+    if (g_net_session != NULL) return;   //netplay matches always start the same way
+    if (g_balls.get_count() > 0) return; //the number of balls is picked once per game
+
+    for (int i = 0; i < count and i < 3; i++) {
+        g_balls.spawn(BALL_STARTS[i], BALL_MOVEMENTS[i]);
+    }
+}
+
+void start_stress_mode()
 {
+    if (g_net_session != NULL) return;
+
+    //balls that leave the arena come back in the middle so the count stays put
+    g_stress_mode = true;
+    g_balls.clear();
+    g_balls.set_respawn_exited(true);
+
+    for (int i = 0; i < STRESS_BALL_COUNT; i++) {
+        float x = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * (EXIT_X - 1.0f);
+        float y = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * WALL_Y;
+        float angle = (float)rand() / RAND_MAX * 6.2831853f;
+        g_balls.spawn(glm::vec3(x, y, 0.0f), glm::vec3(cos(angle), sin(angle), 0.0f) * 0.7f);
+    }
+    LOG("Stress mode: " << g_balls.get_count() << " balls");
+}
+
+bool start_netplay(int argc, char* argv[])
+{
+    //--net <local port> <peer host> <peer port> <player 1|2> [latency ms] [loss percent]
+    unsigned short local_port = (unsigned short)atoi(argv[2]);
+    unsigned short peer_port = (unsigned short)atoi(argv[4]);
+    int player = atoi(argv[5]) - 1;
+    double latency = argc > 6 and argv[6][0] != '-' ? atof(argv[6]) : 0.0;
+    float loss = argc > 7 and argv[6][0] != '-' and argv[7][0] != '-' ? (float)atof(argv[7]) / 100.0f : 0.0f;
+
+    UdpAddress peer;
+    if (!g_net_socket.open(local_port) or !udp_resolve(argv[3], peer_port, &peer)) return false;
+
+    //latency is added on our way out, so each side simulates its own half of the trip
+    g_net_socket.set_simulated_latency(latency, latency * 0.25);
+    g_net_socket.set_simulated_loss(loss);
+
+    g_net_session = new RollbackSession(&g_net_socket, peer, player == 1 ? 1 : 0, NET_INPUT_DELAY, NET_FRAME_TIME, NET_BALL_COUNT);
+    LOG("Netplay as player " << (player == 1 ? 2 : 1) << " on port " << local_port);
+    return true;
+}
+
+//the game only ever sees input as actions, so a replay drives it exactly as the keyboard did
+void apply_actions(InputActions held, InputActions pressed)
+{
+    g_held_actions = held;
+
+    if (pressed & ACTION_SINGLEPLAYER) g_singleplayer = true;
+    if (pressed & ACTION_ONE_BALL) spawn_balls(1);
+    if (pressed & ACTION_TWO_BALLS) spawn_balls(2);
+    if (pressed & ACTION_THREE_BALLS) spawn_balls(3);
+    if (pressed & ACTION_STRESS_MODE) start_stress_mode();
+    if (pressed & ACTION_SPEED_RAMP) g_speed_ramp = !g_speed_ramp;
+
     g_player_movement = glm::vec3(0.0f);
     g_player2_movement = glm::vec3(0.0f);
+    if (held & ACTION_PLAYER_UP) g_player_movement.y = 1.0f;
+    else if (held & ACTION_PLAYER_DOWN) g_player_movement.y = -1.0f;
+    if (held & ACTION_PLAYER2_UP) g_player2_movement.y = 1.0f;
+    else if (held & ACTION_PLAYER2_DOWN) g_player2_movement.y = -1.0f;
+}
+
+void process_input()
+{
+    PROFILE_SCOPE("process_input");
+    InputActions pressed = 0;
     SDL_Event event;
 
-    while (SDL_PollEvent(&event))                                           
-    {                                                                        
-        switch (event.type)                                                  
-        {                                                                    
-        case SDL_QUIT:                                                   
-        case SDL_WINDOWEVENT_CLOSE:                                      
-            g_game_is_running = false;                                   
-            break;       
+    while (SDL_PollEvent(&event))
+    {
+        switch (event.type)
+        {
+        case SDL_QUIT:
+        case SDL_WINDOWEVENT_CLOSE:
+            g_game_is_running = false;
+            break;
         //keystrokes check
-        case SDL_KEYDOWN:                                               
-            switch (event.key.keysym.sym)                               
-            {                                                           
-            case SDLK_q: 
-                g_game_is_running = false;                           
-                break;    
+        case SDL_KEYDOWN:
+            switch (event.key.keysym.sym)
+            {
+            case SDLK_q:
+                g_game_is_running = false;
+                break;
             case SDLK_t:
-                g_singleplayer = true;
+                pressed |= ACTION_SINGLEPLAYER;
                 break;
             case SDLK_1:
-                if (g_balls_number == noBalls) g_balls_number = oneBall;
+                pressed |= ACTION_ONE_BALL;
+                break;
             case SDLK_2:
-                if (g_balls_number == noBalls) g_balls_number = twoBalls;
+                pressed |= ACTION_TWO_BALLS;
+                break;
             case SDLK_3:
-                if (g_balls_number == noBalls) g_balls_number = threeBalls;
-            default:                                                 
-                break;                                               
-            }                                                                                                                      
-        default:                                                         
-            break;                                                       
-        }                                                                    
-    }                                                                        
-
-    //key hold checks                                                                       
-    const Uint8* key_state = SDL_GetKeyboardState(NULL);                    
-
-    if (key_state[SDL_SCANCODE_W])                                       
-    {                                                                     
-        g_player_movement.y = 1.0f;                                         
-    }                                                                        
-    else if (key_state[SDL_SCANCODE_S])                                  
-    {                                                                        
-        g_player_movement.y = -1.0f;                                          
-    }                                                                        
-                                                                             
-    if (key_state[SDL_SCANCODE_UP])                                          
-    {                                                                        
-        g_player2_movement.y = 1.0f;                                          
-    }                                                                        
-    else if (key_state[SDL_SCANCODE_DOWN])                                   
-    {                                                                        
-        g_player2_movement.y = -1.0f;                                         
-    }                                                                        
+                pressed |= ACTION_THREE_BALLS;
+                break;
+            case SDLK_0:
+                pressed |= ACTION_STRESS_MODE;
+                break;
+            case SDLK_r:
+                pressed |= ACTION_SPEED_RAMP;
+                break;
+            case SDLK_F3:
+                g_stats_overlay.toggle();
+                break;
+            default:
+                break;
+            }
+        default:
+            break;
+        }
+    }
+
+    //key hold checks
+    const Uint8* key_state = SDL_GetKeyboardState(NULL);
+    InputActions held = 0;
+
+    if (key_state[SDL_SCANCODE_W]) held |= ACTION_PLAYER_UP;
+    else if (key_state[SDL_SCANCODE_S]) held |= ACTION_PLAYER_DOWN;
+
+    if (key_state[SDL_SCANCODE_UP]) held |= ACTION_PLAYER2_UP;
+    else if (key_state[SDL_SCANCODE_DOWN]) held |= ACTION_PLAYER2_DOWN;
+
+    apply_actions(held, pressed);
+    g_input_recorder.press(pressed);
 }
 
-CollisionType check_collision(glm::vec3& paddle_pos, glm::vec3& ball_pos)
-{ 
-    float dx = abs(ball_pos.x - paddle_pos.x);
-    float dy = abs(ball_pos.y - paddle_pos.y);
+//copies the rollback session's latest state into what gets drawn
+void apply_net_state()
+{
+    const PongState& state = g_net_session->get_state();
+    g_player_position = glm::vec3(-PONG_PADDLE_X, state.paddle_y[0], 0.0f);
+    g_player2_position = glm::vec3(PONG_PADDLE_X, state.paddle_y[1], 0.0f);
 
-    if (dx < MINIMUM_X_COLLISION_DISTANCE && dy < MINIMUM_Y_COLLISION_DISTANCE) {
-        if (ball_pos.y > paddle_pos.y + MINIMUM_Y_COLLISION_DISTANCE or ball_pos.y < paddle_pos.y - MINIMUM_Y_COLLISION_DISTANCE) {
-            return vertC;
-        }
-        else {
-            return horizC;
-        }
+    if (g_balls.get_count() != state.ball_count) {
+        g_balls.clear();
+        for (int i = 0; i < state.ball_count; i++) g_balls.spawn(glm::vec3(0.0f), glm::vec3(0.0f));
     }
-    else {
-        return CollisionType::noC;
+    for (int i = 0; i < state.ball_count; i++) {
+        g_balls.set_position(i, glm::vec3(state.ball_x[i], state.ball_y[i], 0.0f));
     }
+
+    g_gameover = state.result != pongPlaying;
+    g_player1_wins = state.result == pongPlayer1Wins;
 }
 
-void update()
+void update_netplay(int steps)
 {
-    float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND; // get the current number of ticks
-    float delta_time = ticks - g_previous_ticks; // the delta time is the difference from the last frame
-    g_previous_ticks = ticks;
-    g_rot_angle += delta_time * 100;
-
-    glClearColor(255.0f/255.0f, 182.0f / 255.0f, 193.0f / 255.0f, 1.0f);
+    //either set of keys drives our own paddle
+    PongInput input = 0;
+    if (g_player_movement.y > 0 or g_player2_movement.y > 0) input |= PONG_INPUT_UP;
+    if (g_player_movement.y < 0 or g_player2_movement.y < 0) input |= PONG_INPUT_DOWN;
+
+    //everything on screen comes from the rollback state
+    for (int i = 0; i < steps; i++) {
+        g_player_previous_position = g_player_position;
+        g_player2_previous_position = g_player2_position;
+        g_balls.save_previous();
+        g_previous_rot_angle = g_rot_angle;
+        g_rot_angle += NET_FRAME_TIME * 100;
+        g_net_session->advance(input);
+        apply_net_state();
+    }
 
-    //g_ball_speed += delta_time;
-    
-    if (g_balls_generated == false and not g_balls_number == noBalls) {
-        g_ball_position = glm::vec3(0.0f, 0.0f, 0.0f);
-        g_ball2_position = glm::vec3(0.0f, 2.0f, 0.0f);
-        g_ball3_position = glm::vec3(0.0f, -2.0f, 0.0f);
-        g_balls_generated = true;
+    if (g_net_session->get_frame() - g_net_stats_frame >= NET_STATS_FRAMES) {
+        g_net_stats_frame = g_net_session->get_frame();
+        LOG("frame " << g_net_session->get_frame()
+            << " | confirmed " << g_net_session->get_confirmed_frame()
+            << " | rollbacks " << g_net_session->get_rollbacks()
+            << " | deepest " << g_net_session->get_max_rollback_frames() << " frames"
+            << " | worst resim " << g_net_session->get_max_resimulate_ms() << " ms"
+            << " | stalls " << g_net_session->get_stalls()
+            << " | dropped " << g_net_socket.get_dropped() << "/" << g_net_socket.get_sent());
     }
+}
+
+//advances a local game by one fixed step
+void simulate(float delta_time)
+{
+    g_previous_rot_angle = g_rot_angle;
+    g_player_previous_position = g_player_position;
+    g_player2_previous_position = g_player2_position;
+
+    g_rot_angle += delta_time * 100;
+
+    //balls are swept against paddles and walls, so they can't tunnel however fast this gets
+    if (g_speed_ramp) g_ball_speed += BALL_SPEED_RAMP * delta_time;
 
     if (g_player_position.y < 3.5f and g_player_movement.y > 0) g_player_position += g_player_movement * g_player_speed * delta_time; 
     if (g_player_position.y > -3.5f and g_player_movement.y < 0) g_player_position += g_player_movement * g_player_speed * delta_time;
     g_player_position.x = -4.0f;
 
-    g_player_model_matrix = glm::mat4(1.0f);
-    g_player_model_matrix = glm::translate(g_player_model_matrix, g_player_position);
-
     if (not g_singleplayer) {
         if (g_player2_position.y < 3.5f and g_player2_movement.y > 0) g_player2_position += g_player2_movement * g_player_speed * delta_time;
         if (g_player2_position.y > -3.5f and g_player2_movement.y < 0) g_player2_position += g_player2_movement * g_player_speed * delta_time;
     }
     else {
-        if (g_ball_position.y > g_player2_position.y) {
+        //the computer follows the first ball
+        glm::vec3 ball_position = g_balls.get_count() > 0 ? g_balls.get_position(0) : glm::vec3(0.0f);
+        if (ball_position.y > g_player2_position.y) {
             g_player2_position += glm::vec3(0.0f, 1.0f, 0.0f) * g_player_speed * delta_time;
         }
-        if (g_ball_position.y < g_player2_position.y) {
+        if (ball_position.y < g_player2_position.y) {
             g_player2_position += glm::vec3(0.0f, -1.0f, 0.0f) * g_player_speed * delta_time;
         }
     }
 
     g_player2_position.x = 4.0f;
-    g_player2_model_matrix = glm::mat4(1.0f);
-    g_player2_model_matrix = glm::translate(g_player2_model_matrix, g_player2_position);
-    
-    switch (check_collision(g_player_position, g_ball_position)) {
-    case horizC:
-        g_ball_movement.x = -g_ball_movement.x;
-    case vertC:
-        g_ball_movement.y = -g_ball_movement.y;
-    default:
-        break;
-    }
-    switch (check_collision(g_player2_position, g_ball_position)) {
-    case horizC:
-        g_ball_movement.x = -g_ball_movement.x;
-    case vertC:
-        g_ball_movement.y = -g_ball_movement.y;
-    default:
-        break;
-    }
 
-    switch (check_collision(g_player_position, g_ball2_position)) {
-    case horizC:
-        g_ball2_movement.x = -g_ball2_movement.x;
-    case vertC:
-        g_ball2_movement.y = -g_ball2_movement.y;
-    default:
-        break;
-    }
-    switch (check_collision(g_player2_position, g_ball2_position)) {
-    case horizC:
-        g_ball2_movement.x = -g_ball2_movement.x;
-    case vertC:
-        g_ball2_movement.y = -g_ball2_movement.y;
-    default:
-        break;
-    }
+    //paddle, wall and exit checks for every ball happen in one pass
+    g_balls.update(delta_time, g_ball_speed, g_player_position, g_player2_position);
 
-    switch (check_collision(g_player_position, g_ball3_position)) {
-    case horizC:
-        g_ball3_movement.x = -g_ball3_movement.x;
-    case vertC:
-        g_ball3_movement.y = -g_ball3_movement.y;
-    default:
-        break;
+    if (g_balls.get_right_exit()) {
+        g_gameover = true;
     }
-    switch (check_collision(g_player2_position, g_ball3_position)) {
-    case horizC:
-        g_ball3_movement.x = -g_ball3_movement.x;
-    case vertC:
-        g_ball3_movement.y = -g_ball3_movement.y;
-    default:
-        break;
+    if (g_balls.get_left_exit()) {
+        g_gameover = true;
+        g_player1_wins = false;
     }
+}
 
-    if (g_ball_position.y > 3.5f) {
-        g_ball_movement.y = -g_ball_movement.y;
-    }
-    if (g_ball_position.y < -3.5f) {
-        g_ball_movement.y = -g_ball_movement.y;
-    }
-    if (g_ball2_position.y > 3.5f) {
-        g_ball2_movement.y = -g_ball2_movement.y;
-    }
-    if (g_ball2_position.y < -3.5f) {
-        g_ball2_movement.y = -g_ball2_movement.y;
-    }
-    if (g_ball3_position.y > 3.5f) {
-        g_ball3_movement.y = -g_ball3_movement.y;
-    }
-    if (g_ball3_position.y < -3.5f) {
-        g_ball3_movement.y = -g_ball3_movement.y;
-    }
+//places everything part way between the last two steps
+void update_transforms(float alpha)
+{
+    g_draw_rot_angle = g_previous_rot_angle + (g_rot_angle - g_previous_rot_angle) * alpha;
+    g_player_draw_position = glm::mix(g_player_previous_position, g_player_position, alpha);
+    g_player2_draw_position = glm::mix(g_player2_previous_position, g_player2_position, alpha);
+}
 
-    if (g_balls_number == oneBall or g_balls_number == twoBalls or g_balls_number == threeBalls) {
-        if (g_ball_position.x > 5.0f) {
-            g_gameover = true;
-        }
-        if (g_ball_position.x < -5.0f) {
-            g_gameover = true;
-            g_player1_wins = false;
-        }
+void update(int steps)
+{
+    PROFILE_SCOPE("update");
+    if (g_net_session != NULL) {
+        update_netplay(steps);
     }
-    if (g_balls_number == twoBalls or g_balls_number == threeBalls) {
-        if (g_ball2_position.x > 5.0f) {
-            g_gameover = true;
-        }
-        if (g_ball2_position.x < -5.0f) {
-            g_gameover = true;
-            g_player1_wins = false;
+    else {
+        for (int i = 0; i < steps; i++) {
+            g_input_recorder.record_tick(g_held_actions);
+            simulate(g_timestep.get_step());
         }
     }
-    if (g_balls_number == threeBalls) {
-        if (g_ball3_position.x > 5.0f) {
-            g_gameover = true;
-        }
-        if (g_ball3_position.x < -5.0f) {
-            g_gameover = true;
-            g_player1_wins = false;
+    update_transforms(g_timestep.get_alpha());
+
+    if (g_stress_mode) {
+        g_stress_stats_frames++;
+        g_stress_stats_timer += g_timestep.get_frame_seconds();
+        if (g_stress_stats_timer >= STRESS_STATS_SECONDS) {
+            LOG("balls " << g_balls.get_count() << " | swept " << g_balls.get_swept_count()
+                << " | stream " << (g_stream_buffer.is_persistent() ? "persistent" : "orphaned")
+                << " " << g_stream_buffer.get_bytes_streamed() / g_stress_stats_frames / 1024 << " KiB/frame"
+                << " fence waits " << g_stream_buffer.get_fence_waits() << " (" << g_stream_buffer.get_fence_wait_ms() << " ms)");
+            g_stream_buffer.reset_stats();
+            g_stress_stats_timer = 0.0f;
+            g_stress_stats_frames = 0;
         }
     }
+}
 
-    g_ball_position += g_ball_movement * g_ball_speed * delta_time;
-    g_ball2_position += g_ball2_movement * g_ball_speed * delta_time;
-    g_ball3_position += g_ball3_movement * g_ball_speed * delta_time;
-
-    g_ball_model_matrix = glm::mat4(1.0f);
-    g_ball_model_matrix = glm::translate(g_ball_model_matrix, g_ball_position);
-
-    g_ball2_model_matrix = glm::mat4(1.0f);
-    g_ball2_model_matrix = glm::translate(g_ball2_model_matrix, g_ball2_position);
-
-    g_ball3_model_matrix = glm::mat4(1.0f);
-    g_ball3_model_matrix = glm::translate(g_ball3_model_matrix, g_ball3_position);
-
-    g_ball_model_matrix = glm::rotate(g_ball_model_matrix, glm::radians(g_rot_angle), glm::vec3(0.0f, 0.0f, 1.0f));
-    g_ball2_model_matrix = glm::rotate(g_ball2_model_matrix, glm::radians(g_rot_angle), glm::vec3(0.0f, 0.0f, 1.0f));
-    g_ball3_model_matrix = glm::rotate(g_ball3_model_matrix, glm::radians(g_rot_angle), glm::vec3(0.0f, 0.0f, 1.0f));
-
+//swaps separately from execute_commands() so the GPU scope ends before the frame goes out
+void present()
+{
+    PROFILE_SCOPE("swap");
+    SDL_GL_SwapWindow(g_display_window);
+    g_profiler.end_gpu_frame();
 }
 
-//FUNCTION PROFESSOR USED IN EXAMPLE
-void draw_object(glm::mat4& object_model_matrix, GLuint& object_texture_id)
+//a sprite of the given size, placed the way the instanced shader places it
+SpriteInstance make_sprite(const AtlasRegion& region, const glm::vec3& position, float width, float height)
 {
-    g_shader_program.set_model_matrix(object_model_matrix);
-    glBindTexture(GL_TEXTURE_2D, object_texture_id);
-    glDrawArrays(GL_TRIANGLES, 0, 6); // we are now drawing 2 triangles, so we use 6 instead of 3
+    SpriteInstance instance = { position.x, position.y, 0.0f, width, height,
+        region.u, region.v, region.width, region.height, 1.0f, 1.0f, 1.0f, 1.0f };
+    return instance;
 }
 
-void render() {
-    glClear(GL_COLOR_BUFFER_BIT);
-    //declare vertices based on dimension of image
+//every frame is recorded here, then drawn by whichever backend is in use
+void record_frame(CommandList* list)
+{
+    PROFILE_SCOPE("record_frame");
+    list->reset();
+    list->clear();
+    list->set_camera(view_matrix, g_projection_matrix);
+
     if (not g_gameover) {
         int SCALE = 240;
         float model_width = 120.0f / SCALE; // width of the image
         float model_height = 240.0f / SCALE; // height of the image
-        float vertices[] = {
-            model_width / 2.0f, -model_height / 2.0f,
-            -model_width / 2.0f, -model_height / 2.0f,
-            -model_width / 2.0f, model_height / 2.0f,
-            model_width / 2.0f, -model_height / 2.0f,
-            -model_width / 2.0f, model_height / 2.0f,
-            model_width / 2.0f, model_height / 2.0f
-        };
-        float texture_coordinates[] = {
-            1.0f, 0.0f,
-            0.0f, 0.0f,
-            0.0f, 1.0f,
-            1.0f, 0.0f,
-            0.0f, 1.0f,
-            1.0f, 1.0f
-        };
-
-
-        glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-        glEnableVertexAttribArray(g_shader_program.get_position_attribute());
-
-        glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, texture_coordinates);
-        glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
-
-        draw_object(g_player_model_matrix, g_paddle_texture_id);
-
-        draw_object(g_player2_model_matrix, g_paddle_texture_id);
-
-        SCALE = 200;
-        model_width = 100.0f / SCALE; // width of the image
-        model_height = 100.0f / SCALE; // height of the image
-        float ball_vertices[] = {
-            -model_width / 2.0f, -model_height / 2.0f,
-            model_width / 2.0f, -model_height / 2.0f,
-            model_width / 2.0f, model_height / 2.0f,
-            -model_width / 2.0f, -model_height / 2.0f,
-            model_width / 2.0f, model_height / 2.0f,
-            -model_width / 2.0f, model_height / 2.0f
-        };
-        float ball_texture_coordinates[] = {
-        0.0f, 0.0f,
-        1.0f, 0.0f,
-        1.0f, 1.0f,
-        0.0f, 0.0f,
-        1.0f, 1.0f,
-        0.0f, 1.0f
-        };
-
-        glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, ball_vertices);
-        glEnableVertexAttribArray(g_shader_program.get_position_attribute());
-
-        glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, ball_texture_coordinates);
-        glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
-
-        switch (g_balls_number) {
-        case oneBall:
-            draw_object(g_ball_model_matrix, g_ball_texture_id);
-            break;
-        case twoBalls:
-            draw_object(g_ball_model_matrix, g_ball_texture_id);
-            draw_object(g_ball2_model_matrix, g_ball_texture_id);
-            break;
-        case threeBalls:
-            draw_object(g_ball_model_matrix, g_ball_texture_id);
-            draw_object(g_ball2_model_matrix, g_ball_texture_id);
-            draw_object(g_ball3_model_matrix, g_ball_texture_id);
-            break;
+        const AtlasRegion& paddle = g_atlas.get_region(g_paddle_sprite);
+        const AtlasRegion& ball = g_atlas.get_region(g_ball_sprite);
+
+        //the paddles and balls share an atlas page, so the whole court is a single draw
+        if (paddle.texture_id == ball.texture_id) {
+            SpriteInstance* sprites = list->draw_sprites(paddle.texture_id, 2 + g_balls.get_count());
+            sprites[0] = make_sprite(paddle, g_player_draw_position, model_width, model_height);
+            sprites[1] = make_sprite(paddle, g_player2_draw_position, model_width, model_height);
+            g_balls.write_sprites(sprites + 2, ball, g_draw_rot_angle, g_timestep.get_alpha());
+        }
+        else {
+            SpriteInstance* paddles = list->draw_sprites(paddle.texture_id, 2);
+            paddles[0] = make_sprite(paddle, g_player_draw_position, model_width, model_height);
+            paddles[1] = make_sprite(paddle, g_player2_draw_position, model_width, model_height);
+            g_balls.write_sprites(list->draw_sprites(ball.texture_id, g_balls.get_count()), ball, g_draw_rot_angle, g_timestep.get_alpha());
         }
     }
     else {
@@ -512,7 +528,7 @@ void render() {
             model_width / 2.0f, model_height / 2.0f,
             -model_width / 2.0f, model_height / 2.0f
         };
-        float texture_coordinates[] = {
+        float sprite_coordinates[] = {
             0.0f, 1.0f,
             1.0f, 1.0f,
             1.0f, 0.0f,
@@ -520,34 +536,116 @@ void render() {
             1.0f, 0.0f,
             0.0f, 0.0f
         };
+        const AtlasRegion& over = g_atlas.get_region(g_player1_wins ? g_over_sprite : g_over2_sprite);
+        float texture_coordinates[12];
+        over.map(sprite_coordinates, texture_coordinates, 6);
 
+        list->draw_quad(glm::mat4(1.0f), over.texture_id, vertices, texture_coordinates);
+    }
 
-        glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-        glEnableVertexAttribArray(g_shader_program.get_position_attribute());
+    //the render stats in the top-left corner, over everything else
+    if (g_stats_overlay.is_visible()) {
+        list->draw_quad(g_stats_overlay.get_model_matrix(-5.0f, 3.75f, STATS_OVERLAY_UNITS_PER_TEXEL), g_stats_overlay.get_texture_id());
+    }
+}
 
-        glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, texture_coordinates);
-        glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+void execute_commands(const CommandList& list)
+{
+    PROFILE_SCOPE("execute_commands");
+    PROFILE_GPU_SCOPE("execute_commands");
 
-        glm::mat4 origin_pos = glm::mat4(1.0f);
+    if (g_gl_backend != NULL) g_stats_overlay.update(g_render_stats.get_last_frame());
 
-        if (g_player1_wins) {
-            draw_object(origin_pos, g_over_texture_id);
-        }
-        else {
-            draw_object(origin_pos, g_over2_texture_id);
+    g_render_backend->execute(list);
+
+    if (g_gl_backend != NULL) g_stream_buffer.end_frame();
+    g_render_stats.end_frame();
+}
+
+//picks what recorded frames are executed on; GL only when there is a context
+void start_render_backend(RendererType renderer, const char* record_path, bool has_context)
+{
+    g_render_backend = NULL;
+    if (renderer == RENDERER_NULL) {
+        g_render_backend = &g_null_backend;
+    }
+    else if (has_context) {
+        //without GL 3.3 the sprite batches are expanded into the stream buffer instead
+        g_gl_backend = new GLRenderBackend(&g_shader_program, g_instanced_renderer.is_supported() ? &g_instanced_renderer : NULL, &g_stream_buffer);
+        g_render_backend = g_gl_backend;
+    }
+
+    if (record_path != NULL) {
+        g_command_recorder = new RecordingRenderBackend(g_render_backend);
+        if (g_command_recorder->start(record_path)) g_render_backend = g_command_recorder;
+    }
+}
+
+//draws a recorded command stream back in the window, with no simulation behind it
+void run_command_playback(CommandStreamReader* reader)
+{
+    while (g_game_is_running and reader->next(&g_command_list)) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT or (event.type == SDL_KEYDOWN and event.key.keysym.sym == SDLK_q)) g_game_is_running = false;
         }
-        
 
+        execute_commands(g_command_list);
+        present();
+        g_profiler.end_frame();
+        g_frame_recorder.end_frame(g_frame_pacer.is_hidden());
+        g_frame_pacer.wait(g_display_window);
+    }
+    LOG("Played back " << reader->get_frame() << " of " << reader->get_frame_count() << " recorded frames");
+}
+
+//everything the simulation decides, for telling whether two replays ended the same way
+unsigned int hash_game_state()
+{
+    StateHash hash;
+    hash.add(g_player_position);
+    hash.add(g_player2_position);
+    hash.add(g_ball_speed);
+    for (int i = 0; i < g_balls.get_count(); i++) hash.add(g_balls.get_position(i));
+    hash.add(g_gameover);
+    hash.add(g_player1_wins);
+    hash.add(g_singleplayer);
+    return hash.get();
+}
 
+//no window and no GL: each frame is one tick of the recording, run as fast as it will go
+void run_replay()
+{
+    g_timestep.start(g_input_replay.get_step());
+
+    InputActions held, pressed;
+    while (g_game_is_running and g_input_replay.next(&held, &pressed)) {
+        apply_actions(held, pressed);
+        update(g_timestep.advance(g_timestep.get_step()));
+        //with --renderer null or --record-commands the frame is recorded too, so its CPU cost is part of the run
+        if (g_render_backend != NULL) {
+            record_frame(&g_command_list);
+            execute_commands(g_command_list);
+        }
+        g_profiler.end_frame();
+        g_frame_recorder.end_frame();
     }
-    // We disable two attribute arrays now
-    glDisableVertexAttribArray(g_shader_program.get_position_attribute());
-    glDisableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
-    SDL_GL_SwapWindow(g_display_window);
+
+    LOG("Replayed " << g_input_replay.get_tick() << " ticks | balls " << g_balls.get_count()
+        << " | state hash " << std::hex << hash_game_state() << std::dec);
 }
 
 void shutdown()
 {
+    //a replay of the recording should end on the same hash
+    if (g_input_recorder.is_recording()) LOG("State hash " << std::hex << hash_game_state() << std::dec);
+    g_input_recorder.stop();
+    delete g_net_session;
+    if (g_command_recorder != NULL) g_command_recorder->stop();
+    if (g_render_backend != NULL) g_render_backend->print_summary();
+    if (g_frame_report_path != NULL) g_frame_recorder.write_report(g_frame_report_path);
+    g_frame_recorder.print_summary();
+    g_profiler.stop();
     SDL_Quit();
 }
 
@@ -562,13 +660,91 @@ int main(int argc, char* argv[])
 * Academic Misconduct.
 **/
 {
+    if (argc >= 6 and strcmp(argv[1], "--net") == 0 and !start_netplay(argc, argv)) {
+        LOG("Unable to start netplay");
+        return 1;
+    }
+
+    SwapMode swap_mode = SWAP_VSYNC;
+    float target_fps = 0.0f;   //0 = as fast as the swap mode allows
+    parse_frame_pacing_arguments(argc, argv, &swap_mode, &target_fps);
+
+    //--trace FILE writes a Chrome trace of the whole run at exit
+    g_profiler.start(parse_trace_argument(argc, argv));
+    g_profiler.set_thread_name("Main");
+
+    //--render-stats FILE logs every frame's GL workload as CSV
+    const char* render_stats_path = NULL;
+    bool stats_overlay = false;
+    parse_render_stats_arguments(argc, argv, &render_stats_path, &stats_overlay);
+    if (render_stats_path != NULL) g_render_stats.open_csv(render_stats_path);
+    g_stats_overlay.set_visible(stats_overlay);
+
+    //--frame-report FILE writes the frame time report at exit; --hitch-ms N moves the hitch budget
+    float hitch_budget_ms = FRAME_HITCH_BUDGET_MS;
+    parse_frame_report_arguments(argc, argv, &g_frame_report_path, &hitch_budget_ms);
+
+    //--record FILE logs the input of every tick; --replay FILE plays one back headless
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    parse_input_recording_arguments(argc, argv, &record_path, &replay_path);
+
+    //--renderer null counts frames instead of drawing them; --record-commands FILE writes
+    //every frame's commands, --replay-commands FILE draws them back
+    RendererType renderer = RENDERER_GL;
+    const char* command_record_path = NULL;
+    const char* command_replay_path = NULL;
+    parse_render_backend_arguments(argc, argv, &renderer, &command_record_path, &command_replay_path);
+
+    if (replay_path != NULL) {
+        if (!g_input_replay.load(replay_path)) return 1;
+        //stress mode places its balls with rand(), so it has to start where the recording did
+        srand(g_input_replay.get_seed());
+        add_sprites();
+        start_render_backend(renderer, command_record_path, false);
+        g_frame_recorder.start(hitch_budget_ms);
+        run_replay();
+        shutdown();
+        return 0;
+    }
+
     initialise();
+    g_profiler.start_gpu();
+    g_frame_pacer.start(swap_mode, target_fps);
+    //netplay peers have to agree on the step, so it's the session's
+    if (g_net_session != NULL) g_timestep.start(NET_FRAME_TIME, NET_MAX_STEPS);
+    else g_timestep.start();
+    g_frame_recorder.start(hitch_budget_ms);
+
+    if (record_path != NULL and g_net_session != NULL) {
+        LOG("Netplay can't be recorded, the other player's input isn't ours to replay");
+    }
+    else if (record_path != NULL) {
+        unsigned int seed = (unsigned int)SDL_GetPerformanceCounter();
+        srand(seed);
+        g_input_recorder.start(record_path, seed, g_timestep.get_step());
+    }
+
+    start_render_backend(renderer, command_record_path, true);
+
+    if (command_replay_path != NULL) {
+        //the atlas was just built from the same sprites in the same order, so its pages have the same names
+        CommandStreamReader reader;
+        if (reader.open(command_replay_path)) run_command_playback(&reader);
+        shutdown();
+        return 0;
+    }
 
     while (g_game_is_running)
     {
         process_input();
-        update();
-        render();
+        update(g_timestep.advance());
+        record_frame(&g_command_list);
+        execute_commands(g_command_list);
+        present();
+        g_profiler.end_frame();
+        g_frame_recorder.end_frame(g_frame_pacer.is_hidden());
+        g_frame_pacer.wait(g_display_window);
     }
 
     shutdown();
@@ -0,0 +1,30 @@
+#version 330
+
+in vec2 position;
+in vec2 texCoord;
+
+// Per instance
+in vec2 instanceOffset;
+in float instanceRotation;
+in vec2 instanceScale;
+in vec4 instanceUV;        // u, v, width, height
+in vec4 instanceTint;
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+
+out vec2 texCoordVar;
+out vec4 tintVar;
+
+void main()
+{
+    // Scale, rotate, translate: what modelMatrix used to do, built here instead
+    float c = cos(instanceRotation);
+    float s = sin(instanceRotation);
+    vec2 scaled = position * instanceScale;
+    vec2 world = vec2(scaled.x * c - scaled.y * s, scaled.x * s + scaled.y * c) + instanceOffset;
+
+    texCoordVar = instanceUV.xy + texCoord * instanceUV.zw;
+    tintVar = instanceTint;
+    gl_Position = projectionMatrix * viewMatrix * vec4(world, 0.0, 1.0);
+}
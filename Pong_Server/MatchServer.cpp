@@ -0,0 +1,344 @@
+#include "MatchServer.h"
+#include <chrono>
+#include <iostream>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+const int RECEIVE_BATCH = 64;
+const int SEND_BATCH = 256;
+const int SOCKET_BUFFER_BYTES = 8 * 1024 * 1024;
+
+static unsigned long long thread_cpu_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (unsigned long long) now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static void store_max(std::atomic<unsigned long long>& target, unsigned long long value)
+{
+    unsigned long long current = target.load();
+    while (value > current && !target.compare_exchange_weak(current, value)) {}
+}
+
+MatchServer::~MatchServer()
+{
+    stop();
+    for (auto& worker : m_workers)
+    {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+    if (m_epoll != -1) close(m_epoll);
+    if (m_socket != -1) close(m_socket);
+}
+
+bool MatchServer::open(const ServerSettings& settings)
+{
+    m_settings = settings;
+
+    m_socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+    if (m_socket == -1)
+    {
+        std::cout << "Unable to create UDP socket" << std::endl;
+        return false;
+    }
+
+    // Thousands of matches send in bursts every tick; the default buffers overflow
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &SOCKET_BUFFER_BYTES, sizeof(SOCKET_BUFFER_BYTES));
+    setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, &SOCKET_BUFFER_BYTES, sizeof(SOCKET_BUFFER_BYTES));
+
+    sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(settings.port);
+
+    if (bind(m_socket, (sockaddr*) &local, sizeof(local)) != 0)
+    {
+        std::cout << "Unable to bind UDP port " << settings.port << std::endl;
+        return false;
+    }
+
+    m_epoll = epoll_create1(0);
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = m_socket;
+    if (m_epoll == -1 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_socket, &event) != 0)
+    {
+        std::cout << "Unable to set up epoll" << std::endl;
+        return false;
+    }
+
+    int matches_per_worker = (settings.max_matches + settings.workers - 1) / settings.workers;
+    for (int i = 0; i < settings.workers; i++)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->index = i;
+        worker->matches.resize(matches_per_worker);
+        memset(worker->matches.data(), 0, worker->matches.size() * sizeof(Match));
+        m_workers.push_back(std::move(worker));
+    }
+
+    std::cout << "Listening on port " << settings.port
+        << " | " << settings.workers << " workers at " << settings.tick_rate << " Hz"
+        << " | " << settings.max_matches << " match slots x " << sizeof(Match) << " bytes = "
+        << (settings.max_matches * sizeof(Match)) / 1024 << " KiB" << std::endl;
+    return true;
+}
+
+void MatchServer::run()
+{
+    m_running = true;
+    for (auto& worker : m_workers)
+    {
+        Worker* raw = worker.get();
+        worker->thread = std::thread([this, raw]() { run_worker(raw); });
+    }
+
+    std::chrono::steady_clock::time_point last_report = std::chrono::steady_clock::now();
+    epoll_event events[4];
+
+    while (m_running)
+    {
+        int ready = epoll_wait(m_epoll, events, 4, 100);
+        if (ready > 0) receive_packets();
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - last_report).count();
+        if (elapsed >= m_settings.report_interval)
+        {
+            report(elapsed);
+            last_report = now;
+        }
+    }
+
+    for (auto& worker : m_workers)
+    {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+void MatchServer::receive_packets()
+{
+    InputPacket packets[RECEIVE_BATCH];
+    sockaddr_in addresses[RECEIVE_BATCH];
+    iovec buffers[RECEIVE_BATCH];
+    mmsghdr messages[RECEIVE_BATCH];
+
+    for (int i = 0; i < RECEIVE_BATCH; i++)
+    {
+        buffers[i].iov_base = &packets[i];
+        buffers[i].iov_len = sizeof(InputPacket);
+    }
+
+    // Drain the socket; recvmmsg pulls a whole batch per system call
+    while (true)
+    {
+        memset(messages, 0, sizeof(messages));
+        for (int i = 0; i < RECEIVE_BATCH; i++)
+        {
+            messages[i].msg_hdr.msg_iov = &buffers[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+
+        int count = recvmmsg(m_socket, messages, RECEIVE_BATCH, MSG_DONTWAIT, NULL);
+        if (count <= 0) return;
+
+        for (int i = 0; i < count; i++)
+        {
+            const InputPacket& packet = packets[i];
+            if (messages[i].msg_len != sizeof(InputPacket) || packet.magic != INPUT_PACKET_MAGIC
+                || packet.match_id >= (unsigned int) m_settings.max_matches || packet.player > 1)
+            {
+                m_packets_rejected++;
+                continue;
+            }
+
+            Worker* worker = m_workers[packet.match_id % m_workers.size()].get();
+            ReceivedInput received;
+            received.packet = packet;
+            received.from = addresses[i];
+
+            std::lock_guard<std::mutex> lock(worker->inbox_mutex);
+            worker->inbox.push_back(received);
+        }
+        m_packets_in += count;
+
+        if (count < RECEIVE_BATCH) return;
+    }
+}
+
+void MatchServer::run_worker(Worker* worker)
+{
+    const std::chrono::nanoseconds period(1000000000ll / m_settings.tick_rate);
+    std::chrono::steady_clock::time_point next_tick = std::chrono::steady_clock::now();
+    unsigned long long tick = 0;
+
+    while (m_running)
+    {
+        std::this_thread::sleep_until(next_tick);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        unsigned long long cpu_start = thread_cpu_ns();
+
+        tick_worker(worker, tick++);
+
+        unsigned long long tick_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        worker->ticks++;
+        worker->tick_ns += tick_ns;
+        worker->cpu_ns += thread_cpu_ns() - cpu_start;
+        store_max(worker->max_tick_ns, tick_ns);
+
+        // Fixed rate: the schedule doesn't drift, and a late tick is counted
+        // rather than followed by a burst of catch-up ticks
+        next_tick += period;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now > next_tick)
+        {
+            worker->late_ticks++;
+            next_tick = now;
+        }
+    }
+}
+
+void MatchServer::tick_worker(Worker* worker, unsigned long long tick)
+{
+    const int worker_count = (int) m_workers.size();
+    const float delta_time = 1.0f / m_settings.tick_rate;
+    const int idle_ticks = (int) (m_settings.idle_timeout * m_settings.tick_rate);
+
+    {
+        std::lock_guard<std::mutex> lock(worker->inbox_mutex);
+        worker->processing.swap(worker->inbox);
+    }
+
+    // Latest input wins; it stays held until the client sends a different one
+    for (const ReceivedInput& received : worker->processing)
+    {
+        Match& match = worker->matches[received.packet.match_id / worker_count];
+        int player = received.packet.player;
+
+        if (!match.active)
+        {
+            memset(&match, 0, sizeof(match));
+            pong_reset(match.state, 1);
+            match.active = 1;
+        }
+
+        match.players[player] = received.from;
+        match.inputs[player] = received.packet.input;
+        if (received.packet.client_time_us > match.echo_time_us[player]) match.echo_time_us[player] = received.packet.client_time_us;
+        match.connected |= 1 << player;
+        match.idle_ticks = 0;
+    }
+    worker->processing.clear();
+
+    bool send_state = tick % m_settings.snapshot_interval == 0;
+    StatePacket states[SEND_BATCH];
+    iovec buffers[SEND_BATCH];
+    mmsghdr messages[SEND_BATCH];
+    int queued = 0;
+    int active = 0;
+
+    for (size_t slot = 0; slot < worker->matches.size(); slot++)
+    {
+        Match& match = worker->matches[slot];
+        if (!match.active) continue;
+
+        if (++match.idle_ticks > idle_ticks)
+        {
+            match.active = 0;
+            continue;
+        }
+        active++;
+
+        pong_simulate(match.state, match.inputs[0], match.inputs[1], delta_time);
+        if (match.state.result != pongPlaying) pong_reset(match.state, 1);
+
+        if (!send_state) continue;
+
+        for (int player = 0; player < 2; player++)
+        {
+            if (!(match.connected & (1 << player))) continue;
+
+            StatePacket& state = states[queued];
+            state.magic = STATE_PACKET_MAGIC;
+            state.match_id = (unsigned int) (slot * worker_count + worker->index);
+            state.frame = match.state.frame;
+            state.ball_count = match.state.ball_count;
+            state.result = match.state.result;
+            state.padding = 0;
+            state.echo_time_us = match.echo_time_us[player];
+            memcpy(state.paddle_y, match.state.paddle_y, sizeof(state.paddle_y));
+            memcpy(state.ball_x, match.state.ball_x, sizeof(state.ball_x));
+            memcpy(state.ball_y, match.state.ball_y, sizeof(state.ball_y));
+
+            buffers[queued].iov_base = &state;
+            buffers[queued].iov_len = sizeof(StatePacket);
+            memset(&messages[queued], 0, sizeof(mmsghdr));
+            messages[queued].msg_hdr.msg_iov = &buffers[queued];
+            messages[queued].msg_hdr.msg_iovlen = 1;
+            messages[queued].msg_hdr.msg_name = &match.players[player];
+            messages[queued].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+
+            if (++queued == SEND_BATCH)
+            {
+                // Sending on one UDP socket from several threads is safe
+                int sent = sendmmsg(m_socket, messages, queued, MSG_DONTWAIT);
+                if (sent > 0) worker->packets_out += sent;
+                queued = 0;
+            }
+        }
+    }
+
+    if (queued > 0)
+    {
+        int sent = sendmmsg(m_socket, messages, queued, MSG_DONTWAIT);
+        if (sent > 0) worker->packets_out += sent;
+    }
+
+    worker->active_matches = active;
+    worker->match_ticks += active;
+}
+
+void MatchServer::report(double seconds)
+{
+    unsigned long long ticks = 0, late_ticks = 0, tick_ns = 0, max_tick_ns = 0, cpu_ns = 0, match_ticks = 0, packets_out = 0;
+    int active = 0;
+
+    for (auto& worker : m_workers)
+    {
+        ticks += worker->ticks.exchange(0);
+        late_ticks += worker->late_ticks.exchange(0);
+        tick_ns += worker->tick_ns.exchange(0);
+        cpu_ns += worker->cpu_ns.exchange(0);
+        match_ticks += worker->match_ticks.exchange(0);
+        packets_out += worker->packets_out.exchange(0);
+        unsigned long long worker_max = worker->max_tick_ns.exchange(0);
+        if (worker_max > max_tick_ns) max_tick_ns = worker_max;
+        active += worker->active_matches;
+    }
+
+    double average_tick_ms = ticks > 0 ? tick_ns / 1e6 / ticks : 0.0;
+    double cpu_per_match_us = match_ticks > 0 ? cpu_ns / 1e3 / match_ticks : 0.0;
+
+    std::cout << "matches " << active
+        << " | tick avg " << average_tick_ms << " ms max " << max_tick_ns / 1e6 << " ms"
+        << " | late " << late_ticks
+        << " | cpu/match/tick " << cpu_per_match_us << " us"
+        << " | cpu " << cpu_ns / 1e7 / seconds << "%"
+        << " | in " << (unsigned long long) (m_packets_in / seconds) << "/s"
+        << " out " << (unsigned long long) (packets_out / seconds) << "/s"
+        << " rejected " << m_packets_rejected
+        << std::endl;
+
+    m_packets_in = 0;
+}
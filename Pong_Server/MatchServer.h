@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include "ServerProtocol.h"
+
+struct ServerSettings
+{
+    unsigned short port = 7777;
+    int   workers = 4;
+    int   tick_rate = 60;
+    int   max_matches = 10000;
+    int   snapshot_interval = 3;     // send state every this many ticks
+    float idle_timeout = 10.0f;      // seconds without input before a match is closed
+    float report_interval = 2.0f;    // seconds between stats lines
+};
+
+// Everything the server keeps per match. Kept small on purpose: 10k of these
+// are only about a megabyte.
+struct Match
+{
+    PongState          state;
+    sockaddr_in        players[2];
+    unsigned long long echo_time_us[2];
+    PongInput          inputs[2];
+    unsigned char      active;
+    unsigned char      connected;     // bit per player that has sent anything
+    int                idle_ticks;
+};
+
+struct ReceivedInput
+{
+    InputPacket packet;
+    sockaddr_in from;
+};
+
+// Headless authoritative Pong server. Matches are sharded across worker threads
+// by id (id % workers), each worker ticks its own matches on a fixed-rate
+// schedule, and a single epoll loop on the calling thread reads the UDP socket
+// and hands inputs to the worker that owns the match.
+class MatchServer
+{
+private:
+    struct Worker
+    {
+        int index;
+        std::vector<Match> matches;              // local slot = match id / worker count
+        std::mutex inbox_mutex;
+        std::vector<ReceivedInput> inbox;        // filled by the front end
+        std::vector<ReceivedInput> processing;   // swapped with inbox at the start of a tick
+        std::thread thread;
+
+        // ————— STATS ————— //
+        // Read and reset by the reporter, so everything is atomic
+        std::atomic<unsigned long long> ticks{0};
+        std::atomic<unsigned long long> late_ticks{0};
+        std::atomic<unsigned long long> tick_ns{0};
+        std::atomic<unsigned long long> max_tick_ns{0};
+        std::atomic<unsigned long long> cpu_ns{0};
+        std::atomic<unsigned long long> match_ticks{0};
+        std::atomic<unsigned long long> packets_out{0};
+        std::atomic<int> active_matches{0};
+    };
+
+    ServerSettings m_settings;
+    int m_socket = -1;
+    int m_epoll = -1;
+    std::atomic<bool> m_running{false};
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    unsigned long long m_packets_in = 0;
+    unsigned long long m_packets_rejected = 0;
+
+    void run_worker(Worker* worker);
+    void tick_worker(Worker* worker, unsigned long long tick);
+    void receive_packets();
+    void report(double seconds);
+
+public:
+    ~MatchServer();
+
+    bool open(const ServerSettings& settings);
+    // Runs until stop() is called (e.g. from a signal handler)
+    void run();
+    void stop() { m_running = false; };
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include "PongState.h"
+
+// Wire format shared by the match server and the load client. Packets are sent
+// as raw structs, so both ends have to be built for the same architecture.
+
+const unsigned int INPUT_PACKET_MAGIC = 0x50534931; // "PSI1"
+const unsigned int STATE_PACKET_MAGIC = 0x50535331; // "PSS1"
+
+struct InputPacket
+{
+    unsigned int       magic;
+    unsigned int       match_id;
+    unsigned char      player;        // 0 or 1
+    PongInput          input;
+    unsigned short     padding;
+    unsigned long long client_time_us; // echoed back in the next state packet
+};
+
+struct StatePacket
+{
+    unsigned int       magic;
+    unsigned int       match_id;
+    int                frame;
+    unsigned char      ball_count;
+    unsigned char      result;
+    unsigned short     padding;
+    unsigned long long echo_time_us;   // newest client_time_us the server has seen for this player
+    float              paddle_y[2];
+    float              ball_x[MAX_PONG_BALLS];
+    float              ball_y[MAX_PONG_BALLS];
+};
@@ -0,0 +1,250 @@
+// Load generator for pong_server: plays both sides of many matches from a
+// handful of sockets and measures round trip from input to the state packet
+// that echoes it.
+#include "ServerProtocol.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define LOG(argument) std::cout << argument << '\n'
+
+const int BATCH = 256;
+
+struct ClientSettings
+{
+    const char* host = "127.0.0.1";
+    unsigned short port = 7777;
+    int   matches = 1000;
+    int   sockets = 8;
+    int   rate = 30;               // inputs per second per player
+    float seconds = 10.0f;
+    float report_interval = 2.0f;
+};
+
+static unsigned long long now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double percentile(std::vector<unsigned long long>& samples, double fraction)
+{
+    if (samples.empty()) return 0.0;
+    size_t index = (size_t) (fraction * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index] / 1000.0;
+}
+
+static void print_line(const char* label, double seconds, unsigned long long sent, unsigned long long received, std::vector<unsigned long long>& rtts)
+{
+    unsigned long long max_rtt = rtts.empty() ? 0 : *std::max_element(rtts.begin(), rtts.end());
+    double p50 = percentile(rtts, 0.50);
+    double p99 = percentile(rtts, 0.99);
+
+    LOG(label << " sent " << (unsigned long long) (sent / seconds) << "/s"
+        << " | received " << (unsigned long long) (received / seconds) << "/s"
+        << " | rtt p50 " << p50 << " ms p99 " << p99 << " ms max " << max_rtt / 1000.0 << " ms");
+}
+
+static void send_inputs(int socket_handle, const sockaddr_in& server, const std::vector<int>& matches, unsigned long long tick, unsigned long long& sent)
+{
+    InputPacket packets[BATCH];
+    iovec buffers[BATCH];
+    mmsghdr messages[BATCH];
+    int queued = 0;
+    unsigned long long time = now_us();
+
+    for (size_t i = 0; i < matches.size(); i++)
+    {
+        for (int player = 0; player < 2; player++)
+        {
+            // Hold each direction for a while, differently per match and player
+            int phase = (int) ((tick / 20 + matches[i] + player) % 3);
+
+            InputPacket& packet = packets[queued];
+            packet.magic = INPUT_PACKET_MAGIC;
+            packet.match_id = (unsigned int) matches[i];
+            packet.player = (unsigned char) player;
+            packet.input = phase == 0 ? PONG_INPUT_UP : phase == 1 ? PONG_INPUT_DOWN : 0;
+            packet.padding = 0;
+            packet.client_time_us = time;
+
+            buffers[queued].iov_base = &packet;
+            buffers[queued].iov_len = sizeof(InputPacket);
+            memset(&messages[queued], 0, sizeof(mmsghdr));
+            messages[queued].msg_hdr.msg_iov = &buffers[queued];
+            messages[queued].msg_hdr.msg_iovlen = 1;
+            messages[queued].msg_hdr.msg_name = (void*) &server;
+            messages[queued].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+
+            if (++queued == BATCH)
+            {
+                int result = sendmmsg(socket_handle, messages, queued, 0);
+                if (result > 0) sent += result;
+                queued = 0;
+            }
+        }
+    }
+
+    if (queued > 0)
+    {
+        int result = sendmmsg(socket_handle, messages, queued, 0);
+        if (result > 0) sent += result;
+    }
+}
+
+static void receive_states(int socket_handle, unsigned long long& received, std::vector<unsigned long long>& rtts)
+{
+    StatePacket packets[BATCH];
+    iovec buffers[BATCH];
+    mmsghdr messages[BATCH];
+
+    while (true)
+    {
+        memset(messages, 0, sizeof(messages));
+        for (int i = 0; i < BATCH; i++)
+        {
+            buffers[i].iov_base = &packets[i];
+            buffers[i].iov_len = sizeof(StatePacket);
+            messages[i].msg_hdr.msg_iov = &buffers[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int count = recvmmsg(socket_handle, messages, BATCH, MSG_DONTWAIT, NULL);
+        if (count <= 0) return;
+
+        unsigned long long time = now_us();
+        for (int i = 0; i < count; i++)
+        {
+            if (messages[i].msg_len != sizeof(StatePacket) || packets[i].magic != STATE_PACKET_MAGIC) continue;
+            received++;
+            if (packets[i].echo_time_us > 0 && packets[i].echo_time_us <= time) rtts.push_back(time - packets[i].echo_time_us);
+        }
+
+        if (count < BATCH) return;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ClientSettings settings;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--host") == 0) settings.host = argv[i + 1];
+        else if (strcmp(argv[i], "--port") == 0) settings.port = (unsigned short) atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--matches") == 0) settings.matches = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--sockets") == 0) settings.sockets = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--rate") == 0) settings.rate = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seconds") == 0) settings.seconds = (float) atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--report-interval") == 0) settings.report_interval = (float) atof(argv[i + 1]);
+        else
+        {
+            LOG("usage: pong_load_client [--host H] [--port N] [--matches N] [--sockets N] [--rate HZ] [--seconds S] [--report-interval S]");
+            return 1;
+        }
+    }
+    if (settings.sockets < 1 || settings.rate < 1 || settings.matches < 1)
+    {
+        LOG("--sockets, --rate and --matches must be positive");
+        return 1;
+    }
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* resolved = NULL;
+    if (getaddrinfo(settings.host, NULL, &hints, &resolved) != 0 || resolved == NULL)
+    {
+        LOG("Unable to resolve " << settings.host);
+        return 1;
+    }
+    sockaddr_in server = *(sockaddr_in*) resolved->ai_addr;
+    server.sin_port = htons(settings.port);
+    freeaddrinfo(resolved);
+
+    int epoll = epoll_create1(0);
+    std::vector<int> sockets;
+    std::vector<std::vector<int>> matches_per_socket(settings.sockets);
+    int buffer_bytes = 8 * 1024 * 1024;
+
+    for (int i = 0; i < settings.sockets; i++)
+    {
+        int handle = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+        setsockopt(handle, SOL_SOCKET, SO_RCVBUF, &buffer_bytes, sizeof(buffer_bytes));
+        setsockopt(handle, SOL_SOCKET, SO_SNDBUF, &buffer_bytes, sizeof(buffer_bytes));
+
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u32 = (unsigned int) i;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, handle, &event);
+        sockets.push_back(handle);
+    }
+    for (int match = 0; match < settings.matches; match++)
+    {
+        matches_per_socket[match % settings.sockets].push_back(match);
+    }
+
+    LOG("Driving " << settings.matches << " matches (" << settings.matches * 2 << " players) at "
+        << settings.rate << " Hz over " << settings.sockets << " sockets for " << settings.seconds << " s");
+
+    const unsigned long long period_us = 1000000ull / settings.rate;
+    unsigned long long start = now_us();
+    unsigned long long end = start + (unsigned long long) (settings.seconds * 1e6);
+    unsigned long long next_send = start;
+    unsigned long long last_report = start;
+    unsigned long long tick = 0;
+
+    unsigned long long sent = 0, received = 0, total_sent = 0, total_received = 0;
+    std::vector<unsigned long long> rtts, all_rtts;
+    epoll_event events[64];
+
+    while (true)
+    {
+        unsigned long long now = now_us();
+        if (now >= end) break;
+
+        if (now >= next_send)
+        {
+            for (int i = 0; i < settings.sockets; i++) send_inputs(sockets[i], server, matches_per_socket[i], tick, sent);
+            tick++;
+            next_send += period_us;
+            if (next_send < now) next_send = now + period_us;
+        }
+
+        int timeout_ms = next_send > now ? (int) ((next_send - now) / 1000) : 0;
+        int ready = epoll_wait(epoll, events, 64, timeout_ms);
+        for (int i = 0; i < ready; i++) receive_states(sockets[events[i].data.u32], received, rtts);
+
+        now = now_us();
+        if (now - last_report >= (unsigned long long) (settings.report_interval * 1e6))
+        {
+            print_line("", (now - last_report) / 1e6, sent, received, rtts);
+            total_sent += sent;
+            total_received += received;
+            all_rtts.insert(all_rtts.end(), rtts.begin(), rtts.end());
+            sent = 0;
+            received = 0;
+            rtts.clear();
+            last_report = now;
+        }
+    }
+
+    total_sent += sent;
+    total_received += received;
+    all_rtts.insert(all_rtts.end(), rtts.begin(), rtts.end());
+    print_line("TOTAL", (now_us() - start) / 1e6, total_sent, total_received, all_rtts);
+
+    for (int handle : sockets) close(handle);
+    close(epoll);
+    return 0;
+}
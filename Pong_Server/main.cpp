@@ -0,0 +1,57 @@
+#include "MatchServer.h"
+#include <iostream>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG(argument) std::cout << argument << '\n'
+
+MatchServer g_server;
+
+void handle_signal(int)
+{
+    g_server.stop();
+}
+
+void print_usage()
+{
+    LOG("usage: pong_server [--port N] [--workers N] [--tick-rate HZ] [--max-matches N]");
+    LOG("                   [--snapshot-interval TICKS] [--idle-timeout SECONDS] [--report-interval SECONDS]");
+}
+
+int main(int argc, char* argv[])
+{
+    ServerSettings settings;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--help") == 0) { print_usage(); return 0; }
+        if (value == NULL) { print_usage(); return 1; }
+
+        if (strcmp(argv[i], "--port") == 0) settings.port = (unsigned short) atoi(value);
+        else if (strcmp(argv[i], "--workers") == 0) settings.workers = atoi(value);
+        else if (strcmp(argv[i], "--tick-rate") == 0) settings.tick_rate = atoi(value);
+        else if (strcmp(argv[i], "--max-matches") == 0) settings.max_matches = atoi(value);
+        else if (strcmp(argv[i], "--snapshot-interval") == 0) settings.snapshot_interval = atoi(value);
+        else if (strcmp(argv[i], "--idle-timeout") == 0) settings.idle_timeout = (float) atof(value);
+        else if (strcmp(argv[i], "--report-interval") == 0) settings.report_interval = (float) atof(value);
+        else { print_usage(); return 1; }
+        i++;
+    }
+
+    if (settings.workers < 1 || settings.tick_rate < 1 || settings.max_matches < 1 || settings.snapshot_interval < 1)
+    {
+        print_usage();
+        return 1;
+    }
+
+    if (!g_server.open(settings)) return 1;
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    g_server.run();
+    return 0;
+}
@@ -11,7 +11,9 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "SpriteSheet.h"
 #include "Entity.h"
+#include "RenderStats.h"
 #include <iostream>
 
 Entity::Entity()
@@ -25,42 +27,25 @@ Entity::~Entity()
     ;
 }
 
-void Entity::draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index)
+const float SPRITE_VERTICES[] =
 {
-    // Step 1: Calculate the UV location of the indexed frame
-    float u_coord = (float) (index % 6) / (float) 6;
-    float v_coord = (float) (index / 6) / (float) 1;
-    
-    // Step 2: Calculate its UV size
-    float width = 1.0f / (float) 6;
-    float height = 1.0f / (float) 1;
-    
-    // Step 3: Just as we have done before, match the texture coordinates to the vertices
-    float tex_coords[] =
-    {
-        u_coord, v_coord + height, u_coord + width, v_coord + height, u_coord + width, v_coord,
-        u_coord, v_coord + height, u_coord + width, v_coord, u_coord, v_coord
-    };
-    
-    float vertices[] =
-    {
-        -0.5, -0.5, 0.5, -0.5,  0.5, 0.5,
-        -0.5, -0.5, 0.5,  0.5, -0.5, 0.5
-    };
-    
-    // Step 4: And render
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    
-    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->get_position_attribute());
+    -0.5, -0.5, 0.5, -0.5,  0.5, 0.5,
+    -0.5, -0.5, 0.5,  0.5, -0.5, 0.5
+};
+
+typedef SpriteSheet<1, 1> IdleSheet;
+typedef SpriteSheet<6, 1> MovingSheet;   // six frames of movement
+
+void Entity::draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, const float* tex_coords)
+{
+    g_gl_state.bind_texture(texture_id);
     
+    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, SPRITE_VERTICES);
     glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
+    g_gl_state.set_attributes(program->get_attribute_mask());
     
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    glDisableVertexAttribArray(program->get_position_attribute());
-    glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
+    g_render_stats.count_client_draw(GL_TRIANGLES, 6, 4 * sizeof(float));
 }
 
 void Entity::update(float delta_time)
@@ -101,26 +86,12 @@ void Entity::render(ShaderProgram *program)
     
     if (m_accelerating)
     {
-        draw_sprite_from_texture_atlas(program, m_moving_texture_id, m_animation_index);
-        m_animation_index += 1;
+        draw_sprite_from_texture_atlas(program, m_moving_texture_id, MovingSheet::tex_coords(m_animation_index));
+        m_animation_index = (m_animation_index + 1) % MovingSheet::FRAME_COUNT;
         return;
     }
 
-    
-    float vertices[]   = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-    float tex_coords[] = {  0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
-    
-    glBindTexture(GL_TEXTURE_2D, m_idle_texture_id);
-    
-    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->get_position_attribute());
-    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
-    
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    glDisableVertexAttribArray(program->get_position_attribute());
-    glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
+    draw_sprite_from_texture_atlas(program, m_idle_texture_id, IdleSheet::tex_coords(0));
 }
 
 bool const Entity::check_collision(const glm::vec3& boxPosition) const {
@@ -32,7 +32,7 @@ public:
     Entity();
     ~Entity();
 
-    void draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index);
+    void draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, const float* tex_coords);
     void update(float delta_time);
     void render(ShaderProgram *program);
     
@@ -0,0 +1,138 @@
+#include "GLState.h"
+#include "RenderStats.h"
+#include <string.h>
+
+GLState g_gl_state;
+
+void GLState::use_program(GLuint program)
+{
+    if (program == m_program)
+    {
+        m_skipped++;
+        return;
+    }
+
+    glUseProgram(program);
+    m_program = program;
+    m_issued++;
+    g_render_stats.count_program_switch();
+}
+
+void GLState::bind_texture(GLuint texture, int unit)
+{
+    if (m_textures[unit] == texture)
+    {
+        m_skipped++;
+        return;
+    }
+
+    if (m_active_unit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        m_active_unit = unit;
+        m_issued++;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    m_textures[unit] = texture;
+    m_issued++;
+    g_render_stats.count_texture_bind();
+}
+
+void GLState::bind_vertex_array(GLuint vertex_array)
+{
+    if (vertex_array == m_vertex_array)
+    {
+        m_skipped++;
+        return;
+    }
+
+    glBindVertexArray(vertex_array);
+    m_vertex_array = vertex_array;
+    m_issued++;
+}
+
+void GLState::set_attributes(unsigned int mask)
+{
+    unsigned int changed = mask ^ m_attributes;
+    if (changed == 0)
+    {
+        m_skipped++;
+        return;
+    }
+
+    for (int location = 0; location < GL_STATE_ATTRIBUTES; location++)
+    {
+        unsigned int bit = 1u << location;
+        if (!(changed & bit)) continue;
+
+        if (mask & bit) glEnableVertexAttribArray(location);
+        else glDisableVertexAttribArray(location);
+        m_issued++;
+    }
+    m_attributes = mask;
+}
+
+void GLState::set_blend(bool enabled)
+{
+    if (enabled == m_blend)
+    {
+        m_skipped++;
+        return;
+    }
+
+    if (enabled) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+    m_blend = enabled;
+    m_issued++;
+}
+
+void GLState::set_blend_function(GLenum source, GLenum destination)
+{
+    if (source == m_blend_source && destination == m_blend_destination)
+    {
+        m_skipped++;
+        return;
+    }
+
+    glBlendFunc(source, destination);
+    m_blend_source = source;
+    m_blend_destination = destination;
+    m_issued++;
+}
+
+bool GLState::uniform_changed(void* cached, bool& cached_valid, const void* value, size_t bytes)
+{
+    if (cached_valid && memcmp(cached, value, bytes) == 0)
+    {
+        m_skipped++;
+        return false;
+    }
+
+    memcpy(cached, value, bytes);
+    cached_valid = true;
+    m_issued++;
+    g_render_stats.count_uniform_upload();
+    return true;
+}
+
+void GLState::forget()
+{
+    // Re-apply everything from scratch the next time it is asked for. The
+    // values below can't collide with real requests, so nothing gets skipped.
+    m_program = (GLuint) -1;
+    m_vertex_array = (GLuint) -1;
+    m_active_unit = -1;
+    for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++) m_textures[unit] = (GLuint) -1;
+    m_blend_source = GL_NONE;
+    m_blend_destination = GL_NONE;
+
+    // Attributes and blending are booleans, so put GL in the state the cache
+    // claims instead of inventing a third value
+    for (int location = 0; location < GL_STATE_ATTRIBUTES; location++)
+    {
+        if (m_attributes & (1u << location)) glEnableVertexAttribArray(location);
+        else glDisableVertexAttribArray(location);
+    }
+    if (m_blend) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+}
@@ -1,6 +1,9 @@
 #include "Map.h"
+#include "Profiler.h"
+#include "RenderStats.h"
 
 Map::Map(int width, int height, unsigned int *level_data, GLuint texture_id, float tile_size, int tile_count_x, int tile_count_y)
+    : m_tileset(tile_count_x, tile_count_y)
 {
     m_width = width;
     m_height = height;
@@ -17,6 +20,8 @@ Map::Map(int width, int height, unsigned int *level_data, GLuint texture_id, flo
 
 void Map::build()
 {
+    PROFILE_SCOPE("Map::build");
+    PROFILE_MARK("map rebuild", NULL);
     // Since this is a 2D map, we need a nested for-loop
     for(int y_coord = 0; y_coord < m_height; y_coord++)
     {
@@ -28,35 +33,24 @@ void Map::build()
             // If the tile number is 0 i.e. not solid, skip to the next one
             if (tile == 0) continue;
             
-            // Otherwise, calculate its UV-coordinated
-            float u_coord = (float) (tile % m_tile_count_x) / (float) m_tile_count_x;
-            float v_coord = (float) (tile / m_tile_count_x) / (float) m_tile_count_y;
-            
-            // And work out their dimensions and posititions
-            float tile_width = 1.0f/ (float)  m_tile_count_x;
-            float tile_height = 1.0f/ (float) m_tile_count_y;
-            
+            // Otherwise, work out its position
             float x_offset = -(m_tile_size / 2); // From center of tile
             float y_offset =  (m_tile_size / 2); // From center of tile
             
-            // So we can store them inside our std::vectors
+            float left   = x_offset + (m_tile_size * x_coord);
+            float right  = left + m_tile_size;
+            float top    = y_offset + (-m_tile_size * y_coord);
+            float bottom = top - m_tile_size;
+            
+            // So we can store them inside our std::vectors. The corners go in the
+            // tileset's quad order so its texture coordinates can be copied as is
             m_vertices.insert(m_vertices.end(), {
-                x_offset + (m_tile_size * x_coord),  y_offset +  -m_tile_size * y_coord,
-                x_offset + (m_tile_size * x_coord),  y_offset + (-m_tile_size * y_coord) - m_tile_size,
-                x_offset + (m_tile_size * x_coord) + m_tile_size, y_offset + (-m_tile_size * y_coord) - m_tile_size,
-                x_offset + (m_tile_size * x_coord), y_offset + -m_tile_size * y_coord,
-                x_offset + (m_tile_size * x_coord) + m_tile_size, y_offset + (-m_tile_size * y_coord) - m_tile_size,
-                x_offset + (m_tile_size * x_coord) + m_tile_size, y_offset +  -m_tile_size * y_coord
+                left, bottom, right, bottom, right, top,
+                left, bottom, right, top, left, top
             });
             
-            m_texture_coordinates.insert(m_texture_coordinates.end(), {
-                u_coord, v_coord,
-                u_coord, v_coord + (tile_height),
-                u_coord + tile_width, v_coord + (tile_height),
-                u_coord, v_coord,
-                u_coord + tile_width, v_coord + (tile_height),
-                u_coord + tile_width, v_coord
-            });
+            const float* tex_coords = m_tileset.tex_coords(tile);
+            m_texture_coordinates.insert(m_texture_coordinates.end(), tex_coords, tex_coords + SPRITE_QUAD_FLOATS);
         }
     }
     
@@ -72,18 +66,14 @@ void Map::render(ShaderProgram *program)
     glm::mat4 model_matrix = glm::mat4(1.0f);
     program->set_model_matrix(model_matrix);
     
-    glUseProgram(program->get_program_id());
-    
     glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, m_vertices.data());
-    glEnableVertexAttribArray(program->get_position_attribute());
     glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, m_texture_coordinates.data());
-    glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
+    g_gl_state.set_attributes(program->get_attribute_mask());
     
-    glBindTexture(GL_TEXTURE_2D, m_texture_id);
+    g_gl_state.bind_texture(m_texture_id);
     
     glDrawArrays(GL_TRIANGLES, 0, (int) m_vertices.size() / 2);
-    glDisableVertexAttribArray(program->get_position_attribute());
-    glDisableVertexAttribArray(program->get_position_attribute());
+    g_render_stats.count_client_draw(GL_TRIANGLES, (int) m_vertices.size() / 2, 4 * sizeof(float));
 }
 
 bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_y)
@@ -12,6 +12,7 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "SpriteSheet.h"
 
 class Map
 {
@@ -26,6 +27,7 @@ private:
     float m_tile_size;
     int   m_tile_count_x;
     int   m_tile_count_y;
+    RuntimeSpriteSheet m_tileset;   // UVs of every tile, worked out once
     
     // Just like with rendering text, we're rendering several sprites at once
     // So we need vectors to store their respective vertices and texture coordinates
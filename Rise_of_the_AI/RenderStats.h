@@ -0,0 +1,100 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include <atomic>
+#include <stdio.h>
+#include <vector>
+#include "glm/mat4x4.hpp"
+
+// What one frame asked of GL
+struct RenderFrameStats
+{
+    int    draw_calls = 0;
+    int    triangles = 0;
+    int    texture_binds = 0;
+    int    program_switches = 0;
+    int    uniform_uploads = 0;
+    size_t client_vertex_bytes = 0;     // attribute data the driver had to copy out of client memory
+};
+
+// Per-frame GL workload counters. Draw sites report what they submit; binds,
+// program switches and uniform uploads are counted where the call is really
+// made, so calls the state cache drops don't show. Only touched on the
+// thread that owns the context.
+class RenderStats
+{
+private:
+    RenderFrameStats m_current;
+    RenderFrameStats m_last;
+    int   m_frame = 0;
+    FILE* m_csv = NULL;
+
+public:
+    ~RenderStats() { close_csv(); };
+
+    void count_draw(GLenum mode, int vertex_count, int instance_count = 1);
+    // A draw whose attributes point into client memory rather than a buffer
+    void count_client_draw(GLenum mode, int vertex_count, size_t bytes_per_vertex);
+    void count_texture_bind()               { m_current.texture_binds++; };
+    void count_program_switch()             { m_current.program_switches++; };
+    void count_uniform_upload(int count = 1) { m_current.uniform_uploads += count; };
+
+    // After the frame's last draw: the frame becomes get_last_frame() and,
+    // when a CSV is open, a row of it
+    void end_frame();
+
+    bool open_csv(const char* path);
+    void close_csv();
+
+    const RenderFrameStats& get_current_frame() const { return m_current; };
+    const RenderFrameStats& get_last_frame()    const { return m_last; };
+    int  const get_frame() const { return m_frame; };
+};
+
+extern RenderStats g_render_stats;
+
+const int   RENDER_STATS_OVERLAY_COLUMNS = 20;
+const int   RENDER_STATS_OVERLAY_LINES = 6;
+const float RENDER_STATS_OVERLAY_REFRESH_SECONDS = 0.5f;   // any faster and the numbers can't be read
+
+// The counters as text on a small texture, redrawn with a built-in 5x7 font
+// a couple of times a second. The game draws it as one textured quad, so it
+// works on whatever draw path is active.
+class RenderStatsOverlay
+{
+private:
+    GLuint m_texture_id = 0;
+    int    m_width = 0;
+    int    m_height = 0;
+    std::vector<unsigned char> m_pixels;
+    Uint64 m_refresh_counts = 0;
+    std::atomic<bool> m_visible{false};
+
+    void draw_text(int column, int line, const char* text);
+
+public:
+    // Needs a current GL context
+    void create();
+    // On the GL thread, once a frame; only redraws every so often
+    void update(const RenderFrameStats& stats);
+
+    void set_visible(bool visible) { m_visible = visible; };
+    void toggle() { m_visible = !m_visible; };
+
+    // Places the texture's top-left corner at (left, top), one texel taking
+    // `units_per_texel` world units each way
+    glm::mat4 get_model_matrix(float left, float top, float units_per_texel) const;
+
+    bool   const is_visible()     const { return m_visible; };
+    GLuint const get_texture_id() const { return m_texture_id; };
+    int    const get_width()      const { return m_width; };
+    int    const get_height()     const { return m_height; };
+};
+
+// Reads --render-stats FILE (per-frame CSV) and --stats-overlay from the command line
+void parse_render_stats_arguments(int argc, char* argv[], const char** csv_path, bool* overlay);
@@ -0,0 +1,124 @@
+#pragma once
+#include <assert.h>
+#include <vector>
+
+const int SPRITE_QUAD_FLOATS = 12;  // 6 vertices, 2 components each
+
+// UV rectangle of one frame; v runs from the top of the image down
+struct SpriteFrame
+{
+    float u, v;
+    float width, height;
+};
+
+// A run of consecutive frames in a sheet, played in order
+struct AnimationClip
+{
+    int   first_frame;
+    int   frame_count;
+    float frames_per_second;
+};
+
+template <int Count>
+struct SpriteFrameTable
+{
+    SpriteFrame frames[Count];
+    float       tex_coords[Count * SPRITE_QUAD_FLOATS];
+};
+
+// Texture coordinates for a frame on the unit sprite quad, in the quad's vertex
+// order: bottom-left, bottom-right, top-right, bottom-left, top-right, top-left
+constexpr void write_sprite_quad(const SpriteFrame& frame, float* tex_coords)
+{
+    float left = frame.u, right = frame.u + frame.width;
+    float top = frame.v, bottom = frame.v + frame.height;
+    float quad[] = { left, bottom, right, bottom, right, top, left, bottom, right, top, left, top };
+    for (int i = 0; i < SPRITE_QUAD_FLOATS; i++) tex_coords[i] = quad[i];
+}
+
+template <int Cols, int Rows>
+constexpr SpriteFrameTable<Cols * Rows> make_sprite_frame_table()
+{
+    SpriteFrameTable<Cols * Rows> table = {};
+    for (int index = 0; index < Cols * Rows; index++)
+    {
+        SpriteFrame& frame = table.frames[index];
+        frame.u = (float) (index % Cols) / (float) Cols;
+        frame.v = (float) (index / Cols) / (float) Rows;
+        frame.width = (float) (index % Cols + 1) / (float) Cols - frame.u;
+        frame.height = (float) (index / Cols + 1) / (float) Rows - frame.v;
+        write_sprite_quad(frame, &table.tex_coords[index * SPRITE_QUAD_FLOATS]);
+    }
+    return table;
+}
+
+// A sheet of equally sized frames, left to right then top to bottom. Every
+// frame's UVs are worked out by the compiler, so drawing one is a table lookup
+// and frame numbers known at compile time are range checked.
+template <int Cols, int Rows>
+class SpriteSheet
+{
+    static_assert(Cols > 0 && Rows > 0, "a sprite sheet needs at least one column and one row");
+
+public:
+    static constexpr int FRAME_COUNT = Cols * Rows;
+    static constexpr SpriteFrameTable<Cols * Rows> TABLE = make_sprite_frame_table<Cols, Rows>();
+
+    static constexpr SpriteFrame frame(int index) { return TABLE.frames[index]; };
+
+    template <int Index>
+    static constexpr SpriteFrame frame()
+    {
+        static_assert(Index >= 0 && Index < FRAME_COUNT, "frame is outside the sprite sheet");
+        return TABLE.frames[Index];
+    };
+
+    // Points straight into the table, ready for glVertexAttribPointer
+    static const float* tex_coords(int index) { return &TABLE.tex_coords[index * SPRITE_QUAD_FLOATS]; };
+
+    template <int First, int Count>
+    static constexpr AnimationClip clip(float frames_per_second)
+    {
+        static_assert(First >= 0 && Count > 0 && First + Count <= FRAME_COUNT, "clip runs past the end of the sprite sheet");
+        return { First, Count, frames_per_second };
+    };
+};
+
+template <int Cols, int Rows>
+constexpr SpriteFrameTable<Cols * Rows> SpriteSheet<Cols, Rows>::TABLE;
+
+// The same for sheets whose size is only known at run time (tilesets read
+// with a level). The table is built once, up front.
+class RuntimeSpriteSheet
+{
+private:
+    int m_frame_count = 0;
+    std::vector<SpriteFrame> m_frames;
+    std::vector<float> m_tex_coords;
+
+public:
+    RuntimeSpriteSheet(int cols, int rows) : m_frame_count(cols * rows), m_frames(cols * rows), m_tex_coords(cols * rows * SPRITE_QUAD_FLOATS)
+    {
+        assert(cols > 0 && rows > 0);
+        for (int index = 0; index < m_frame_count; index++)
+        {
+            SpriteFrame& frame = m_frames[index];
+            frame.u = (float) (index % cols) / (float) cols;
+            frame.v = (float) (index / cols) / (float) rows;
+            frame.width = (float) (index % cols + 1) / (float) cols - frame.u;
+            frame.height = (float) (index / cols + 1) / (float) rows - frame.v;
+            write_sprite_quad(frame, &m_tex_coords[index * SPRITE_QUAD_FLOATS]);
+        }
+    };
+
+    const SpriteFrame& frame(int index) const { assert(index >= 0 && index < m_frame_count); return m_frames[index]; };
+    const float* tex_coords(int index) const { assert(index >= 0 && index < m_frame_count); return &m_tex_coords[index * SPRITE_QUAD_FLOATS]; };
+
+    AnimationClip clip(int first, int count, float frames_per_second) const
+    {
+        assert(first >= 0 && count > 0 && first + count <= m_frame_count);
+        return { first, count, frames_per_second };
+    };
+
+    int const get_frame_count() const { return m_frame_count; };
+};
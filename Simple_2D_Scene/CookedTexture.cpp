@@ -0,0 +1,102 @@
+#include "CookedTexture.h"
+#include <sys/stat.h>
+#ifdef _WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+std::string cooked_texture_path(const std::string& source_path)
+{
+    size_t dot = source_path.find_last_of('.');
+    size_t slash = source_path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return source_path + COOKED_TEXTURE_EXTENSION;
+    return source_path.substr(0, dot) + COOKED_TEXTURE_EXTENSION;
+}
+
+static bool map_file(const std::string& path, CookedTexture& texture)
+{
+#ifdef _WINDOWS
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    HANDLE mapping = GetFileSizeEx(file, &size) ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    void* view = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (view == NULL)
+    {
+        if (mapping != NULL) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    texture.data = (const unsigned char*) view;
+    texture.size = (size_t) size.QuadPart;
+    texture.file_handle = file;
+    texture.mapping_handle = mapping;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file == -1) return false;
+
+    struct stat info;
+    void* view = fstat(file, &info) == 0 && info.st_size > 0 ? mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+    close(file);
+    if (view == MAP_FAILED) return false;
+
+    texture.data = (const unsigned char*) view;
+    texture.size = (size_t) info.st_size;
+#endif
+    return true;
+}
+
+static bool is_valid(const CookedTexture& texture)
+{
+    if (texture.size < sizeof(CookedTextureHeader)) return false;
+
+    const CookedTextureHeader* header = (const CookedTextureHeader*) texture.data;
+    if (header->magic != COOKED_TEXTURE_MAGIC || header->version != COOKED_TEXTURE_VERSION) return false;
+    if (header->format > COOKED_BC3 || header->width == 0 || header->height == 0) return false;
+    if (header->level_count == 0 || header->level_count > (unsigned int) COOKED_TEXTURE_MAX_LEVELS) return false;
+
+    for (unsigned int level = 0; level < header->level_count; level++)
+    {
+        if ((size_t) header->level_offset[level] + header->level_size[level] > texture.size) return false;
+    }
+    return true;
+}
+
+bool cooked_texture_open(const std::string& source_path, CookedTexture& texture)
+{
+    std::string path = cooked_texture_path(source_path);
+
+    // A source edited after cooking wins; the stale cooked file is ignored
+    struct stat cooked_info, source_info;
+    if (stat(path.c_str(), &cooked_info) != 0) return false;
+    if (stat(source_path.c_str(), &source_info) == 0 && source_info.st_mtime > cooked_info.st_mtime) return false;
+
+    if (!map_file(path, texture)) return false;
+    if (!is_valid(texture))
+    {
+        cooked_texture_close(texture);
+        return false;
+    }
+
+    texture.header = (const CookedTextureHeader*) texture.data;
+    return true;
+}
+
+void cooked_texture_close(CookedTexture& texture)
+{
+    if (texture.data == NULL) return;
+
+#ifdef _WINDOWS
+    UnmapViewOfFile(texture.data);
+    CloseHandle((HANDLE) texture.mapping_handle);
+    CloseHandle((HANDLE) texture.file_handle);
+#else
+    munmap((void*) texture.data, texture.size);
+#endif
+    texture = CookedTexture();
+}
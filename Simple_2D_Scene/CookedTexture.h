@@ -0,0 +1,53 @@
+#pragma once
+#include <stddef.h>
+#include <string>
+
+// Container written by Texture_Cooker: a fixed header followed by every mip
+// level, ready to hand to glTexImage2D / glCompressedTexImage2D as it is. The
+// file is memory-mapped at runtime, so nothing is decoded or converted.
+
+const unsigned int COOKED_TEXTURE_MAGIC = 0x58455443;   // "CTEX"
+const unsigned int COOKED_TEXTURE_VERSION = 1;
+const int COOKED_TEXTURE_MAX_LEVELS = 16;
+const size_t COOKED_TEXTURE_ALIGNMENT = 16;              // every level starts on this boundary
+const char COOKED_TEXTURE_EXTENSION[] = ".ctex";
+
+enum CookedTextureFormat
+{
+    COOKED_RGBA8 = 0,
+    COOKED_BC1   = 1,     // S3TC DXT1, opaque
+    COOKED_BC3   = 2      // S3TC DXT5, with alpha
+};
+
+const unsigned int COOKED_PREMULTIPLIED = 1 << 0;
+
+struct CookedTextureHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int format;
+    unsigned int flags;
+    unsigned int width;
+    unsigned int height;
+    unsigned int level_count;
+    unsigned int padding;
+    unsigned int level_offset[COOKED_TEXTURE_MAX_LEVELS];   // from the start of the file
+    unsigned int level_size[COOKED_TEXTURE_MAX_LEVELS];
+};
+
+// A mapped .ctex file; only valid between cooked_texture_open and _close
+struct CookedTexture
+{
+    const CookedTextureHeader* header = NULL;
+    const unsigned char*       data = NULL;     // start of the file
+    size_t                     size = 0;
+    void*                      file_handle = NULL;
+    void*                      mapping_handle = NULL;
+};
+
+// "sprites/ship.png" -> "sprites/ship.ctex"
+std::string cooked_texture_path(const std::string& source_path);
+// Maps the cooked version of `source_path` if there is one that is at least
+// as new as the source and passes validation
+bool cooked_texture_open(const std::string& source_path, CookedTexture& texture);
+void cooked_texture_close(CookedTexture& texture);
@@ -0,0 +1,87 @@
+#include "FramePacer.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+void FramePacer::start(SwapMode swap_mode, float target_fps)
+{
+    m_frequency = SDL_GetPerformanceFrequency();
+    m_target_fps = target_fps;
+    set_swap_mode(swap_mode);
+    m_deadline = SDL_GetPerformanceCounter();
+}
+
+void FramePacer::set_swap_mode(SwapMode swap_mode)
+{
+    if (SDL_GL_SetSwapInterval(swap_mode) == 0)
+    {
+        m_swap_mode = swap_mode;
+        return;
+    }
+
+    if (swap_mode == SWAP_ADAPTIVE && SDL_GL_SetSwapInterval(SWAP_VSYNC) == 0)
+    {
+        std::cout << "Adaptive vsync not supported, using vsync" << std::endl;
+        m_swap_mode = SWAP_VSYNC;
+        return;
+    }
+
+    std::cout << "Unable to set swap interval: " << SDL_GetError() << std::endl;
+    m_swap_mode = (SwapMode) SDL_GL_GetSwapInterval();
+}
+
+void FramePacer::wait(SDL_Window* window)
+{
+    Uint32 flags = SDL_GetWindowFlags(window);
+    m_hidden = (flags & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN)) != 0;
+
+    // Swaps don't block while the window can't be seen, so a hidden window
+    // is paced here even with vsync on
+    float fps = m_target_fps;
+    if (m_hidden && (fps <= 0.0f || fps > FRAME_PACER_HIDDEN_FPS)) fps = FRAME_PACER_HIDDEN_FPS;
+
+    m_frames++;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (fps <= 0.0f)
+    {
+        m_deadline = now;
+        return;
+    }
+
+    Uint64 period = (Uint64) (m_frequency / fps);
+    m_deadline += period;
+
+    // More than a frame behind (a hitch, or the rate just changed): start over
+    // from now rather than rushing through frames to catch up
+    if (now > m_deadline + period || m_deadline > now + period)
+    {
+        m_deadline = now + period;
+    }
+    if (now >= m_deadline) return;
+
+    Uint64 spin = (Uint64) (m_frequency * FRAME_PACER_SPIN_SECONDS);
+    Uint64 start = now;
+    while (now + spin < m_deadline)
+    {
+        Uint32 milliseconds = (Uint32) ((m_deadline - now - spin) * 1000 / m_frequency);
+        SDL_Delay(milliseconds > 0 ? milliseconds : 1);
+        now = SDL_GetPerformanceCounter();
+    }
+    while (now < m_deadline) now = SDL_GetPerformanceCounter();
+
+    m_wait_counts += now - start;
+}
+
+void parse_frame_pacing_arguments(int argc, char* argv[], SwapMode* swap_mode, float* target_fps)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--fps") == 0) *target_fps = (float) atof(argv[i + 1]);
+        if (strcmp(argv[i], "--vsync") == 0)
+        {
+            if (strcmp(argv[i + 1], "off") == 0) *swap_mode = SWAP_IMMEDIATE;
+            else if (strcmp(argv[i + 1], "adaptive") == 0) *swap_mode = SWAP_ADAPTIVE;
+            else *swap_mode = SWAP_VSYNC;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <SDL.h>
+
+// Values for SDL_GL_SetSwapInterval
+enum SwapMode { SWAP_ADAPTIVE = -1, SWAP_IMMEDIATE = 0, SWAP_VSYNC = 1 };
+
+const float FRAME_PACER_HIDDEN_FPS = 10.0f;     // while minimized or hidden
+const float FRAME_PACER_SPIN_SECONDS = 0.002f;  // end of each wait is spun, since sleeps overshoot
+
+// Caps the main loop at a target rate. wait() goes at the end of every frame:
+// it sleeps for most of what's left of the frame and spins the last stretch
+// on the performance counter, so frames end on time without a core pegged at
+// 100%. Deadlines advance by a whole period each frame, so the rate holds
+// even when individual frames vary. When the window is minimized or hidden
+// the loop drops to FRAME_PACER_HIDDEN_FPS whatever the settings.
+class FramePacer
+{
+private:
+    Uint64   m_frequency = 1;
+    Uint64   m_deadline = 0;
+    float    m_target_fps = 0.0f;     // 0 = uncapped
+    SwapMode m_swap_mode = SWAP_VSYNC;
+    bool     m_hidden = false;
+
+    // ————— STATS ————— //
+    Uint64 m_wait_counts = 0;
+    int    m_frames = 0;
+
+public:
+    // Needs the GL context current; applies the swap mode
+    void start(SwapMode swap_mode, float target_fps);
+    // Blocks until the current frame's time is up
+    void wait(SDL_Window* window);
+
+    // Adaptive vsync isn't supported everywhere; falls back to regular vsync
+    void set_swap_mode(SwapMode swap_mode);
+    void set_target_fps(float target_fps) { m_target_fps = target_fps; };
+
+    SwapMode const get_swap_mode()  const { return m_swap_mode; };
+    float    const get_target_fps() const { return m_target_fps; };
+    bool     const is_hidden()      const { return m_hidden; };
+    // Average time spent waiting per frame since the last reset
+    float    const get_wait_ms()    const { return m_frames > 0 ? (float) (m_wait_counts * 1000.0 / m_frequency / m_frames) : 0.0f; };
+    void     reset_stats() { m_wait_counts = 0; m_frames = 0; };
+};
+
+// Reads --fps N and --vsync off|on|adaptive from the command line
+void parse_frame_pacing_arguments(int argc, char* argv[], SwapMode* swap_mode, float* target_fps);
@@ -0,0 +1,61 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <stddef.h>
+
+const int GL_STATE_TEXTURE_UNITS = 8;
+const int GL_STATE_ATTRIBUTES = 16;
+
+// Shadow copy of the GL state the game touches. Every bind, enable and
+// uniform upload goes through here, and calls that wouldn't change anything
+// are dropped and counted. The cache starts out matching a fresh context, so
+// anything that changes this state with raw GL calls has to call forget().
+// Attribute enables belong to the bound vertex array: set_attributes() tracks
+// the default one, which is all the legacy path uses; core-profile VAOs carry
+// their own enables and are only ever bound through bind_vertex_array().
+class GLState
+{
+private:
+    GLuint       m_program = 0;
+    GLuint       m_vertex_array = 0;
+    int          m_active_unit = 0;
+    GLuint       m_textures[GL_STATE_TEXTURE_UNITS] = {};
+    unsigned int m_attributes = 0;      // bit n set = attribute location n enabled
+    bool         m_blend = false;
+    GLenum       m_blend_source = GL_ONE;
+    GLenum       m_blend_destination = GL_ZERO;
+
+    // ————— STATS ————— //
+    int m_issued = 0;
+    int m_skipped = 0;
+
+public:
+    void use_program(GLuint program);
+    void bind_texture(GLuint texture, int unit = 0);
+    void bind_vertex_array(GLuint vertex_array);
+    // Enables exactly the attribute locations in `mask` and disables the rest
+    void set_attributes(unsigned int mask);
+    void set_blend(bool enabled);
+    void set_blend_function(GLenum source, GLenum destination);
+
+    // Compares `value` with the last value uploaded to this uniform. Returns
+    // true (and remembers it) when it differs and has to be sent.
+    bool uniform_changed(void* cached, bool& cached_valid, const void* value, size_t bytes);
+
+    void forget();
+
+    int  const get_issued_calls()  const { return m_issued;  };
+    int  const get_skipped_calls() const { return m_skipped; };
+    void reset_counters() { m_issued = 0; m_skipped = 0; };
+};
+
+extern GLState g_gl_state;
+
+inline unsigned int attribute_bit(GLint location)
+{
+    return location >= 0 && location < GL_STATE_ATTRIBUTES ? 1u << location : 0u;
+}
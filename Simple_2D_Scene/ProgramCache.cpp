@@ -0,0 +1,150 @@
+#include "ProgramCache.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#ifdef _WINDOWS
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+const unsigned int PROGRAM_CACHE_MAGIC = 0x48435053;   // "SPCH"
+
+struct ProgramCacheHeader
+{
+    unsigned int       magic;
+    unsigned int       format;      // driver-specific binary format enum
+    unsigned long long key;
+    unsigned int       length;
+    unsigned int       padding;
+};
+
+static unsigned long long fnv1a(unsigned long long hash, const char* data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char) data[i];
+        hash *= 1099511628211ull;
+    }
+    // Separator, so "ab" + "c" and "a" + "bc" don't collide
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+    return hash;
+}
+
+static std::string cache_path(unsigned long long key)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/%016llx.bin", key);
+    return std::string(PROGRAM_CACHE_DIRECTORY) + name;
+}
+
+bool program_cache_supported()
+{
+    static int supported = -1;
+    if (supported == -1)
+    {
+        GLint formats = 0;
+        if (SDL_GL_ExtensionSupported("GL_ARB_get_program_binary")) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        supported = formats > 0;
+    }
+    return supported == 1;
+}
+
+unsigned long long program_cache_key(const std::string& vertex_source, const std::string& fragment_source)
+{
+    const char* driver[] = {
+        (const char*) glGetString(GL_VENDOR),
+        (const char*) glGetString(GL_RENDERER),
+        (const char*) glGetString(GL_VERSION)
+    };
+
+    unsigned long long hash = 14695981039346656037ull;
+    hash = fnv1a(hash, vertex_source.data(), vertex_source.size());
+    hash = fnv1a(hash, fragment_source.data(), fragment_source.size());
+    for (const char* text : driver)
+    {
+        if (text != NULL) hash = fnv1a(hash, text, strlen(text));
+    }
+    return hash;
+}
+
+GLuint program_cache_load(unsigned long long key)
+{
+    if (!program_cache_supported()) return 0;
+
+    std::string path = cache_path(key);
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL) return 0;
+
+    ProgramCacheHeader header;
+    std::vector<char> binary;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+        && header.magic == PROGRAM_CACHE_MAGIC && header.key == key && header.length > 0;
+    if (valid)
+    {
+        binary.resize(header.length);
+        valid = fread(binary.data(), 1, header.length, file) == header.length;
+    }
+    fclose(file);
+
+    GLuint program = 0;
+    if (valid)
+    {
+        program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), (GLsizei) header.length);
+
+        GLint link_success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &link_success);
+        if (link_success == GL_FALSE)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    // Truncated, foreign or rejected by the driver: drop it so the rebuild replaces it
+    if (program == 0) remove(path.c_str());
+    return program;
+}
+
+void program_cache_save(unsigned long long key, GLuint program)
+{
+    if (!program_cache_supported()) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    ProgramCacheHeader header;
+    header.magic = PROGRAM_CACHE_MAGIC;
+    header.key = key;
+    header.padding = 0;
+
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+    header.format = format;
+    header.length = (unsigned int) written;
+
+#ifdef _WINDOWS
+    _mkdir(PROGRAM_CACHE_DIRECTORY);
+#else
+    mkdir(PROGRAM_CACHE_DIRECTORY, 0755);
+#endif
+
+    // Write under a temporary name first so a crash never leaves half an entry behind
+    std::string path = cache_path(key);
+    std::string temporary_path = path + ".tmp";
+    FILE* file = fopen(temporary_path.c_str(), "wb");
+    if (file == NULL) return;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(binary.data(), 1, header.length, file) == header.length;
+    fclose(file);
+
+    remove(path.c_str());
+    if (!ok || rename(temporary_path.c_str(), path.c_str()) != 0) remove(temporary_path.c_str());
+}
@@ -12,6 +12,12 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
 #include "stb_image.h"
+#include "TextureLoader.h"
+#include "FramePacer.h"
+#include "FrameTimeRecorder.h"
+#include "FixedTimestep.h"
+#include "Profiler.h"
+#include "RenderStats.h"
 
 #define LOG(argument) std::cout << argument << '\n'
 
@@ -27,12 +33,8 @@ VIEWPORT_HEIGHT = WINDOW_HEIGHT;
 const char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
 F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
 
-const float MILLISECONDS_IN_SECOND = 1000.0;
 const float DEGREES_PER_SECOND = 90.0f;
-
-const int NUMBER_OF_TEXTURES = 1; // to be generated, that is
-const GLint LEVEL_OF_DETAIL = 0;  // base image level; Level n is the nth mipmap reduction image
-const GLint TEXTURE_BORDER = 0;   // this value MUST be zero
+const float STATS_OVERLAY_UNITS_PER_TEXEL = 2.0f * 10.0f / WINDOW_WIDTH;   //two screen pixels per texel
 
 //filepaths for assets
 const char OMORI_SPRITE_FILEPATH[] = "assets/sunny.png";     //1200 x 1200
@@ -46,54 +48,31 @@ GLuint g_omori_texture_id;
 GLuint g_box_texture_id;
 GLuint g_cat_texture_id;
 GLuint g_hand_texture_id;
+TextureLoader g_texture_loader; //decodes on worker threads, uploads a little each frame
+RenderStatsOverlay g_stats_overlay; //F3 or --stats-overlay
 
 SDL_Window* g_display_window;
 bool g_game_is_running = true; //tracks whether game is running
+FramePacer g_frame_pacer;      //caps the frame rate, slows right down while minimized
+FrameTimeRecorder g_frame_recorder;    //frame time percentiles and hitches, reported at exit
+const char* g_frame_report_path = NULL;     //--frame-report FILE; no report without it
 
 ShaderProgram g_shader_program; //shader program
 glm::mat4 view_matrix, g_projection_matrix;
 //model matrices of assets use
 glm::mat4 g_omori_model_matrix, g_box_model_matrix, g_cat_model_matrix, g_hand_model_matrix, g_hand2_model_matrix;
 
-float g_previous_ticks = 0.0f; //used for delta time calculation
+FixedTimestep g_timestep;      //turns real time into fixed simulation steps
 float angle = 0.0f;            //keeps track of rotation
 float blackout_timer = 0.0f;   //keeps track of background change interval
+float g_omori_angle = 0.0f;    //omori's spin, once it starts
+float g_previous_angle = 0.0f, g_previous_blackout_timer = 0.0f, g_previous_omori_angle = 0.0f; //state before the last step, for interpolation
 bool blackout = false;         //keeps track of whether background change should occur
 bool black_out_before = false; //whether background change has occured before
 
 glm::vec3 g_cat_pos = glm::vec3(0.0f, 0.0f, 0.0f); //keeps track of cat position
 glm::vec3 g_hand_pos = glm::vec3(0.0f, 0.0f, 0.0f);//keeps track of hand position
 
-//FUNCTION PROFESSOR WROTE IN CLASS
-GLuint load_texture(const char* filepath)
-{
-    // STEP 1: Loading the image file
-    int width, height, number_of_components;
-    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
-
-    if (image == NULL)
-    {
-        LOG("Unable to load image. Make sure the path is correct.");
-        LOG(filepath);
-        assert(false);
-    }
-
-    // STEP 2: Generating and binding a texture ID to our image
-    GLuint textureID;
-    glGenTextures(NUMBER_OF_TEXTURES, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, image);
-
-    // STEP 3: Setting our texture filter parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    // STEP 4: Releasing our file from memory and returning our texture id
-    stbi_image_free(image);
-
-    return textureID;
-}
-
 void initialise()
 {
     // Initialise video and joystick subsystems
@@ -113,7 +92,8 @@ void initialise()
 
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
 
-    g_shader_program.load(V_SHADER_PATH, F_SHADER_PATH);
+    // The program compiles while the textures start decoding
+    g_shader_program.start_load(V_SHADER_PATH, F_SHADER_PATH);
 
     g_omori_model_matrix = glm::mat4(1.0f);
     g_box_model_matrix = glm::mat4(1.0f);
@@ -122,28 +102,32 @@ void initialise()
     g_hand2_model_matrix = glm::mat4(1.0f);
     view_matrix = glm::mat4(1.0f);  // Defines the position (location and orientation) of the camera
     g_projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);  // Defines the characteristics of your camera, such as clip planes, field of view, projection method etc.
+    g_stats_overlay.create();
+
+    //starts loading textures based on filepath; they show up over the first few frames
+    g_texture_loader.start();
+    g_omori_texture_id = g_texture_loader.load(OMORI_SPRITE_FILEPATH);
+    g_box_texture_id = g_texture_loader.load(BOX_SPRITE_FILEPATH);
+    g_cat_texture_id = g_texture_loader.load(CAT_SPRITE_FILEPATH);
+    g_hand_texture_id = g_texture_loader.load(HAND_SPRITE_FILEPATH);
 
+    g_shader_program.finish_load();
     g_shader_program.set_projection_matrix(g_projection_matrix);
     g_shader_program.set_view_matrix(view_matrix);
     // Notice we haven't set our model matrix yet!
 
-    glUseProgram(g_shader_program.get_program_id());
+    g_gl_state.use_program(g_shader_program.get_program_id());
 
     glClearColor(255.0f, 255.0f, 255.0f, 1.0f); //sets background to white by default
 
-    //loads textures based on filepath
-    g_omori_texture_id = load_texture(OMORI_SPRITE_FILEPATH);
-    g_box_texture_id = load_texture(BOX_SPRITE_FILEPATH);
-    g_cat_texture_id = load_texture(CAT_SPRITE_FILEPATH);
-    g_hand_texture_id = load_texture(HAND_SPRITE_FILEPATH);
-
     // enable blending
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    g_gl_state.set_blend(true);
+    g_gl_state.set_blend_function(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void process_input()
 {
+    PROFILE_SCOPE("process_input");
 
     SDL_Event event;
 
@@ -154,18 +138,18 @@ void process_input()
         case SDL_QUIT:
             g_game_is_running = false;
             break;
+        case SDL_KEYDOWN:
+            if (event.key.keysym.sym == SDLK_F3) g_stats_overlay.toggle();
+            break;
         default:
             break;
         }
     }
 }
 
-void update()
+//advances the scene by one fixed step
+void simulate(float delta_time)
 {
-    float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND; // get the current number of ticks
-    float delta_time = ticks - g_previous_ticks; // the delta time is the difference from the last frame
-    g_previous_ticks = ticks; 
-
     angle += delta_time;
     //if (angle >= 6.3f) angle = angle - 6.2830f; couldnt get this to work naturally, we just assume the app won't be open long enough to cause overflow
     //and that if overflow occurs, the program won't break
@@ -190,17 +174,28 @@ void update()
         }
     }
 
+    if (black_out_before) { //omori stats spinning after first blackout
+        g_omori_angle += 2.0f * delta_time;
+    }
+}
+
+//builds the model matrices from the state part way between the last two steps
+void update_transforms(float alpha)
+{
+    float draw_angle = g_previous_angle + (angle - g_previous_angle) * alpha;
+    float draw_omori_angle = g_previous_omori_angle + (g_omori_angle - g_previous_omori_angle) * alpha;
+    //the timer jumps back to 0 when the background flips; that's not something to blend across
+    float draw_blackout_timer = blackout_timer < g_previous_blackout_timer ? blackout_timer
+        : g_previous_blackout_timer + (blackout_timer - g_previous_blackout_timer) * alpha;
+
     float radius = 3.0f;
-    g_cat_pos.x = sin(angle) * radius;
-    g_cat_pos.y = cos(angle) * radius; //cat spins around, so we use sine and cosine
+    g_cat_pos.x = sin(draw_angle) * radius;
+    g_cat_pos.y = cos(draw_angle) * radius; //cat spins around, so we use sine and cosine
 
     g_cat_model_matrix = glm::mat4(1.0f);
     g_cat_model_matrix = glm::translate(g_cat_model_matrix, g_cat_pos); //translates cat based on position on circle
 
-    if (black_out_before) { //omori stats spinning after first blackout
-        g_omori_model_matrix = glm::rotate(g_omori_model_matrix, 2.0f * delta_time, glm::vec3(0.0f, 0.0f, 1.0f));
-    }
-    
+    g_omori_model_matrix = glm::rotate(glm::mat4(1.0f), draw_omori_angle, glm::vec3(0.0f, 0.0f, 1.0f));
 
     g_box_model_matrix = glm::mat4(1.0f);
     glm::vec3 box_position = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -214,7 +209,7 @@ void update()
     float LEFT_MAX = -4.0f;
     float RIGHT_MAX = 4.0f;
     float VERT_DISP = 2.0f;
-    g_hand_pos.x = RIGHT_MAX - (RIGHT_MAX - LEFT_MAX) * blackout_timer / 3.0f; //x goes from right to left
+    g_hand_pos.x = RIGHT_MAX - (RIGHT_MAX - LEFT_MAX) * draw_blackout_timer / 3.0f; //x goes from right to left
     g_hand_pos.y = sin(g_hand_pos.x) * VERT_DISP; //y is sinosiodal based on x
 
     g_hand_model_matrix = glm::mat4(1.0f); 
@@ -227,15 +222,53 @@ void update()
     g_hand2_model_matrix = glm::translate(g_hand_model_matrix, hand2_relative_pos); //use translation relative to first hand
 }
 
+void update()
+{
+    PROFILE_SCOPE("update");
+    //the scene always moves in steps of FIXED_TIMESTEP, however fast frames come
+    int steps = g_timestep.advance();
+    for (int i = 0; i < steps; i++) {
+        g_previous_angle = angle;
+        g_previous_omori_angle = g_omori_angle;
+        g_previous_blackout_timer = blackout_timer;
+        simulate(g_timestep.get_step());
+    }
+
+    update_transforms(g_timestep.get_alpha());
+}
+
 //FUNCTION PROFESSOR USED IN EXAMPLE
 void draw_object(glm::mat4& object_model_matrix, GLuint& object_texture_id)
 {
     g_shader_program.set_model_matrix(object_model_matrix);
-    glBindTexture(GL_TEXTURE_2D, object_texture_id);
+    g_gl_state.bind_texture(object_texture_id);
     glDrawArrays(GL_TRIANGLES, 0, 6); // we are now drawing 2 triangles, so we use 6 instead of 3
+    g_render_stats.count_client_draw(GL_TRIANGLES, 6, 4 * sizeof(float));
+}
+
+//the render stats in the top-left corner, over everything else
+void draw_stats_overlay()
+{
+    float vertices[] = { -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f };
+    float texture_coordinates[] = { 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f };
+
+    g_stats_overlay.update(g_render_stats.get_last_frame());
+
+    glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
+    glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, texture_coordinates);
+    g_gl_state.set_attributes(g_shader_program.get_attribute_mask());
+
+    g_shader_program.set_model_matrix(g_stats_overlay.get_model_matrix(-5.0f, 3.75f, STATS_OVERLAY_UNITS_PER_TEXEL));
+    g_gl_state.bind_texture(g_stats_overlay.get_texture_id());
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    g_render_stats.count_client_draw(GL_TRIANGLES, 6, 4 * sizeof(float));
 }
 
 void render() {
+    PROFILE_SCOPE("render");
+    PROFILE_GPU_SCOPE("render");
+    g_texture_loader.update();
+
     glClear(GL_COLOR_BUFFER_BIT);
     if (!blackout){
     //declare vertices based on dimension of image
@@ -260,10 +293,8 @@ void render() {
     };
 
     glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, box_vertices);
-    glEnableVertexAttribArray(g_shader_program.get_position_attribute());
-
     glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, box_texture_coordinates);
-    glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+    g_gl_state.set_attributes(g_shader_program.get_attribute_mask());
 
     draw_object(g_box_model_matrix, g_box_texture_id); //draws box
 
@@ -278,10 +309,8 @@ void render() {
     };
 
     glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(g_shader_program.get_position_attribute());
-
     glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, texture_coordinates);
-    glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+    g_gl_state.set_attributes(g_shader_program.get_attribute_mask());
 
     draw_object(g_omori_model_matrix, g_omori_texture_id); //draws omori
 
@@ -309,10 +338,8 @@ void render() {
     };
 
     glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, cat_vertices);
-    glEnableVertexAttribArray(g_shader_program.get_position_attribute());
-
     glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, cat_texture_coordinates);
-    glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+    g_gl_state.set_attributes(g_shader_program.get_attribute_mask());
 
     draw_object(g_cat_model_matrix, g_cat_texture_id); //draws cat
     
@@ -337,10 +364,8 @@ void render() {
 
 
     glVertexAttribPointer(g_shader_program.get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(g_shader_program.get_position_attribute());
-
     glVertexAttribPointer(g_shader_program.get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, texture_coordinates);
-    glEnableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+    g_gl_state.set_attributes(g_shader_program.get_attribute_mask());
 
     draw_object(g_hand_model_matrix, g_hand_texture_id); //draws hand1
 
@@ -349,15 +374,25 @@ void render() {
     draw_object(g_hand2_model_matrix, g_hand_texture_id); //draws hand2
     }
 
-    // We disable two attribute arrays now
-    glDisableVertexAttribArray(g_shader_program.get_position_attribute());
-    glDisableVertexAttribArray(g_shader_program.get_tex_coordinate_attribute());
+    if (g_stats_overlay.is_visible()) draw_stats_overlay();
+
+    g_render_stats.end_frame();
+}
 
+//swaps separately from render() so the GPU scope ends before the frame goes out
+void present()
+{
+    PROFILE_SCOPE("swap");
     SDL_GL_SwapWindow(g_display_window);
+    g_profiler.end_gpu_frame();
 }
 
 void shutdown()
 {
+    g_texture_loader.stop();
+    if (g_frame_report_path != NULL) g_frame_recorder.write_report(g_frame_report_path);
+    g_frame_recorder.print_summary();
+    g_profiler.stop();
     SDL_Quit();
 }
 
@@ -372,13 +407,41 @@ int main(int argc, char* argv[])
 * Academic Misconduct.
 **/
 {
+    SwapMode swap_mode = SWAP_VSYNC;
+    float target_fps = 0.0f;   //0 = as fast as the swap mode allows
+    parse_frame_pacing_arguments(argc, argv, &swap_mode, &target_fps);
+
+    //--trace FILE writes a Chrome trace of the whole run at exit
+    g_profiler.start(parse_trace_argument(argc, argv));
+    g_profiler.set_thread_name("Main");
+
+    //--render-stats FILE logs every frame's GL workload as CSV, and reports how long the textures took
+    const char* render_stats_path = NULL;
+    bool stats_overlay = false;
+    parse_render_stats_arguments(argc, argv, &render_stats_path, &stats_overlay);
+    if (render_stats_path != NULL) g_render_stats.open_csv(render_stats_path);
+    g_texture_loader.set_report_timing(render_stats_path != NULL);
+    g_stats_overlay.set_visible(stats_overlay);
+
+    //--frame-report FILE writes the frame time report at exit; --hitch-ms N moves the hitch budget
+    float hitch_budget_ms = FRAME_HITCH_BUDGET_MS;
+    parse_frame_report_arguments(argc, argv, &g_frame_report_path, &hitch_budget_ms);
+
     initialise();
+    g_profiler.start_gpu();
+    g_frame_pacer.start(swap_mode, target_fps);
+    g_timestep.start();
+    g_frame_recorder.start(hitch_budget_ms);
 
     while (g_game_is_running)
     {
         process_input();
         update();
         render();
+        present();
+        g_profiler.end_frame();
+        g_frame_recorder.end_frame(g_frame_pacer.is_hidden());
+        g_frame_pacer.wait(g_display_window);
     }
 
     shutdown();
@@ -0,0 +1,372 @@
+// Offline texture cooker: turns a PNG/JPG into a .ctex that the games can
+// memory-map and upload without decoding. Resizes to the size the sprite is
+// actually drawn at, builds the mip chain, and optionally compresses to S3TC.
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "CookedTexture.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG(argument) std::cout << argument << '\n'
+
+struct CookSettings
+{
+    const char* input = NULL;
+    const char* output = NULL;      // defaults to the input with the .ctex extension
+    int   width = 0;                // 0 keeps the source size (or follows the other axis)
+    int   height = 0;
+    int   max_size = 0;             // clamp the longer side, keeping the aspect ratio
+    bool  mips = true;
+    bool  premultiply = false;
+    const char* format = "rgba";    // rgba, bc1, bc3 or auto
+};
+
+// Premultiplied RGBA floats; filtering in this space keeps transparent
+// pixels' colour from bleeding into the edges of a sprite
+struct Image
+{
+    int width, height;
+    std::vector<float> pixels;
+};
+
+// ————— RESAMPLING ————— //
+
+// Box filter with fractional coverage along one axis: every output sample is
+// the average of the source span it covers. Good for the downscales a cooker
+// does, and exact for the 2:1 steps of a mip chain.
+static void resample_axis(const float* source, int source_count, int source_stride, float* target, int target_count, int target_stride)
+{
+    float scale = (float) source_count / target_count;
+
+    for (int i = 0; i < target_count; i++)
+    {
+        float start = i * scale;
+        float end = start + scale;
+        float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float total = 0.0f;
+
+        for (int s = (int) start; s < source_count && s < end; s++)
+        {
+            float weight = std::min(end, (float) s + 1.0f) - std::max(start, (float) s);
+            if (weight <= 0.0f) continue;
+            for (int c = 0; c < 4; c++) sum[c] += source[s * source_stride + c] * weight;
+            total += weight;
+        }
+
+        for (int c = 0; c < 4; c++) target[i * target_stride + c] = total > 0.0f ? sum[c] / total : 0.0f;
+    }
+}
+
+static Image resize(const Image& source, int width, int height)
+{
+    if (source.width == width && source.height == height) return source;
+
+    Image horizontal = { width, source.height, std::vector<float>((size_t) width * source.height * 4) };
+    for (int y = 0; y < source.height; y++)
+    {
+        resample_axis(&source.pixels[(size_t) y * source.width * 4], source.width, 4, &horizontal.pixels[(size_t) y * width * 4], width, 4);
+    }
+
+    Image result = { width, height, std::vector<float>((size_t) width * height * 4) };
+    for (int x = 0; x < width; x++)
+    {
+        resample_axis(&horizontal.pixels[(size_t) x * 4], source.height, width * 4, &result.pixels[(size_t) x * 4], height, width * 4);
+    }
+    return result;
+}
+
+// ————— ENCODING ————— //
+
+static unsigned char to_byte(float value)
+{
+    return (unsigned char) std::min(255.0f, std::max(0.0f, value * 255.0f + 0.5f));
+}
+
+static std::vector<unsigned char> to_rgba8(const Image& image, bool premultiplied)
+{
+    std::vector<unsigned char> bytes((size_t) image.width * image.height * 4);
+
+    for (size_t i = 0; i < bytes.size(); i += 4)
+    {
+        const float* pixel = &image.pixels[i];
+        float alpha = pixel[3];
+        float unpremultiply = premultiplied || alpha <= 0.0f ? 1.0f : 1.0f / alpha;
+
+        bytes[i + 0] = to_byte(pixel[0] * unpremultiply);
+        bytes[i + 1] = to_byte(pixel[1] * unpremultiply);
+        bytes[i + 2] = to_byte(pixel[2] * unpremultiply);
+        bytes[i + 3] = to_byte(alpha);
+    }
+    return bytes;
+}
+
+static unsigned short to_565(const unsigned char* colour)
+{
+    return (unsigned short) (((colour[0] * 31 + 127) / 255) << 11 | ((colour[1] * 63 + 127) / 255) << 5 | ((colour[2] * 31 + 127) / 255));
+}
+
+static void from_565(unsigned short packed, int* colour)
+{
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    colour[0] = (r << 3) | (r >> 2);
+    colour[1] = (g << 2) | (g >> 4);
+    colour[2] = (b << 3) | (b >> 2);
+}
+
+// Four-colour S3TC block from the corners of the block's colour bounding box
+static void encode_colour_block(const unsigned char block[16][4], unsigned char* out)
+{
+    unsigned char low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            low[c] = std::min(low[c], block[i][c]);
+            high[c] = std::max(high[c], block[i][c]);
+        }
+    }
+
+    // Pull the ends in a little; the box corners are rarely the best fit
+    for (int c = 0; c < 3; c++)
+    {
+        int inset = (high[c] - low[c]) / 16;
+        high[c] -= inset;
+        low[c] += inset;
+    }
+
+    unsigned short colour0 = to_565(high), colour1 = to_565(low);
+    if (colour0 < colour1) std::swap(colour0, colour1);
+
+    int palette[4][3];
+    from_565(colour0, palette[0]);
+    from_565(colour1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    unsigned int indices = 0;
+    if (colour0 != colour1)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, best_distance = 1 << 30;
+            for (int p = 0; p < 4; p++)
+            {
+                int distance = 0;
+                for (int c = 0; c < 3; c++) distance += (block[i][c] - palette[p][c]) * (block[i][c] - palette[p][c]);
+                if (distance < best_distance) { best = p; best_distance = distance; }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+
+    out[0] = colour0 & 0xFF; out[1] = colour0 >> 8;
+    out[2] = colour1 & 0xFF; out[3] = colour1 >> 8;
+    for (int i = 0; i < 4; i++) out[4 + i] = (indices >> (i * 8)) & 0xFF;
+}
+
+// Eight-value interpolated alpha block (BC3)
+static void encode_alpha_block(const unsigned char block[16][4], unsigned char* out)
+{
+    unsigned char alpha0 = 0, alpha1 = 255;
+    for (int i = 0; i < 16; i++)
+    {
+        alpha0 = std::max(alpha0, block[i][3]);
+        alpha1 = std::min(alpha1, block[i][3]);
+    }
+
+    int palette[8] = { alpha0, alpha1 };
+    for (int p = 1; p < 7; p++) palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+
+    unsigned long long indices = 0;
+    if (alpha0 != alpha1)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, best_distance = 256;
+            for (int p = 0; p < 8; p++)
+            {
+                int distance = abs(block[i][3] - palette[p]);
+                if (distance < best_distance) { best = p; best_distance = distance; }
+            }
+            indices |= (unsigned long long) best << (i * 3);
+        }
+    }
+
+    out[0] = alpha0;
+    out[1] = alpha1;
+    for (int i = 0; i < 6; i++) out[2 + i] = (indices >> (i * 8)) & 0xFF;
+}
+
+static std::vector<unsigned char> to_s3tc(const std::vector<unsigned char>& rgba, int width, int height, bool with_alpha)
+{
+    int blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    int block_bytes = with_alpha ? 16 : 8;
+    std::vector<unsigned char> out((size_t) blocks_x * blocks_y * block_bytes);
+
+    for (int by = 0; by < blocks_y; by++)
+    {
+        for (int bx = 0; bx < blocks_x; bx++)
+        {
+            // Edge blocks repeat the last row/column
+            unsigned char block[16][4];
+            for (int i = 0; i < 16; i++)
+            {
+                int x = std::min(bx * 4 + i % 4, width - 1), y = std::min(by * 4 + i / 4, height - 1);
+                memcpy(block[i], &rgba[((size_t) y * width + x) * 4], 4);
+            }
+
+            unsigned char* write = &out[((size_t) by * blocks_x + bx) * block_bytes];
+            if (with_alpha)
+            {
+                encode_alpha_block(block, write);
+                write += 8;
+            }
+            encode_colour_block(block, write);
+        }
+    }
+    return out;
+}
+
+// ————— MAIN ————— //
+
+static void print_usage()
+{
+    LOG("usage: texture_cooker [--size W H] [--max-size N] [--format rgba|bc1|bc3|auto]");
+    LOG("                      [--premultiply] [--no-mips] [-o OUTPUT] INPUT");
+    LOG("  --size       pixel size the sprite is drawn at on screen; 0 follows the aspect ratio");
+    LOG("  --format     auto picks bc1 for opaque images and bc3 otherwise");
+    LOG("  --premultiply  store premultiplied alpha, for blending with GL_ONE, GL_ONE_MINUS_SRC_ALPHA");
+}
+
+int main(int argc, char* argv[])
+{
+    CookSettings settings;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(argv[i], "--size") == 0 && i + 2 < argc) { settings.width = atoi(argv[i + 1]); settings.height = atoi(argv[i + 2]); i += 2; }
+        else if (strcmp(argv[i], "--max-size") == 0 && has_value) settings.max_size = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--format") == 0 && has_value) settings.format = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && has_value) settings.output = argv[++i];
+        else if (strcmp(argv[i], "--premultiply") == 0) settings.premultiply = true;
+        else if (strcmp(argv[i], "--no-mips") == 0) settings.mips = false;
+        else if (argv[i][0] != '-' && settings.input == NULL) settings.input = argv[i];
+        else { print_usage(); return 1; }
+    }
+    if (settings.input == NULL) { print_usage(); return 1; }
+
+    int width, height, number_of_components;
+    unsigned char* source = stbi_load(settings.input, &width, &height, &number_of_components, STBI_rgb_alpha);
+    if (source == NULL)
+    {
+        LOG("Unable to load " << settings.input << ": " << stbi_failure_reason());
+        return 1;
+    }
+
+    Image image = { width, height, std::vector<float>((size_t) width * height * 4) };
+    bool opaque = true;
+    for (size_t i = 0; i < image.pixels.size(); i += 4)
+    {
+        float alpha = source[i + 3] / 255.0f;
+        for (int c = 0; c < 3; c++) image.pixels[i + c] = source[i + c] / 255.0f * alpha;
+        image.pixels[i + 3] = alpha;
+        if (source[i + 3] != 255) opaque = false;
+    }
+    stbi_image_free(source);
+
+    // Target size: explicit, or the other axis follows the aspect ratio, then clamped
+    int target_width = settings.width > 0 ? settings.width : width;
+    int target_height = settings.height > 0 ? settings.height : height;
+    if (settings.width > 0 && settings.height <= 0) target_height = std::max(1, (int) lroundf((float) height * settings.width / width));
+    if (settings.height > 0 && settings.width <= 0) target_width = std::max(1, (int) lroundf((float) width * settings.height / height));
+    // Never upscale; that only costs memory and adds no detail
+    if (target_width > width || target_height > height)
+    {
+        float scale = std::min((float) width / target_width, (float) height / target_height);
+        target_width = std::max(1, (int) lroundf(target_width * scale));
+        target_height = std::max(1, (int) lroundf(target_height * scale));
+    }
+    if (settings.max_size > 0 && std::max(target_width, target_height) > settings.max_size)
+    {
+        float scale = (float) settings.max_size / std::max(target_width, target_height);
+        target_width = std::max(1, (int) lroundf(target_width * scale));
+        target_height = std::max(1, (int) lroundf(target_height * scale));
+    }
+
+    CookedTextureFormat format;
+    if (strcmp(settings.format, "rgba") == 0) format = COOKED_RGBA8;
+    else if (strcmp(settings.format, "bc1") == 0) format = COOKED_BC1;
+    else if (strcmp(settings.format, "bc3") == 0) format = COOKED_BC3;
+    else if (strcmp(settings.format, "auto") == 0) format = opaque ? COOKED_BC1 : COOKED_BC3;
+    else { print_usage(); return 1; }
+
+    if (format == COOKED_BC1 && !opaque) LOG("warning: " << settings.input << " has alpha that bc1 will drop");
+
+    // ————— LEVELS ————— //
+    std::vector<std::vector<unsigned char>> levels;
+    Image level = resize(image, target_width, target_height);
+    while (true)
+    {
+        std::vector<unsigned char> rgba = to_rgba8(level, settings.premultiply);
+        if (format == COOKED_RGBA8) levels.push_back(rgba);
+        else levels.push_back(to_s3tc(rgba, level.width, level.height, format == COOKED_BC3));
+
+        if (!settings.mips || (level.width == 1 && level.height == 1) || (int) levels.size() == COOKED_TEXTURE_MAX_LEVELS) break;
+        level = resize(level, std::max(1, level.width / 2), std::max(1, level.height / 2));
+    }
+
+    // ————— WRITE ————— //
+    CookedTextureHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = COOKED_TEXTURE_MAGIC;
+    header.version = COOKED_TEXTURE_VERSION;
+    header.format = format;
+    header.flags = settings.premultiply ? COOKED_PREMULTIPLIED : 0;
+    header.width = target_width;
+    header.height = target_height;
+    header.level_count = (unsigned int) levels.size();
+
+    size_t offset = sizeof(header);
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        offset = (offset + COOKED_TEXTURE_ALIGNMENT - 1) & ~(COOKED_TEXTURE_ALIGNMENT - 1);
+        header.level_offset[i] = (unsigned int) offset;
+        header.level_size[i] = (unsigned int) levels[i].size();
+        offset += levels[i].size();
+    }
+
+    std::string output = settings.output != NULL ? settings.output : cooked_texture_path(settings.input);
+    FILE* file = fopen(output.c_str(), "wb");
+    if (file == NULL)
+    {
+        LOG("Unable to write " << output);
+        return 1;
+    }
+
+    fwrite(&header, sizeof(header), 1, file);
+    const unsigned char zeros[COOKED_TEXTURE_ALIGNMENT] = {};
+    size_t written = sizeof(header);
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        fwrite(zeros, 1, header.level_offset[i] - written, file);
+        fwrite(levels[i].data(), 1, levels[i].size(), file);
+        written = header.level_offset[i] + levels[i].size();
+    }
+    fclose(file);
+
+    const char* format_names[] = { "rgba", "bc1", "bc3" };
+    LOG(settings.input << " " << width << "x" << height << " -> " << output << " " << target_width << "x" << target_height
+        << " " << format_names[format] << ", " << levels.size() << " levels, " << written / 1024 << " KiB"
+        << " (was " << (size_t) width * height * 4 / 1024 << " KiB decoded)");
+    return 0;
+}